@@ -36,6 +36,36 @@
 #include <util/atomic.h> //for ATOMIC_BLOCK macro (source: http://www.nongnu.org/avr-libc/user-manual/group__util__atomic.html)
 
 volatile irparams_t irparams; //MUST be volatile since it is used both inside and outside ISRs
+irecho_t irecho; //frames we sent recently; see IRLibRData.h
+
+#ifdef IRLIB_STATS
+volatile irstats_t irstats; //see IRLib.h
+//the IRrecv ISR watches the pin while paused to count the frames it drops; see statsPausedTick
+static bool Stats_Paused_Mark;
+static uint16_t Stats_Paused_Space; //ticks
+static unsigned long Stats_Last_Edge; //us; IRrecvPCI, last edge including those ignored while paused
+
+void IRstats_snapshot(irstats_t *copy) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for(uint8_t i=0; i<sizeof(irstats_t); i++)
+      ((uint8_t *)copy)[i] = ((volatile uint8_t *)&irstats)[i];
+  }
+}
+
+void IRstats_clear(void) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for(uint8_t i=0; i<sizeof(irstats_t); i++)
+      ((volatile uint8_t *)&irstats)[i] = 0;
+  }
+}
+
+static inline void IRstats_ISRDone(irstats_clock_t start) {
+  uint16_t Cycles = (irstats_clock_t)(IRLIB_STATS_CLOCK() - start) * IRLIB_STATS_CYCLES_PER_CLOCK;
+  if(Cycles > irstats.maxISRCycles) irstats.maxISRCycles = Cycles;
+}
+#endif
 
 /*
  * Returns a pointer to a flash stored string that is the name of the protocol received. 
@@ -48,6 +78,44 @@ const __FlashStringHelper *Pnames(IR_types_t Type) {
 };
 
 
+void IRpayload::clear(void) {
+  low=0; length=0;
+  memset(ext,0,sizeof(ext));
+}
+
+void IRpayload::set(uint64_t data, uint8_t nbits) {
+  clear();
+  if(nbits>64) nbits=64;
+  low= (nbits<64)? data & (((uint64_t)1<<nbits)-1): data;
+  length=nbits;
+}
+
+void IRpayload::shiftIn(bool bit) {
+  if(length>=64) { //only long frames pay for the array
+    uint8_t Carry=low>>63;
+    for(int8_t i=sizeof(ext)-1; i>=0; i--) {
+      uint8_t Next=ext[i]>>7;
+      ext[i]=(ext[i]<<1) | Carry;
+      Carry=Next;
+    }
+  }
+  low=(low<<1) | bit;
+  if(length<IR_PAYLOAD_BITS) length++;
+}
+
+uint8_t IRpayload::byteAt(uint8_t n) const {
+  if(n<8) {
+    uint32_t Half= (n<4)? (uint32_t)low: (uint32_t)(low>>32); //avoids a variable 64-bit shift
+    return Half>>(8*(n & 3));
+  }
+  n-=8;
+  return (n<sizeof(ext))? ext[sizeof(ext)-1-n]: 0;
+}
+
+bool IRpayload::bitAt(uint16_t n) const {
+  return (byteAt(n>>3)>>(n & 7)) & 1;
+}
+
 #define TOPBIT 0x80000000
 
 /*
@@ -73,20 +141,30 @@ const __FlashStringHelper *Pnames(IR_types_t Type) {
 void IRsendBase::sendGeneric(unsigned long data, unsigned char Num_Bits, unsigned int Head_Mark, unsigned int Head_Space, 
                              unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero, 
 							 unsigned char kHz, bool Use_Stop, unsigned long Max_Extent) {
+  IRpayload Data;
+  Data.set(data, Num_Bits);
+  sendGeneric(Data, Head_Mark, Head_Space, Mark_One, Mark_Zero, Space_One, Space_Zero, kHz, Use_Stop, Max_Extent);
+}
+
+//Same as above for frames of any length up to IR_PAYLOAD_BITS. The bits go out most significant first.
+void IRsendBase::sendGeneric(const IRpayload &data, unsigned int Head_Mark, unsigned int Head_Space, 
+                             unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero, 
+							 unsigned char kHz, bool Use_Stop, unsigned long Max_Extent) {
+  uint8_t Byte=0;
   Extent=0;
-  data = data << (32 - Num_Bits);
   enableIROut(kHz);
 //Some protocols do not send a header when sending repeat codes. So we pass a zero value to indicate skipping this.
   if(Head_Mark) mark(Head_Mark); 
   if(Head_Space) space(Head_Space);
-  for (int i = 0; i <Num_Bits; i++) {
-    if (data & TOPBIT) {
+  for (int i = data.length-1; i >= 0; i--) {
+    //fetch a byte at a time so that long payloads cost no more per bit than short ones
+    if ((i & 7)==7 || i==data.length-1) Byte=data.byteAt(i>>3);
+    if (Byte & (1<<(i & 7))) {
       mark(Mark_One);  space(Space_One);
     } 
     else {
       mark(Mark_Zero);  space(Space_Zero);
     }
-    data <<= 1;
   }
   if(Use_Stop) mark(Mark_One);   //stop bit of "1"
   if(Max_Extent) {
@@ -178,6 +256,7 @@ void IRsendRaw::send(unsigned int buf[], unsigned char len, unsigned char hz)
 
 //Panasonic part is a copy from https://github.com/cyborg5/IRLib/pull/15/commits/a0929cef76391a7035c97368c3ba611ec22aa190
 void IRsendPanasonic::PutBits (unsigned long data, int nbits){  
+  data <<= 32 - nbits; //the low nbits of data, most significant first
   for (int i = 0; i < nbits; i++) {  
      if (data & 0x80000000) {  
        mark(432);  space(1296);  
@@ -195,12 +274,13 @@ void IRsendPanasonic::send(unsigned long data) {
   // Send the header  
   mark(3456); space(1728);  
 
-  // Send Panasonic identifier  
-  PutBits (2,8);  
-  PutBits (32,8);  
+  // Send Panasonic identifier 0x2002; the bytes go out least significant bit first  
+  PutBits (0x40,8);  
+  PutBits (0x04,8);  
 
-  // Send the device, sub-device and function  
-  PutBits (data, 24);//Send 12 bits  
+  // Send the device, sub-device and function; only the low 24 bits of data go out  
+  data &= 0xFFFFFF;  
+  PutBits (data, 24);//Send 24 bits  
 
   // Send the checksum  
   int checksum = 0;  
@@ -300,7 +380,7 @@ void IRsend::send(IR_types_t Type, unsigned long data, unsigned int data2, bool
     case PANASONIC_OLD: IRsendPanasonic_Old::send(data); break;
     case NECX:          IRsendNECx::send(data); break;    
     case JVC:           IRsendJVC::send(data,(bool)data2); break;
-    case PANASONIC      IRsendPanasonic::send(data); break;
+    case PANASONIC_NEW: IRsendPanasonic::send(data); break;
     case SAMSUNG32:     IRsendSamsung32::send(data); break;
     
   //case ADDITIONAL:    IRsendADDITIONAL::send(data); break;//add additional protocols here
@@ -308,6 +388,43 @@ void IRsend::send(IR_types_t Type, unsigned long data, unsigned int data2, bool
   }
 }
 
+void IRsend::send(IR_types_t Type, const IRfields &fields, unsigned int data2, bool autoRepeatSend) {
+  if(Type==SONY && !data2) data2= fields.subAddress? 20: fields.address>0x1F? 15: 12;
+  if(Type==RC6 && !data2) data2=20;
+  if(Type==JVC) data2=!fields.repeat;
+  send(Type, IRjoinFields(Type,fields,data2), data2, autoRepeatSend);
+}
+
+/*
+ * Pulse programs let any of the senders above build a frame in memory rather than transmit it.
+ * IRsendMulti uses them to drive several emitters at once. The lower section of this file
+ * has the hardware specific playback code.
+ */
+IRpulseProgram::IRpulseProgram(uint16_t *buffer, uint16_t bufferSize) {
+  durations=buffer; size=bufferSize;
+  clear();
+}
+
+void IRpulseProgram::clear(void) {
+  length=0; khz=0; overflow=false;
+}
+
+void IRpulseProgram::add(bool isMark, unsigned int usec) {
+  if(length==0 && !isMark) return; //leading space is just idle time
+  if(length && isMark==!((length-1) & 1)) { //same kind as the last entry
+    unsigned long sum=(unsigned long)durations[length-1]+usec;
+    durations[length-1]= (sum>0xFFFF) ? 0xFFFF : sum;
+    return;
+  }
+  if(length>=size) {overflow=true; return;}
+  durations[length++]=usec;
+}
+
+void IRsendBase::record(IRpulseProgram *program) {
+  Recording=program;
+  if(program) program->clear();
+}
+
 /*
  * The irparams definitions which were located here have been moved to IRLibRData.h
  */
@@ -323,6 +440,16 @@ IRdecodeBase::IRdecodeBase(void) {
   irparams.rawbuf2 = this->rawbuf = irparams.rawbuf1;
   
   ignoreHeader=false;
+  checks=0;
+  checkFailures=0;
+  reset();
+};
+
+IRdecodeBase::IRdecodeBase(volatile uint16_t *buffer) {
+  rawbuf = buffer;
+  ignoreHeader=false;
+  checks=0;
+  checkFailures=0;
   reset();
 };
 
@@ -368,7 +495,10 @@ void IRdecodeBase::reset(void) {
   decode_type= UNKNOWN;
   value=0;
   bits=0;
+  payload.clear();
   rawlen=0;
+  carrier=0;
+  memset(&fields,0,sizeof(fields));
 };
 #ifndef USE_DUMP
 void DumpUnavailable(void) {Serial.println(F("dumpResults unavailable"));}
@@ -428,11 +558,21 @@ void IRdecodeBase::dumpResults(void) {
  * we assume that the length of Mark varies and the value passed as "Space_Zero" is ignored.
  * When using variable length Mark, assumes Head_Space==Space_One. If it doesn't, you need a specialized decoder.
  */
-bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
+//Adds bit number n of a frame. The first 32 go into an unsigned long, which AVR shifts in a few
+//instructions; only the bits of a longer frame go through the 64-bit shift of payload.
+static inline void IRgenericBit(unsigned long &data, uint16_t n, IRpayload &payload, bool bit) {
+  if(n<32) {data=(data<<1) | bit; return;}
+  if(n==32) {payload.low=data; payload.length=32;}
+  payload.shiftIn(bit);
+}
+
+bool IRdecodeBase::decodeGeneric(uint16_t Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
                                  unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero) {
 // If raw samples count or head mark are zero then don't perform these tests.
 // Some protocols need to do custom header work.
-  unsigned long data = 0;  unsigned char Max; offset=1;
+  uint16_t Max, N=0; offset=1;
+  unsigned long Data=0;
+  payload.clear();
   if (Raw_Count) {if (rawlen != Raw_Count) return RAW_COUNT_ERROR;}
   if(!ignoreHeader) {
     if (Head_Mark) {
@@ -449,10 +589,10 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
       if (!MATCH(rawbuf[offset], Space_One)) return DATA_SPACE_ERROR(Space_One);
       offset++;
       if (MATCH(rawbuf[offset], Mark_One)) {
-        data = (data << 1) | 1;
+        IRgenericBit(Data, N++, payload, 1);
       } 
       else if (MATCH(rawbuf[offset], Mark_Zero)) {
-        data <<= 1;
+        IRgenericBit(Data, N++, payload, 0);
       } 
       else return DATA_MARK_ERROR(Mark_Zero);
       offset++;
@@ -466,10 +606,10 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
       if (!MATCH (rawbuf[offset],Mark_Zero)) return DATA_MARK_ERROR(Mark_Zero);
       offset++;
       if (MATCH(rawbuf[offset],Space_One)) {
-        data = (data << 1) | 1;
+        IRgenericBit(Data, N++, payload, 1);
       } 
       else if (MATCH (rawbuf[offset],Space_Zero)) {
-        data <<= 1;
+        IRgenericBit(Data, N++, payload, 0);
       } 
       else return DATA_SPACE_ERROR(Space_Zero);
       offset++;
@@ -477,7 +617,8 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
     bits = (offset - 1) / 2 -1;//didn't encode stop bit
   }
   // Success
-  value = data;
+  if (N<=32) {payload.low=Data; payload.length=N;}
+  value = (uint32_t)payload.low;
   return true;
 }
 
@@ -492,20 +633,173 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
  * protocols you don't use.
  * Note: Don't forget to call IRrecvBase::resume(); after decoding is complete.
  */
+//counts the attempts and successes of each protocol in irstats; see IRLIB_STATS in IRLib.h
+#ifdef IRLIB_STATS
+#define IRLIB_DECODE_COUNTED(type,call) (irstats.decodeAttempts[type]++, (call) ? (irstats.decodeSuccesses[type]++, true) : false)
+#else
+#define IRLIB_DECODE_COUNTED(type,call) (call)
+#endif
+bool IRdecodeBase::checkFailed(void) {
+  checkFailures++;
+  return INTEGRITY_ERROR;
+}
+
+//a and b are complements of each other in the bits of mask
+static inline bool IRcomplements(unsigned long a, unsigned long b, unsigned long mask) {
+  return ((a^b) & mask)==mask;
+}
+
+/* Splitting value into fields. Most protocols send their fields least significant bit first,
+ * so they come out of value reversed. A byte is reversed a nibble at a time from a 16 entry
+ * table, which is a lot quicker than a bit by bit loop and takes 16 bytes of flash.
+ */
+static const uint8_t IRreversedNibbles[16] PROGMEM = {
+  0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+uint8_t IRreverse(uint8_t data, uint8_t nbits) {
+  uint8_t Reversed= (pgm_read_byte(&IRreversedNibbles[data & 0x0F])<<4) | pgm_read_byte(&IRreversedNibbles[data>>4]);
+  return Reversed>>(8-nbits); //the bits of data above nbits end up below and are dropped
+}
+
+void IRsplitFields(IR_types_t type, unsigned long value, uint8_t bits, IRfields *fields) {
+  memset(fields,0,sizeof(IRfields));
+  switch(type) {
+    case NEC:
+      if(value==REPEAT) {fields->repeat=true; break;}
+      //no break; the address is 8 bits if the second address byte is its complement
+    case NECX:
+    case SAMSUNG32:
+      fields->address=IRreverse(value>>24);
+      fields->command=IRreverse(value>>8);
+      if(type==SAMSUNG32) break;
+      if(type==NECX || !IRcomplements(value>>24, value>>16, 0xFF)) {
+        fields->address|=(uint16_t)IRreverse(value>>16)<<8;
+        fields->extended=true;
+      }
+      break;
+    case SONY:
+      //7 bit command, then the address: 5 bits, 8 bits, or 5 bits and 8 more for 20 bit codes
+      if(bits<8 || bits>20) break;
+      fields->command=IRreverse(value>>(bits-7), 7);
+      if(bits==20) {
+        fields->address=IRreverse(value>>8, 5);
+        fields->subAddress=IRreverse(value);
+      }
+      else fields->address=IRreverse(value, bits-7);
+      break;
+    case RC5:
+      //field bit (inverted 7th command bit), toggle, 5 bit address, 6 bit command
+      fields->toggle=(value>>11) & 1;
+      fields->address=(value>>6) & 0x1F;
+      fields->command=(value & 0x3F) | (((value>>12) & 1)? 0: 0x40);
+      break;
+    case RC6:
+      //3 mode bits, the trailer bit as toggle, then address and command
+      if(bits>=4 && bits<=32) fields->toggle=(value>>(bits-4)) & 1;
+      fields->address=(value>>8) & 0xFF;
+      fields->command=value & 0xFF;
+      break;
+    case PANASONIC_OLD:
+      fields->address=IRreverse(value>>17, 5);
+      fields->command=IRreverse(value>>11, 6);
+      break;
+    case JVC:
+      fields->address=IRreverse(value>>8);
+      fields->command=IRreverse(value);
+      break;
+    case PANASONIC_NEW:
+      fields->address=IRreverse(value>>16);
+      fields->subAddress=IRreverse(value>>8);
+      fields->command=IRreverse(value);
+      break;
+  }
+}
+
+unsigned long IRjoinFields(IR_types_t type, const IRfields &fields, uint8_t bits) {
+  uint8_t Address=fields.address;
+  switch(type) {
+    case NEC:
+      if(fields.repeat) return REPEAT;
+      //no break
+    case NECX:
+    case SAMSUNG32: {
+      uint8_t High= type==SAMSUNG32? Address: (type==NECX || fields.extended)? fields.address>>8: ~Address;
+      return ((unsigned long)IRreverse(Address)<<24) | ((unsigned long)IRreverse(High)<<16)
+        | ((unsigned long)IRreverse(fields.command)<<8) | IRreverse(~fields.command);
+    }
+    case SONY:
+      if(bits<8 || bits>20) return 0;
+      if(bits==20) return ((unsigned long)IRreverse(fields.command,7)<<13)
+        | ((unsigned long)IRreverse(Address,5)<<8) | IRreverse(fields.subAddress);
+      return ((unsigned long)IRreverse(fields.command,7)<<(bits-7)) | IRreverse(Address,bits-7);
+    case RC5:
+      return ((fields.command & 0x40)? 0: 0x1000UL) | (fields.toggle? 0x800UL: 0)
+        | ((unsigned long)(Address & 0x1F)<<6) | (fields.command & 0x3F);
+    case RC6:
+      return ((bits>=4 && bits<=32 && fields.toggle)? 1UL<<(bits-4): 0)
+        | ((unsigned long)Address<<8) | fields.command;
+    case PANASONIC_OLD:
+      return ((unsigned long)IRreverse(Address,5)<<17) | ((unsigned long)IRreverse(fields.command,6)<<11)
+        | ((unsigned long)IRreverse(~Address,5)<<6) | IRreverse(~fields.command,6);
+    case JVC:
+      return ((unsigned long)IRreverse(Address)<<8) | IRreverse(fields.command);
+    case PANASONIC_NEW:
+      return ((unsigned long)IRreverse(Address)<<16) | ((unsigned long)IRreverse(fields.subAddress)<<8)
+        | IRreverse(fields.command);
+  }
+  return 0;
+}
+
+/* The carrier each protocol is sent at, in kHz, as the IRsend classes use it. With a
+ * measured carrier in IRdecodeBase::carrier, IRdecode::decode first tries only the protocols
+ * whose carrier is within IR_CARRIER_TOLERANCE. That saves the other decode attempts, and a
+ * frame whose timings fit two protocols goes to the one sent at the carrier measured. The
+ * others are still tried if none of those takes the frame, for a remote that is off nominal.
+ */
+static const uint8_t IRcarriers[LAST_PROTOCOL+1] PROGMEM = {
+  0,  //UNKNOWN
+  38, //NEC
+  40, //SONY
+  36, //RC5
+  36, //RC6
+  57, //PANASONIC_OLD
+  38, //JVC
+  38, //NECX
+  37, //PANASONIC_NEW
+  38, //SAMSUNG32
+  0   //HASH_CODE
+};
+
+unsigned char IRcarrier(IR_types_t type) {
+  return type<=LAST_PROTOCOL? pgm_read_byte(&IRcarriers[type]): 0;
+}
+
+bool IRdecodeBase::carrierFits(IR_types_t type) {
+  if(!carrier) return true;
+  unsigned char Nominal=IRcarrier(type);
+  return Nominal+IR_CARRIER_TOLERANCE>=carrier && carrier+IR_CARRIER_TOLERANCE>=Nominal;
+}
+
 bool IRdecode::decode(void) {
   /*
   GS: Important Note on why I'm NOT USING ATOMIC GUARDS: *technically*, when using a double buffer (see IRLibRData.h for buffer info, to know what a double buffer is) this whole section should be protected with atomic access guards, since we are reading the decoder rawbuf, which points to the volatile irparams.rawbuf1, which is modified periodically by the ISR as follows: whenever a complete new IR code comes in, if double-buffered, the ISR automatically copies its data from irparams.rawbuf2 to rawbuf1, so it can be decoded *while IR receiving continues.* *However,* if you read rawbuf during decoding and it is simultaneously updated by the ISR, you could be reading erroneous or corrupted information. However, this is actually fine in this case, since we are only *reading,* NOT writing. The worst that would happen is the corrupted rawbuf would not be recognized as a valid IR code, or it would be recognized as the wrong code. This can happen during normal receiving anyway, as IR codes are easily distorted during open-air transmission, and sunlight creates a lot of noise. The user's main sketch will simply ignore bad IR codes. Problem solved. 
   -So, WHY NOT PROTECT THIS CODE SEGMENT WITH ATOMIC BLOCK GUARDS? Answer: decoding is waaay too slow! It takes so much time to decode through all of the below code types, that you'd be blocking interrupts for *thousands* or even *tens of thousands* of microseconds, which would totally corrupt any ISR routines and time-stamps anyway! Blocking interrupts for any longer than a few dozen microseconds at most is *bad*! Ex: IRdecodeNEC::decode() alone takes ~2984us. I measured it. If the code being received is one of the lower options, you are looking at it taking up to a couple dozen *milli*seconds. So, just leave the below code alone, and don't protect this particular code. Chances are, in all actuality, that one IR code will be fully decoded long before another IR code arrives anyway, and you will *never* really be at risk of reading rawbuf while rawbuf is being updated by the ISR at the same time. So, I will NOT protect the below code with atomic access guards (ex: via the ATOMIC_BLOCK macro).
   */
-  if (IRdecodeNEC::decode()) return true;
-  if (IRdecodeSony::decode()) return true;
-  if (IRdecodeRC5::decode()) return true;
-  if (IRdecodeRC6::decode()) return true;
-  if (IRdecodePanasonic_Old::decode()) return true;
-  if (IRdecodeNECx::decode()) return true;
-  if (IRdecodeJVC::decode()) return true;
-  if (IRdecodePanasonic::decode()) return true;
-  if (IRdecodeSamsung32::decode()) return true;
+  //first the protocols sent at the measured carrier, then, if none took the frame, the rest
+  for (uint8_t Pass=0; Pass<2; Pass++) {
+    bool Fits=!Pass;
+    if (carrierFits(NEC)==Fits && IRLIB_DECODE_COUNTED(NEC, IRdecodeNEC::decode())) return true;
+    if (carrierFits(SONY)==Fits && IRLIB_DECODE_COUNTED(SONY, IRdecodeSony::decode())) return true;
+    if (carrierFits(RC5)==Fits && IRLIB_DECODE_COUNTED(RC5, IRdecodeRC5::decode())) return true;
+    if (carrierFits(RC6)==Fits && IRLIB_DECODE_COUNTED(RC6, IRdecodeRC6::decode())) return true;
+    if (carrierFits(PANASONIC_OLD)==Fits && IRLIB_DECODE_COUNTED(PANASONIC_OLD, IRdecodePanasonic_Old::decode())) return true;
+    if (carrierFits(NECX)==Fits && IRLIB_DECODE_COUNTED(NECX, IRdecodeNECx::decode())) return true;
+    if (carrierFits(JVC)==Fits && IRLIB_DECODE_COUNTED(JVC, IRdecodeJVC::decode())) return true;
+    if (carrierFits(PANASONIC_NEW)==Fits && IRLIB_DECODE_COUNTED(PANASONIC_NEW, IRdecodePanasonic::decode())) return true;
+    if (carrierFits(SAMSUNG32)==Fits && IRLIB_DECODE_COUNTED(SAMSUNG32, IRdecodeSamsung32::decode())) return true;
+    if (!carrier) break; //every protocol fits, and has been tried
+  }
   
 //if (IRdecodeADDITIONAL::decode()) return true;//add additional protocols here
 //Deliberately did not add hash code decoding. If you get decode_type==UNKNOWN and
@@ -514,21 +808,48 @@ bool IRdecode::decode(void) {
   return false;
 }
 
+IRdecodeFrame::IRdecodeFrame(void): IRdecodeBase(Buffer) {}
+
+IRdecodeResult IRdecodeFrame::decodeFrame(const uint16_t *durations, uint16_t count) {
+  IRdecodeResult Result;
+  reset();
+  if(count>RAWBUF) count=RAWBUF;
+  memcpy(Buffer,durations,count*sizeof(uint16_t));
+  rawlen=count;
+  if(decode()) {
+    Result.decode_type=decode_type;
+    Result.value=value;
+    Result.bits=bits;
+    Result.payload=payload;
+    Result.fields=fields;
+  } else {
+    Result.decode_type=UNKNOWN;
+    Result.value=0;
+    Result.bits=0;
+    Result.fields=fields;
+  }
+  return Result;
+}
+
 #define NEC_RPT_SPACE	2250 //562.5*4
 //Source for info on protocol timing: https://techdocs.altium.com/display/FPGA/NEC+Infrared+Transmission+Protocol
 //562.5us is the base time--the time upon which other times are based 
 bool IRdecodeNEC::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("NEC"));
+  IRLIB_ATTEMPT(NEC, F("NEC"));
   // Check for repeat
   if (rawlen == 4 && MATCH(rawbuf[2], NEC_RPT_SPACE) &&
     MATCH(rawbuf[3],563)) {
     bits = 0;
     value = REPEAT;
+    IRsplitFields(NEC,value,bits,&fields);
     decode_type = NEC;
     return true;
   }
   //                68  ~9000   ~4500  0  563 ~1687.5 563
   if(!decodeGeneric(68, 563*16, 563*8, 0, 563, 563*3, 563)) return false;
+  if((checks & IR_CHECK_NEC_COMMAND) && !IRcomplements(value>>8, value, 0xFF)) return checkFailed();
+  if((checks & IR_CHECK_NEC_ADDRESS) && !IRcomplements(value>>24, value>>16, 0xFF)) return checkFailed();
+  IRsplitFields(NEC,value,bits,&fields);
   decode_type = NEC;
   return true;
 }
@@ -536,10 +857,11 @@ bool IRdecodeNEC::decode(void) {
 // According to http://www.hifi-remote.com/johnsfine/DecodeIR.html#Sony8 
 // Sony protocol can only be 8, 12, 15, or 20 bits in length.
 bool IRdecodeSony::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("Sony"));
+  IRLIB_ATTEMPT(SONY, F("Sony"));
   if(rawlen!=2*8+2 && rawlen!=2*12+2 && rawlen!=2*15+2 && rawlen!=2*20+2) return RAW_COUNT_ERROR;
   //                0  2400   600  1200   600  600  0
   if(!decodeGeneric(0, 600*4, 600, 600*2, 600, 600, 0)) return false;
+  IRsplitFields(SONY,value,bits,&fields);
   decode_type = SONY;
   return true;
 }
@@ -567,41 +889,38 @@ bool IRdecodeSony::decode(void) {
  * The "+" at the end means you only need to send it once and it can repeat as many times as you want.
  */
 bool IRdecodePanasonic_Old::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("Panasonic_Old"));
+  IRLIB_ATTEMPT(PANASONIC_OLD, F("Panasonic_Old"));
   //                48  3332   3332   0  833  2499   833 
   if(!decodeGeneric(48, 833*4, 833*4, 0, 833, 833*3, 833)) return false;
   /*
    * The protocol spec says that the first 11 bits described the device and function.
    * The next 11 bits are the same thing only it is the logical Bitwise complement.
-   * Many protocols have such check features in their definition but our code typically doesn't
-   * perform these checks. For example NEC's least significant 8 bits are the complement of 
-   * of the next more significant 8 bits. While it's probably not necessary to error check this, 
-   * you can un-comment the next 4 lines of code to do this extra checking.
+   * Set IR_CHECK_PANASONIC_OLD in checks to have that checked.
    */
-//  long S1= (value & 0x0007ff);       // 00 0000 0000 0111 1111 1111 //00000 000000 11111 111111
-//  long S2= (value & 0x3ff800)>> 11;  // 11 1111 1111 1000 0000 0000 //11111 111111 00000 000000
-//  S2= (~S2) & 0x0007ff;
-//  if (S1!=S2) return IRLIB_REJECTION_MESSAGE(F("inverted bit redundancy"));
+  if((checks & IR_CHECK_PANASONIC_OLD) && !IRcomplements(value>>11, value, 0x7FF)) return checkFailed();
   // Success
+  IRsplitFields(PANASONIC_OLD,value,bits,&fields);
   decode_type = PANASONIC_OLD;
   return true;
 }
 
 bool IRdecodeNECx::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("NECx"));
+  IRLIB_ATTEMPT(NECX, F("NECx"));
   //                68  ~4500  ~4500  0  563 ~1687.5 563
   if(!decodeGeneric(68, 563*8, 563*8, 0, 563, 563*3, 563)) return false;
+  if((checks & IR_CHECK_NEC_COMMAND) && !IRcomplements(value>>8, value, 0xFF)) return checkFailed();
+  IRsplitFields(NECX,value,bits,&fields);
   decode_type = NECX;
   return true;
 }
 
 // JVC does not send any header if there is a repeat.
 bool IRdecodeJVC::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("JVC"));
+  IRLIB_ATTEMPT(JVC, F("JVC"));
   //                36  8400    4200   0  525  1575   525 
   if(!decodeGeneric(36, 525*16, 525*8, 0, 525, 525*3, 525)) 
   {
-     IRLIB_ATTEMPT_MESSAGE(F("JVC Repeat"));
+     IRLIB_ATTEMPT(JVC, F("JVC Repeat"));
      if (rawlen==34) 
      {
         //                0  525  0  0  525  1575   525 
@@ -619,9 +938,12 @@ bool IRdecodeJVC::decode(void) {
            }
         }
         bits++;
+        payload.set(value,bits);
      }
      else return RAW_COUNT_ERROR;
   } 
+  IRsplitFields(JVC,value,bits,&fields);
+  fields.repeat= rawlen==34; //the frame without a header
   decode_type =JVC;
   return true;
 }
@@ -639,7 +961,7 @@ bool IRdecodePanasonic::GetBit(void) {
   };  
     
   bool IRdecodePanasonic::decode(void) {  
-    IRLIB_ATTEMPT_MESSAGE(F("Panasonic"));  
+    IRLIB_ATTEMPT(PANASONIC_NEW, F("Panasonic"));  
     if (rawlen != 100) return RAW_COUNT_ERROR;  
     
     // This handles the lead-in or header  
@@ -652,20 +974,30 @@ bool IRdecodePanasonic::GetBit(void) {
     while (offset < 2*8*2+2) if (!GetBit()) return false;  
     // Check if this is 0100000000000100 or 0x4004 in hex  
     if (data != 0x4004) return IRLIB_DATA_ERROR_MESSAGE(F("Error identifying Panasonic"),offset,rawbuf[offset],0x4004);  
+    data = 0; //value is only the 24 bits that follow  
     
     // save the next 24 bits to value  
     while(offset < 5*8*2+2) if (!GetBit()) return false;  
     value = data; data = 0;  
+    bits = 24; payload.set(value,bits);
+    // The last byte is the XOR of the three bytes of value
+    if (checks & IR_CHECK_PANASONIC) {
+      while(offset < 6*8*2+2) if (!GetBit()) return false;
+      if (data != ((value ^ (value>>8) ^ (value>>16)) & 0xFF)) return checkFailed();
+    }
     
+    IRsplitFields(PANASONIC_NEW,value,bits,&fields);
     decode_type = PANASONIC_NEW;  
     return true;  
   };  
 
 bool IRdecodeSamsung32::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("PANASONIC32"));
+  IRLIB_ATTEMPT(SAMSUNG32, F("Samsung32"));
   //                Estimation based on Lirc.conf file
   if(!decodeGeneric(68, 560*16, 560*8, 0, 560, 560*3, 560)) return false;
-  decode_type = PANASONIC32;
+  if((checks & IR_CHECK_NEC_COMMAND) && !IRcomplements(value>>8, value, 0xFF)) return checkFailed();
+  IRsplitFields(SAMSUNG32,value,bits,&fields);
+  decode_type = SAMSUNG32;
   return true;
 }
   
@@ -717,7 +1049,7 @@ IRdecodeRC::RCLevel IRdecodeRC::getRClevel(uint16_t *used, const unsigned int t1
 #define MIN_RC6_SAMPLES 1
 
 bool IRdecodeRC5::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("RC5"));
+  IRLIB_ATTEMPT(RC5, F("RC5"));
   if (rawlen < MIN_RC5_SAMPLES + 2) return RAW_COUNT_ERROR;
   offset = 1; // Skip gap space
   data = 0;
@@ -745,12 +1077,14 @@ bool IRdecodeRC5::decode(void) {
   // Success
   bits = 13;
   value = data;
+  payload.set(value,bits);
+  IRsplitFields(RC5,value,bits,&fields);
   decode_type = RC5;
   return true;
 }
 
 bool IRdecodeRC6::decode(void) {
-  IRLIB_ATTEMPT_MESSAGE(F("RC6"));
+  IRLIB_ATTEMPT(RC6, F("RC6"));
   if (rawlen < MIN_RC6_SAMPLES) return RAW_COUNT_ERROR;
   // Initial mark
   if (!ignoreHeader) {
@@ -790,6 +1124,8 @@ bool IRdecodeRC6::decode(void) {
   // Success
   bits = nbits;
   value = data;
+  payload.set(value,bits);
+  IRsplitFields(RC6,value,bits,&fields);
   decode_type = RC6;
   return true;
 }
@@ -843,6 +1179,9 @@ void IRrecvBase::init(void) {
   
   //initialize IRrecvBase variable:
   Mark_Excess = MARK_EXCESS_DEFAULT;
+  ignoreSelfEcho = true;
+  selfEchoCount = 0;
+  Excess_Filter = Mark_Excess*(1<<IR_CALIBRATE_SHIFT);
 }
 
 unsigned char IRrecvBase::getPinNum(void){
@@ -877,10 +1216,175 @@ bool IRrecvBase::getResults(IRdecodeBase *decoder, const unsigned int Time_per_T
     //-GS UPDATE Note: 29 Jan 2016: decoder->rawbuf now points to the *same buffer* as irparams.rawbuf1, so they are actually interchangeable. 
     decoder->rawbuf[i]=decoder->rawbuf[i]*Time_per_Tick + ( (i % 2)? -Mark_Excess:Mark_Excess);
   }
+  if(ignoreSelfEcho && isSelfEcho(decoder)) {
+    selfEchoCount++;
+    return false; //the caller resumes the receiver
+  }
+  IRLIB_STATS_INC(framesCompleted);
+  return true;
+}
+
+/* Sending no longer stops the receiver (unless they share a timer, see IRLibTimer.h) so it
+ * hears our own transmissions as well. A frame is our own if it has the same number of marks
+ * as one of the frames in the irecho log and begins and ends within ECHO_TOLERANCE_US of it.
+ * A foreign frame that arrives while we are sending differs in at least one of these.
+ * Call after IRrecvBase::getResults has converted rawbuf to microseconds.
+ */
+bool IRrecvBase::isSelfEcho(IRdecodeBase *decoder) {
+  unsigned long Duration=0, End;
+  uint16_t Marks=decoder->rawlen/2; //rawbuf[0] is the gap, then mark/space pairs ending with a mark
+  if(!Marks) return false;
+  for(uint16_t i=1; i<decoder->rawlen; i++) Duration+=decoder->rawbuf[i];
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    End=irparams.frameEndTime;
+  }
+  for(uint8_t i=0; i<IR_ECHO_FRAMES; i++) {
+    irecho_frame_t *Frame=&irecho.frame[i];
+    if(Frame->marks!=Marks) continue;
+    if(ABS_MATCH((long)(End-Duration-Frame->start),0,ECHO_TOLERANCE_US) &&
+       ABS_MATCH((long)(End-Frame->start-Frame->length),0,ECHO_TOLERANCE_US)) return true;
+  }
+  return false;
+}
+
+/* The nominal marks and spaces of each protocol, as its decoder expects them, for calibrate.
+ * A row ends at the first 0; protocols without a row are not used for calibration.
+ */
+static const uint16_t IRnominal[LAST_PROTOCOL+1][IR_NOMINAL_TIMINGS] PROGMEM = {
+  {0},                                  //UNKNOWN
+  {563*16, 563*8, 563*4, 563*3, 563},   //NEC; 563*4 is the space of a repeat frame
+  {600*4, 600*2, 600},                  //SONY
+  {889*2, 889},                         //RC5
+  {2666, 444*3, 889, 444},              //RC6; 889 is also 2*444
+  {833*4, 833*3, 833},                  //PANASONIC_OLD
+  {525*16, 525*8, 525*3, 525},          //JVC
+  {563*8, 563*3, 563},                  //NECX
+  {3456, 1728, 432*3, 432},             //PANASONIC_NEW
+  {560*16, 560*8, 560*3, 560},          //SAMSUNG32
+  {0}                                   //HASH_CODE
+};
+
+//Index into IRnominal[type] of the timing nearest to measured, or IR_NOMINAL_TIMINGS if none is within 25%
+static uint8_t nominalIndex(IR_types_t type, unsigned int measured) {
+  unsigned int Best=0xFFFF; uint8_t Index=IR_NOMINAL_TIMINGS;
+  for(uint8_t j=0; j<IR_NOMINAL_TIMINGS; j++) {
+    unsigned int N=pgm_read_word(&IRnominal[type][j]);
+    if(!N) break;
+    unsigned int Off= measured>N? measured-N: N-measured;
+    if(Off<Best && Off<=N/4) {Best=Off; Index=j;}
+  }
+  return Index;
+}
+
+/* A receiver that stretches marks by E and shortens spaces by E, with Mark_Excess set to M,
+ * leaves every mark E-M too long and every space E-M too short after getResults. So the mean
+ * of (mark - nominal) and (nominal - space) over a frame, plus M, estimates E. The estimate
+ * goes through an exponential filter, so that no single frame moves Mark_Excess far, and the
+ * result is kept within MARK_EXCESS_MIN and MARK_EXCESS_MAX. Each entry is compared with the
+ * nearest nominal timing of the protocol that decoded it; entries that are not within 25% of
+ * any (a gap, or a long space that ends a frame) are left out.
+ */
+//the filter's estimate rounded to whole us, the same way on both sides of 0
+static int16_t filteredExcess(int16_t Filter) {
+  const int16_t Half=1<<(IR_CALIBRATE_SHIFT-1);
+  return Filter>=0? (Filter+Half)>>IR_CALIBRATE_SHIFT: -((-Filter+Half)>>IR_CALIBRATE_SHIFT);
+}
+
+bool IRrecvBase::calibrate(IRdecodeBase *decoder) {
+  if(decoder->decode_type>LAST_PROTOCOL || !pgm_read_word(&IRnominal[decoder->decode_type][0])) return false;
+  long Sum=0; uint16_t Count=0;
+  for(uint16_t i=1; i<decoder->rawlen; i++) {
+    unsigned int Measured=decoder->rawbuf[i];
+    uint8_t j=nominalIndex(decoder->decode_type,Measured);
+    if(j==IR_NOMINAL_TIMINGS) continue;
+    unsigned int Nominal=pgm_read_word(&IRnominal[decoder->decode_type][j]);
+    Sum+= (i % 2)? (long)Measured-Nominal: (long)Nominal-Measured;
+    Count++;
+  }
+  if(!Count) return false;
+  //the filter holds 2^IR_CALIBRATE_SHIFT times the estimate; start it again if Mark_Excess was set by hand
+  if(filteredExcess(Excess_Filter)!=Mark_Excess) Excess_Filter=Mark_Excess*(1<<IR_CALIBRATE_SHIFT);
+  int16_t Estimate=Mark_Excess+Sum/Count;
+  Excess_Filter+= Estimate-Excess_Filter/(1<<IR_CALIBRATE_SHIFT);
+  Excess_Filter=constrain(Excess_Filter,MARK_EXCESS_MIN*(1<<IR_CALIBRATE_SHIFT),MARK_EXCESS_MAX*(1<<IR_CALIBRATE_SHIFT));
+  Mark_Excess=filteredExcess(Excess_Filter);
+  return true;
+}
 
+void IRtimingClass::clear(void) {
+  count=0; low=0xFFFF; high=0; mean=0; m2=0;
+}
+
+//Welford's method: the mean and the sum of squares are updated without keeping the samples
+void IRtimingClass::add(uint16_t measured) {
+  if(count==0xFFFF) return;
+  count++;
+  if(measured<low) low=measured;
+  if(measured>high) high=measured;
+  float Delta=measured-mean;
+  mean+=Delta/count;
+  m2+=Delta*(measured-mean);
+}
+
+IRtimingStats::IRtimingStats(IR_types_t type) {
+  setProtocol(type);
+  clear();
+}
+
+void IRtimingStats::setProtocol(IR_types_t type) {
+  protocol= type>LAST_PROTOCOL? UNKNOWN: type;
+  for(uint8_t j=0; j<IR_NOMINAL_TIMINGS; j++)
+    marks[j].nominal=spaces[j].nominal=pgm_read_word(&IRnominal[protocol][j]);
+}
+
+void IRtimingStats::clear(void) {
+  for(uint8_t j=0; j<IR_NOMINAL_TIMINGS; j++) {marks[j].clear(); spaces[j].clear();}
+  for(uint8_t p=0; p<=LAST_PROTOCOL; p++) {frames[p]=0; worst[p]=0; worstPercent[p]=0;}
+}
+
+bool IRtimingStats::add(IRdecodeBase *decoder) {
+  IR_types_t Type=decoder->decode_type;
+  if(Type>LAST_PROTOCOL || !pgm_read_word(&IRnominal[Type][0])) return false;
+  if(protocol==UNKNOWN) setProtocol(Type);
+  if(frames[Type]!=0xFFFF) frames[Type]++;
+  for(uint16_t i=1; i<decoder->rawlen; i++) {
+    uint16_t Measured=decoder->rawbuf[i];
+    uint8_t j=nominalIndex(Type,Measured);
+    if(j==IR_NOMINAL_TIMINGS) continue;
+    uint16_t Nominal=pgm_read_word(&IRnominal[Type][j]);
+    uint16_t Off= Measured>Nominal? Measured-Nominal: Nominal-Measured;
+    if(Off>worst[Type]) worst[Type]=Off;
+    uint8_t Percent=(uint32_t)Off*100/Nominal;
+    if(Percent>worstPercent[Type]) worstPercent[Type]=Percent;
+    if(Type==protocol) ((i % 2)? marks: spaces)[j].add(Measured);
+  }
   return true;
 }
 
+void IRtimingStats::dump(void) {
+#ifdef USE_DUMP
+  Serial.print(F("Timing of ")); Serial.println(Pnames(protocol));
+  for(uint8_t k=0; k<2*IR_NOMINAL_TIMINGS; k++) {
+    IRtimingClass *C= k<IR_NOMINAL_TIMINGS? &marks[k]: &spaces[k-IR_NOMINAL_TIMINGS];
+    if(!C->count) continue;
+    Serial.print(k<IR_NOMINAL_TIMINGS? F("  mark "): F("  space ")); Serial.print(C->nominal,DEC);
+    Serial.print(F(": n=")); Serial.print(C->count,DEC);
+    Serial.print(F(" mean=")); Serial.print(C->mean,1);
+    Serial.print(F(" jitter=")); Serial.print(C->jitter(),1);
+    Serial.print(F(" range=")); Serial.print(C->low,DEC); Serial.print(F("-")); Serial.println(C->high,DEC);
+  }
+  for(uint8_t p=1; p<=LAST_PROTOCOL; p++) {
+    if(!frames[p]) continue;
+    Serial.print(Pnames(p)); Serial.print(F(": frames=")); Serial.print(frames[p],DEC);
+    Serial.print(F(" worst=")); Serial.print(worst[p],DEC); Serial.print(F("us ("));
+    Serial.print(worstPercent[p],DEC); Serial.println(F("%)"));
+  }
+#else
+  DumpUnavailable();
+#endif
+}
+
 void IRrecvBase::enableIRIn(void) { 
   pinMode(irparams.recvpin, INPUT_PULLUP); //many IR receiver datasheets recommend a >10~20K pullup resistor from the output line to 5V; using INPUT_PULLUP does just that
   resume(); //call the child (derived) class's resume function (ex: IRrecvPCI::resume)
@@ -923,8 +1427,10 @@ bool IRrecvLoop::getResults(IRdecodeBase *decoder) {
     irparams.rawbuf1[irparams.rawlen1++]=DeltaTime;
     OldState=NewState;StartTime=EndTime;
   };
-  IRrecvBase::getResults(decoder);
-  return true;
+  irparams.frameEndTime=StartTime; //time of the last edge
+  if(IRrecvBase::getResults(decoder)) return true;
+  resume(); //self-echo; start over
+  return false;
 }
 #ifdef USE_ATTACH_INTERRUPTS
 /* This receiver uses the pin change hardware interrupt to detect when your input pin
@@ -985,10 +1491,16 @@ bool checkForEndOfIRCode(bool pinState, unsigned long dt, byte whoIsCalling)
       //data is now ready to be decoded
       dataStateChangedToReady = true; 
       
-      if (whoIsCalling==CALLED_BY_ISR)
+      if (whoIsCalling==CALLED_BY_ISR) {
         irparams.dataStateChangedToReady = true; //used to notify the user that data state just changed to ready, next time the user calls getResults
-      else if (whoIsCalling==CALLED_BY_USER)
+        IRLIB_STATS_INC(endByISR);
+        if (irparams.doubleBuffered==false)
+          IRLIB_STATS_INC(framesDropped); //the mark that showed us the end starts a frame we cannot store
+      }
+      else if (whoIsCalling==CALLED_BY_USER) {
+        IRLIB_STATS_INC(endByPoll);
         irparams.dataStateChangedToReady = false; //this whole function will return true, but since the user is reading this now (calling this whole function from within getResults), and can choose to act on it to decode the data now, it gets immediately reset back to false; otherwise, the user would accidentally try to decode the same data more than once simply by repeatedly calling getResults rapidly. 
+      }
 
       if (irparams.doubleBuffered==true)
       {
@@ -1002,6 +1514,7 @@ bool checkForEndOfIRCode(bool pinState, unsigned long dt, byte whoIsCalling)
         //no need to copy anything from irparams.rawbuf2 to irparams.rawbuf1, because when single-buffered, irparams.rawbuf2 points to irparams.rawbuf1 anyway, so they are the same buffer
       }
       irparams.rawlen1 = irparams.rawlen2;
+      irparams.frameEndTime = irparams.timer; //still the time stamp of the last edge, the end of the last mark
       irparams.rawlen2 = 0; //reset index; start of a new IR code 
     }
   }
@@ -1038,14 +1551,32 @@ bool checkForEndOfIRCode(bool pinState, unsigned long dt, byte whoIsCalling)
 //                         //we are LOW now, so we were HIGH before 
 //#define SPACE_START (HIGH) //this edge indicates the start of a space, and the end of a mark, in the IR code sequence
 //                           //we are HIGH now, so we were LOW before
+//-the work is done in IRrecvPCI_Edge, which takes the time stamp and pin state as parameters so that
+// a simulation can feed it edges directly (see the IRlinkLoopback example)
 void IRrecvPCI_Handler()
 {
-  if (irparams.pauseISR==true)
-    return; //don't process new data if the ISR reception of IR data is paused; pausing is necessary if single-buffered, until old data is decoded, so that it won't be overwritten 
+  IRLIB_PROFILE_MARK(IRLIB_PROFILE_PCI);
+  IRLIB_STATS_ISR_START;
+#ifndef IRLIB_STATS //with statistics, IRrecvPCI_Edge looks at the edges it ignores while paused
+  if (irparams.pauseISR==false) //don't process new data if the ISR reception of IR data is paused; pausing is necessary if single-buffered, until old data is decoded, so that it won't be overwritten 
+#endif
+    IRrecvPCI_Edge(micros(), digitalRead(irparams.recvpin)); //us; time stamp this edge
+  IRLIB_STATS_ISR_END;
+  IRLIB_PROFILE_MARK(IRLIB_PROFILE_END);
+}
+
+void IRrecvPCI_Edge(unsigned long t_now, bool pinState)
+{
+  if (irparams.pauseISR==true) {
+#ifdef IRLIB_STATS
+    if (pinState==MARK_START && t_now - Stats_Last_Edge >= LONG_SPACE_US)
+      irstats.framesDropped++;
+    Stats_Last_Edge = t_now;
+#endif
+    return;
+  }
   
   //local vars
-  unsigned long t_now = micros(); //us; time stamp this edge
-  bool pinState = digitalRead(irparams.recvpin);
   unsigned long t_old = irparams.timer; //us; time stamp last edge (previous time stamp)
   
   //blink LED 
@@ -1057,19 +1588,26 @@ void IRrecvPCI_Handler()
   //      if pinState==SPACE_START, dt = lastMarkTime
   if (dt < MINIMUM_TIME_GAP_PERMITTED) //consider this last pulse to be noise; ignore it
   {
+    IRLIB_STATS_INC(edgesRejected);
     return;
   }
-  checkForEndOfIRCode(pinState,dt,CALLED_BY_ISR);
+  if (checkForEndOfIRCode(pinState,dt,CALLED_BY_ISR))
+    IRLIB_PROFILE_MARK(IRLIB_PROFILE_PCI_EOF);
   
   //else pinState==MARK_START && (MINIMUM_TIME_GAP_PERMITTED <= dt < LONG_SPACE_US), OR pinState==SPACE_START && (dt >= MINIMUM_TIME_GAP_PERMITTED)
   //process the data by storing the time gap (dt) Mark or Space value 
   irparams.rawbuf2[irparams.rawlen2] = dt; 
   irparams.rawlen2++;
-  if (irparams.rawlen2>=RAWBUF)
+  if (irparams.rawlen2>=RAWBUF) {
     irparams.rawlen2 = RAWBUF - 1; //constrain to just keep overwriting the last value, until the start of a new code can be identified again 
+    IRLIB_STATS_INC(overflows);
+  }
   
   irparams.timer = t_now; //us; update 
-} //end of IRrecvPCI_Handler()
+#ifdef IRLIB_STATS
+  Stats_Last_Edge = t_now;
+#endif
+} //end of IRrecvPCI_Edge()
 
 void IRrecvPCI::enableIRIn(void) {
   IRrecvBase::enableIRIn();
@@ -1110,11 +1648,17 @@ bool IRrecvPCI::getResults(IRdecodeBase *decoder)
     // Serial.print("dt = "); Serial.println(dt); //FOR TESTING; double-buffered result: dt = ~8us normally, or ~144us when a 68-sample NEC code comes in and gets copied over from rawbuf2 to rawbuf1 
   }
   //3) if new data is ready, process it 
+  bool selfEcho = false;
   if (newDataJustIn==true)
-    IRrecvBase::getResults(decoder); //mandatory to call whenever a new IR data packet is ready to be decoded; this copies volatile data from the secondary buffer into the decoder, while subtracting Mark_Exces from Marks, and adding it to Spaces, among other things
+  {
+    newDataJustIn = IRrecvBase::getResults(decoder); //mandatory to call whenever a new IR data packet is ready to be decoded; this copies volatile data from the secondary buffer into the decoder, while subtracting Mark_Exces from Marks, and adding it to Spaces, among other things
+    selfEcho = !newDataJustIn; //the frame was our own transmission and has been dropped 
+  }
   //4) detach the interrupt if the ISR is paused (the ISR will automatically set the pauseISR flat to true to pause itself whenever a full IR code comes in if it is single-buffered instead of double-buffered)
   if (irparams.pauseISR==true) //note: pauseISR is a single byte and already atomic; no atomic guards needed 
     this->detachInterrupt();
+  if (selfEcho) //nothing for the user to decode, so don't wait for them to call resume 
+    this->resume();
     
   return newDataJustIn;
 };
@@ -1155,53 +1699,91 @@ void IRrecvPCI::resume()
  * or equivalent device connected to the hardware interrupt pin.
  * Create an instance of the object passing the interrupt number.
  */
-//These variables MUST be volatile since they are used both in and outside ISRs
-volatile unsigned FREQUENCY_BUFFER_TYPE *IRfreqTimes; //non-volatile pointer to volatile data (http://www.barrgroup.com/Embedded-Systems/How-To/C-Volatile-Keyword)
-volatile unsigned char IRfreqCount;
+//ISR cannot be passed parameters. If I declare the totals global they would
+//always eat RAM even if this object was not declared. So we make global pointer
+//and copy the address to it. ISR still puts data in the object.
+volatile IRfreqState *IRfreqData; //non-volatile pointer to volatile data (http://www.barrgroup.com/Embedded-Systems/How-To/C-Volatile-Keyword)
 IRfrequency::IRfrequency(unsigned char inum) {  //Note this is interrupt number, not pin number
   intrnum=inum;
   pin= Pin_from_Intr(inum);
-  //ISR cannot be passed parameters. If I declare the buffer global it would
-  //always eat RAN even if this object was not declared. So we make global pointer
-  //and copy the address to it. ISR still puts data in the object.
-  IRfreqTimes = &(Time_Stamp[0]);
+  IRfreqData = &State;
+  clear();
 };
 
+/* A falling edge ends one carrier cycle and starts the next. A cycle too short to be a carrier
+ * is a glitch and is skipped, so the next edge measures from the last good one. One too long
+ * is the gap before a new burst. When count would overflow all totals are halved, which keeps
+ * the averages and lets newer cycles weigh more.
+ */
+static inline void IRfreqFall(volatile IRfreqState *S, unsigned long now) {
+  unsigned long Period=now-S->fall;
+  if(Period<IR_FREQ_MIN_INTERVAL) return;
+  S->fall=now;
+  if(Period>IR_FREQ_MAX_INTERVAL) {
+    S->bursts++;
+  } else {
+    if(S->count==0xFFFF) {
+      S->count>>=1; S->sum>>=1; S->lowSum>>=1;
+      for(uint8_t b=0; b<IR_FREQ_BINS; b++) S->histogram[b]>>=1;
+    }
+    S->count++;
+    S->sum+=Period;
+    if(S->pending<Period) S->lowSum+=S->pending;
+    S->histogram[Period-IR_FREQ_MIN_INTERVAL]++;
+  }
+  S->pending=0;
+}
+
 // Note ISR handler cannot be part of a class/object
 void IRfreqISR(void) {
-   IRfreqTimes[IRfreqCount++]=micros();
+   IRLIB_PROFILE_MARK(IRLIB_PROFILE_FREQ);
+   IRfreqFall(IRfreqData,micros());
+   IRLIB_PROFILE_MARK(IRLIB_PROFILE_END);
 }
 
-void IRfrequency::enableFreqDetect(void){
-  attachInterrupt(intrnum,IRfreqISR, FALLING);
+//On both edges. Reading the pin would take as long as the rest, so the level is inferred: the
+//output idles HIGH, so the first edge after a gap falls, and after that they alternate.
+void IRfreqDutyISR(void) {
+   IRLIB_PROFILE_MARK(IRLIB_PROFILE_FREQ);
+   unsigned long Now=micros();
+   volatile IRfreqState *S=IRfreqData;
+   bool Falling= !S->low || Now-S->last>IR_FREQ_MAX_INTERVAL;
+   S->last=Now;
+   S->low=Falling;
+   if(Falling) IRfreqFall(S,Now);
+   else S->pending=Now-S->fall;
+   IRLIB_PROFILE_MARK(IRLIB_PROFILE_END);
+}
+
+void IRfrequency::enableFreqDetect(bool measureDuty){
+  clear();
+  results=0.0;
+  samples=0;
+  duty=0;
+  bursts=0;
+  if(measureDuty) attachInterrupt(intrnum,IRfreqDutyISR, CHANGE);
+  else attachInterrupt(intrnum,IRfreqISR, FALLING);
+};
+
+void IRfrequency::clear(void){
   //ensure atomic access to volatile variables 
-  for(i=0; i<256; i++) 
-  {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) //better to have the ATOMIC_BLOCK *inside* the "for" loop so that interrupts can still occur between loop iterations 
-    {
-      Time_Stamp[i]=0; //Time_Stamp is volatile
-    }
-  }
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    IRfreqCount=0; //volatile variable 
+    State.fall=State.last=micros()-IR_FREQ_MAX_INTERVAL-1; //the first edge starts a burst
+    State.sum=State.lowSum=State.pending=0;
+    State.count=State.bursts=0;
+    State.low=false;
+    for(i=0; i<IR_FREQ_BINS; i++) State.histogram[i]=0;
   }
-  results=0.0;
-  samples=0;
 };
-/* Test to see if we have collected at least one full buffer of data.
- * Note values are always zeroed before beginning so any non-zero data
- * in the final elements means we have collected at least a buffer full.
- * By chance the final might be zero so we test two of them. Would be
- * nearly impossible for two consecutive elements to be zero unless
- * we had not yet collected data.
- */
+
+//True once IR_FREQ_SAMPLES cycles have been measured, as many as the old time stamp buffer held
 bool IRfrequency::haveData(void) {
   bool dataIsReceived;
   //ensure atomic access to volatile variables 
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    dataIsReceived = Time_Stamp[255] || Time_Stamp[254];
+    dataIsReceived = State.count>=IR_FREQ_SAMPLES;
   }
   return dataIsReceived;
 };
@@ -1212,25 +1794,35 @@ void IRfrequency::disableFreqDetect(void){
 
 //compute the incoming frequency in kHz and store into public variable IRfrequency.results
 void IRfrequency::computeFreq(void){
-  samples=0; sum=0;
-  for(i=1; i<256; i++) {
-    unsigned char interval;
-    //ensure atomic access to volatile variables; Time_Stamp is volatile here
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-    {
-      interval=Time_Stamp[i]-Time_Stamp[i-1];
-    }
-    if(interval>50 || interval<10) continue;//ignore extraneous results where freq is outside the 20~100kHz range
-                                            //Note: 1/50us = 20kHz; 1/10us = 100khz
-    sum+=interval;//accumulate usable intervals
-    samples++;    //account usable intervals
-  };
-  if(sum)
+  unsigned long Low;
+  //ensure atomic access to volatile variables 
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    sum=State.sum;
+    Low=State.lowSum;
+    samples=State.count;
+    bursts=State.bursts;
+  }
+  if(sum) {
     results=(double)samples/(double)sum*1000; //kHz
-  else
+    duty=(Low*100+sum/2)/sum;
+  } else {
     results= 0.0;
+    duty=0;
+  }
  };
- 
+
+/* The TSMP58000 sees the carrier of the frame the demodulating receiver just returned. The
+ * totals are then started over, so that a frame the TSMP58000 did not see (it has less range)
+ * gets no carrier instead of the previous one.
+ */
+bool IRfrequency::pair(IRdecodeBase *decoder) {
+  computeFreq();
+  clear();
+  decoder->carrier= samples>=IR_CARRIER_MIN_SAMPLES? (unsigned char)(results+0.5): 0;
+  return decoder->carrier;
+}
+
 //Didn't need to be a method that we made one following example of IRrecvBase
 unsigned char IRfrequency::getPinNum(void) {
   return pin;
@@ -1245,20 +1837,21 @@ void IRfrequency::dumpResults(bool Detail) {
   Serial.print(F("\t Aprx. Frequency(kHz):")); Serial.print(results,2);
   Serial.print(F(" (")); Serial.print(int(results+0.5),DEC);
   Serial.println(F(")"));
+  Serial.print(F("Bursts:")); Serial.print(bursts,DEC);
+  if(duty) {Serial.print(F("\t Duty cycle(%):")); Serial.print(duty,DEC);}
+  Serial.println();
   if(Detail) {
-    for(i=1; i<256; i++) {
-      unsigned int interval;
-      //ensure atomic access to volatile variables; Time_Stamp is volatile 
+    //the histogram: cycles of each length in us that occurred
+    for(i=0; i<IR_FREQ_BINS; i++) {
+      uint16_t count;
+      //ensure atomic access to volatile variables; State is volatile 
       ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
       {
-        interval=Time_Stamp[i]-Time_Stamp[i-1];
+        count=State.histogram[i];
       }
-      Serial.print(interval,DEC); Serial.print("\t");
-      if ((i % 4)==0)Serial.print(F("\t "));
-      if ((i % 8)==0)Serial.println();
-      if ((i % 32)==0)Serial.println();
+      if(!count) continue;
+      Serial.print(i+IR_FREQ_MIN_INTERVAL,DEC); Serial.print(F("us:")); Serial.println(count,DEC);
     }
-    Serial.println();
   }
 #else
   DumpUnavailable(); 
@@ -1389,18 +1982,21 @@ void IRrecv::enableIRIn(void) {
 bool IRrecv::getResults(IRdecodeBase *decoder) 
 {
   bool newDataJustIn = false;
+  bool selfEcho = false;
   
   //1) see if new IR data is ready to be processed 
   if (irparams.dataStateChangedToReady==true) //variable is a singe byte; already atomic; atomic guards not needed 
   {
-    newDataJustIn = true;
     irparams.dataStateChangedToReady = false; //reset
     //2) 2nd, process the new data  
-    IRrecvBase::getResults(decoder,USEC_PER_TICK); //mandatory to call whenever a new IR data packet is ready to be decoded; this copies volatile data from the secondary buffer into the decoder, while subtracting Mark_Exces from Marks, and adding it to Spaces, among other things
+    newDataJustIn = IRrecvBase::getResults(decoder,USEC_PER_TICK); //mandatory to call whenever a new IR data packet is ready to be decoded; this copies volatile data from the secondary buffer into the decoder, while subtracting Mark_Exces from Marks, and adding it to Spaces, among other things
+    selfEcho = !newDataJustIn; //the frame was our own transmission and has been dropped 
   }
   //3) detach the interrupt if the ISR is paused (the ISR will automatically set the pauseISR flag to true to pause itself whenever a full IR code comes in if it is single-buffered instead of double-buffered)
   if (irparams.pauseISR==true) //note: pauseISR is a single byte and already atomic; no atomic guards needed 
     this->detachInterrupt();
+  if (selfEcho) //nothing for the user to decode, so don't wait for them to call resume 
+    this->resume();
     
   return newDataJustIn;
 }
@@ -1438,12 +2034,37 @@ the data is decoded, but if double-buffered, IR data receiving, processing, and
 resume immediately.
 */
 //---------------------------------------------------------------------------------------
+#ifdef IRLIB_STATS
+//While paused the ISR still runs until getResults detaches it. A mark that follows a space of at
+//least LONG_SPACE_US starts a frame that nobody will store.
+static inline void statsPausedTick(bool level) {
+  if (level==LOW) {
+    if (!Stats_Paused_Mark && Stats_Paused_Space>US_TO_TICKS(LONG_SPACE_US))
+      irstats.framesDropped++;
+    Stats_Paused_Mark = true;
+    Stats_Paused_Space = 0;
+  }
+  else {
+    Stats_Paused_Mark = false;
+    if (Stats_Paused_Space<0xFFFF) Stats_Paused_Space++;
+  }
+}
+#endif
+
 ISR(IR_RECV_INTR_NAME)
 {
+  IRLIB_PROFILE_MARK(IRLIB_PROFILE_TICK);
+  IRLIB_STATS_ISR_START;
   irparams.timer++; // One more 50us tick
   
-  if (irparams.pauseISR==true) //if single-buffered only 
+  if (irparams.pauseISR==true) { //if single-buffered only 
+#ifdef IRLIB_STATS
+    statsPausedTick(digitalRead(irparams.recvpin));
+#endif
+    IRLIB_STATS_ISR_END;
+    IRLIB_PROFILE_MARK(IRLIB_PROFILE_END);
     return; //keep incrementing the timer (hence why it is above this), but don't analyse or store any new incoming IR data until the buffer is no longer in use, and the decoder is done using the buffer data is complete
+  }
   
   enum irdata_t {IR_MARK=LOW, IR_SPACE=HIGH}; //IR_MARK is LOW; IR_SPACE is HIGH 
   //read IR receiver incoming pin state (HIGH is a SPACE, LOW is a MARK, since IR receiver is active LOW)
@@ -1452,6 +2073,7 @@ ISR(IR_RECV_INTR_NAME)
   //Check for buffer overflow 
   if (irparams.rawlen2 >= RAWBUF) { //Buffer overflow
     irparams.rawlen2--; //decrement the rawlen2 value so you just keep overwriting new data onto this final location in the raw buffer array
+    IRLIB_STATS_INC(overflows);
   }
   
   //State Machine:
@@ -1472,6 +2094,8 @@ ISR(IR_RECV_INTR_NAME)
       irparams.timer = 0;
       irparams.rcvstate = STATE_TIMING_SPACE;
     }
+    else if (irdata==IR_SPACE)
+      IRLIB_STATS_INC(edgesRejected);
     break;
   case STATE_TIMING_SPACE: //timing SPACE, waiting for next MARK to start, OR for enough time to elapse that we know the entire IR code is complete (marked by a long SPACE)
     if (irdata==IR_MARK && irparams.timer>=US_TO_TICKS(MINIMUM_TIME_GAP_PERMITTED)) { //SPACE just ended, record its time; filter out really short SPACES by ensuring the SPACE is long enough to not just be noise 
@@ -1479,9 +2103,17 @@ ISR(IR_RECV_INTR_NAME)
       irparams.timer = 0;
       irparams.rcvstate = STATE_TIMING_MARK;
     }
+    else if (irdata==IR_MARK)
+      IRLIB_STATS_INC(edgesRejected);
     else if (irdata==IR_SPACE && irparams.timer>US_TO_TICKS(LONG_SPACE_US)) {
       //Big SPACE, indicates gap between codes, which means an IR code just ended!
       //data is now ready to be decoded
+      IRLIB_PROFILE_MARK(IRLIB_PROFILE_TICK_EOF);
+      IRLIB_STATS_INC(endByISR);
+#ifdef IRLIB_STATS
+      Stats_Paused_Mark = false; //in case we pause: the gap is long already, so the next mark starts a frame
+      Stats_Paused_Space = 0xFFFF;
+#endif
       irparams.dataStateChangedToReady = true;
       irparams.rcvstate = STATE_START; //prepare for next code 
       
@@ -1498,11 +2130,14 @@ ISR(IR_RECV_INTR_NAME)
         //no need to copy anything from irparams.rawbuf2 to irparams.rawbuf1, because when single-buffered, irparams.rawbuf2 points to irparams.rawbuf1 anyway, so they are the same buffer
       }
       irparams.rawlen1 = irparams.rawlen2;
+      irparams.frameEndTime = micros() - irparams.timer*USEC_PER_TICK; //the timer has been counting the final space
     }
     break;
   } //end of switch
   
   do_Blink(!(bool)irdata); //blink LED indicator LED during receiving of IR data 
+  IRLIB_STATS_ISR_END;
+  IRLIB_PROFILE_MARK(IRLIB_PROFILE_END);
 }
 #endif //end of ifdef USE_IRRECV
 
@@ -1510,6 +2145,7 @@ ISR(IR_RECV_INTR_NAME)
  * The hardware specific portions of IRsendBase
  */
 void IRsendBase::enableIROut(unsigned char khz) {
+  if(Recording) {Recording->khz=khz; return;} //building a pulse program; leave the hardware alone
 //NOTE: the comments on this routine accompanied the original early version of IRremote library
 //which only used TIMER2. The parameters defined in IRLibTimer.h may or may not work this way.
   // Enables IR output.  The khz value controls the modulation frequency in kilohertz.
@@ -1523,14 +2159,20 @@ void IRsendBase::enableIROut(unsigned char khz) {
   // A few hours staring at the ATmega documentation and this will all make sense.
   // See my Secrets of Arduino PWM at http://www.righto.com/2009/07/secrets-of-arduino-pwm.html for details.
   
-  // Disable the Timer2 Interrupt (which is used for receiving IR)
+  // Disable the Timer2 Interrupt (which is used for receiving IR), but only if sending needs the
+  // same timer. Otherwise the receiver keeps running and IRrecvBase::isSelfEcho sorts out our own frames.
+#ifdef IR_SEND_RECV_SAME_TIMER
  IR_RECV_DISABLE_INTR; //Timer2 Overflow Interrupt    
+ irparams.interruptIsDetached = true; //so that enableIRIn or resume turns it back on
+#endif
+ irecho.open = false; //the first mark starts a new frame in the echo log
  pinMode(IR_SEND_PWM_PIN, OUTPUT);  
  digitalWrite(IR_SEND_PWM_PIN, LOW); // When not sending PWM, we want it low    
  IR_SEND_CONFIG_KHZ(khz);
  }
 
 IRsendBase::IRsendBase () {
+ Recording=NULL;
  pinMode(IR_SEND_PWM_PIN, OUTPUT);  
  digitalWrite(IR_SEND_PWM_PIN, LOW); // When not sending PWM, we want it low    
 }
@@ -1541,16 +2183,191 @@ void  My_delay_uSecs(unsigned int T) {
   if(T){if(T>16000) {delayMicroseconds(T % 1000); delay(T/1000); } else delayMicroseconds(T);};
 }
 
+#ifdef IR_SEND_BIT_BANG
+/*
+ * Bit-bang carrier generation. Instead of relying on digitalWrite and delayMicroseconds, whose
+ * timing changes with every compiler release, the carrier is produced by the hand counted
+ * assembly loop below. One carrier period is:
+ *   st   port,hi   2 cycles  \
+ *   mov  cnt,on    1          > high for 3*OnLoops+2 cycles
+ *   dec/brne       3*on-1    /
+ *   st   port,lo   2 cycles  \
+ *   out  SREG      1          |
+ *   mov  cnt,off   1          |
+ *   dec/brne       3*off-1    > low for 3*OffLoops+8 cycles
+ *   sbiw periods   2          |
+ *   brne           2          |
+ *   cli            1         /
+ * bitBangConfig picks the loop counts closest to the requested frequency and IR_BIT_BANG_DUTY.
+ * From the cycle counts, at 16 MHz and 33% duty: 36 kHz gives 445 cycles (35.96 kHz, 32.8%),
+ * 38 kHz 421 (38.00 kHz, 33.3%), 40 kHz 400 (40.00 kHz, 32.8%) and 57 kHz 280 (57.14 kHz,
+ * 32.9%). That is a period no interrupt runs in; see extras/avr-bench for measuring them.
+ * Interrupts are only off while the carrier is high, about 9us at 38kHz. Writing back the
+ * caller's SREG lets any that are pending run in the low part of every period, so Timer0 and
+ * the receive ISR keep up even during a 9ms NEC header. An interrupt that runs there stretches
+ * that one period by all of its length. The IRrecv tick ISR may take up to its 400 cycle
+ * budget plus entry, prologue and epilogue, and a Timer0 overflow can run in the same gap, so
+ * one period can grow by about 32us: a 26us period at 38kHz to about 58us. Slower ISRs of the
+ * sketch stretch it further. bitBangMark keeps the mark itself to its length: it looks at
+ * micros() every IR_BIT_BANG_BURST periods and only sends as many more as the time left needs.
+ * The loop writes the whole port, so an ISR that changes another pin of the same port during
+ * a mark has that change undone until the mark ends.
+ */
+void IRsendBase::bitBangConfig(unsigned char khz) {
+  BitBangPort = portOutputRegister(digitalPinToPort(IR_SEND_BIT_BANG));
+  BitBangMask = digitalPinToBitMask(IR_SEND_BIT_BANG);
+  //all values below are in CPU cycles
+  unsigned int Period = (SYSCLOCK/500/khz + 1)/2; //rounded SYSCLOCK/(khz*1000)
+  unsigned int High = ((unsigned long)Period*IR_BIT_BANG_DUTY + 50)/100;
+  int Loops = ((int)High - 2 + 1)/3;
+  OnLoops = constrain(Loops, 1, 255);
+  Loops = ((int)Period - 10 - 3*OnLoops + 1)/3;
+  OffLoops = constrain(Loops, 1, 255);
+  Period = IR_BIT_BANG_HIGH_CYCLES(OnLoops) + IR_BIT_BANG_LOW_CYCLES(OffLoops); //what we will really get
+  //periods per microsecond times 65536; note 65536/1000000 == 1024/15625
+  PeriodScale = ((SYSCLOCK/15625UL)*1024UL + Period/2)/Period;
+}
+
+void IRbitBangCarrier(volatile uint8_t *port, uint8_t mask, uint8_t onLoops, uint8_t offLoops, uint16_t periods) {
+  if(!periods) return;
+  uint8_t sreg = SREG; //written back in the low part of each period, which ends with interrupts as they were
+  uint8_t hi = *port | mask;
+  uint8_t lo = *port & ~mask;
+  uint8_t cnt;
+  asm volatile (
+    "1: cli                      \n\t"
+    "   st   %a[port], %[hi]     \n\t"
+    "   mov  %[cnt], %[on]       \n\t"
+    "2: dec  %[cnt]              \n\t"
+    "   brne 2b                  \n\t"
+    "   st   %a[port], %[lo]     \n\t"
+    "   out  __SREG__, %[sreg]   \n\t"
+    "   mov  %[cnt], %[off]      \n\t"
+    "3: dec  %[cnt]              \n\t"
+    "   brne 3b                  \n\t"
+    "   sbiw %[n], 1             \n\t"
+    "   brne 1b                  \n\t"
+    : [cnt] "=&r" (cnt), [n] "+w" (periods)
+    : [port] "e" (port), [hi] "r" (hi), [lo] "r" (lo), [on] "r" (onLoops), [off] "r" (offLoops),
+      [sreg] "r" (sreg)
+    : "memory"
+  );
+}
+
+void IRsendBase::bitBangMark(unsigned int time) {
+  uint16_t Periods=(uint16_t)(((uint32_t)time*PeriodScale)>>16);
+  if(!(SREG & _BV(SREG_I))) { //no interrupt can stretch it
+    IRbitBangCarrier(BitBangPort, BitBangMask, OnLoops, OffLoops, Periods);
+    return;
+  }
+  unsigned long Start=micros(), Elapsed=0;
+  while(Elapsed<time) {
+    Periods=(uint16_t)(((uint32_t)(time-Elapsed)*PeriodScale)>>16);
+    if(!Periods) break;
+    IRbitBangCarrier(BitBangPort, BitBangMask, OnLoops, OffLoops, min(Periods, IR_BIT_BANG_BURST));
+    Elapsed=micros()-Start;
+  }
+}
+#endif
+
 void IRsendBase::mark(unsigned int time) {
+ Extent+=time;
+ if(Recording) {Recording->add(true,time); return;}
+ if(!irecho.open) {
+   irecho.last = (irecho.last+1) % IR_ECHO_FRAMES;
+   irecho.frame[irecho.last].start = micros();
+   irecho.frame[irecho.last].marks = 0;
+   irecho.sent = 0;
+   irecho.open = true;
+ }
+ irecho_frame_t *Frame = &irecho.frame[irecho.last];
+ if(!Frame->marks || Frame->length!=irecho.sent) Frame->marks++; //a receiver sees back to back marks (RC5, RC6) as one
+ Frame->length = (irecho.sent += time);
  IR_SEND_PWM_START;
  IR_SEND_MARK_TIME(time);
- Extent+=time;
 }
 
 void IRsendBase::space(unsigned int time) {
+ Extent+=time;
+ if(Recording) {Recording->add(false,time); return;}
  IR_SEND_PWM_STOP;
+ if(irecho.open) {
+   if(time>=LONG_SPACE_US) irecho.open = false; //a receiver ends the frame here too
+   else irecho.sent += time;
+ }
  My_delay_uSecs(time);
- Extent+=time;
+}
+
+bool IRsendMulti::send(const IRpulseProgram *program, const uint8_t pins[], uint8_t count) {
+  const IRpulseProgram *programs[IR_MULTI_MAX_EMITTERS];
+  if(count>IR_MULTI_MAX_EMITTERS) return false;
+  for(uint8_t i=0; i<count; i++) programs[i]=program;
+  return send(programs, pins, count);
+}
+
+/*
+ * Plays all programs against one time line. Each emitter keeps the index of the next entry in its
+ * program and the time (us from the start) at which that entry begins. Every pass switches the
+ * gates of all emitters whose next entry is due and then waits for the earliest next edge.
+ * Index==length is the end of a program, at which point its gate goes LOW for good.
+ */
+bool IRsendMulti::send(const IRpulseProgram *programs[], const uint8_t pins[], uint8_t count) {
+  uint16_t index[IR_MULTI_MAX_EMITTERS];
+  unsigned long edge[IR_MULTI_MAX_EMITTERS];
+  volatile uint8_t *port[IR_MULTI_MAX_EMITTERS];
+  uint8_t mask[IR_MULTI_MAX_EMITTERS];
+  if(count==0 || count>IR_MULTI_MAX_EMITTERS) return false;
+  for(uint8_t i=0; i<count; i++) {
+    unsigned char khz=programs[i]->khz;
+    if(programs[i]->overflow) return false; //only the start of the frame was kept
+    if(khz && abs((int)khz - programs[0]->khz) > IR_MULTI_KHZ_SPREAD) return false;
+    port[i]=portOutputRegister(digitalPinToPort(pins[i]));
+    mask[i]=digitalPinToBitMask(pins[i]);
+#ifdef IR_SEND_BIT_BANG
+    if(port[i]!=port[0]) return false; //the carrier loop drives one port
+#endif
+  }
+  enableIROut(programs[0]->khz);
+  for(uint8_t i=0; i<count; i++) {
+    pinMode(pins[i], OUTPUT);
+    fastDigitalWrite(port[i], mask[i], LOW);
+    index[i]=0; edge[i]=0;
+  }
+  unsigned long now=0;
+#ifdef IR_SEND_BIT_BANG
+  uint8_t lit=0; //emitters that are in a mark
+#else
+  IR_SEND_PWM_START; //carrier runs the whole time; the gates decide who transmits
+  unsigned long start=micros();
+#endif
+  for(;;) {
+    unsigned long next=0xFFFFFFFFUL;
+    for(uint8_t i=0; i<count; i++) {
+      const IRpulseProgram *p=programs[i];
+      while(index[i]<=p->length && edge[i]<=now) {
+        bool on= (index[i]<p->length) && !(index[i] & 1);
+#ifdef IR_SEND_BIT_BANG
+        lit= on ? (lit|mask[i]) : (lit & ~mask[i]);
+#else
+        fastDigitalWrite(port[i], mask[i], on);
+#endif
+        if(index[i]<p->length) edge[i]+=p->durations[index[i]];
+        index[i]++;
+      }
+      if(index[i]<=p->length && edge[i]<next) next=edge[i];
+    }
+    if(next==0xFFFFFFFFUL) break; //every program has ended
+#ifdef IR_SEND_BIT_BANG
+    if(lit) IRbitBangCarrier(port[0], lit, OnLoops, OffLoops, (uint16_t)(((uint32_t)(next-now) * PeriodScale) >> 16));
+    else My_delay_uSecs(next-now);
+#else
+    while(micros()-start < next);
+#endif
+    now=next;
+  }
+  IR_SEND_PWM_STOP;
+  Extent=now;
+  return true;
 }
 
 /*
@@ -1559,11 +2376,71 @@ void IRsendBase::space(unsigned int time) {
 
 
 #ifdef IRLIB_TRACE
-void IRLIB_ATTEMPT_MESSAGE(const __FlashStringHelper * s) {Serial.print(F("Attempting ")); Serial.print(s); Serial.println(F(" decode:"));};
+void IRLIB_ATTEMPT_MESSAGE(const __FlashStringHelper * s) {
+#ifdef IRLIB_REJECTIONS
+  IRreject_protocol=UNKNOWN;
+#endif
+  Serial.print(F("Attempting ")); Serial.print(s); Serial.println(F(" decode:"));
+};
 void IRLIB_TRACE_MESSAGE(const __FlashStringHelper * s) {Serial.print(F("Executing ")); Serial.println(s);};
-byte IRLIB_REJECTION_MESSAGE(const __FlashStringHelper * s) { Serial.print(F(" Protocol failed because ")); Serial.print(s); Serial.println(F(" wrong.")); return false;};
-byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected) {  
- IRLIB_REJECTION_MESSAGE(s); Serial.print(F("Error occurred with rawbuf[")); Serial.print(index,DEC); Serial.print(F("]=")); Serial.print(value,DEC);
- Serial.print(F(" expected:")); Serial.println(expected,DEC); return false;
+#endif
+
+#if defined(IRLIB_TRACE) || defined(IRLIB_REJECTIONS)
+byte IRLIB_REJECT(uint8_t reason, const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected) {
+#ifdef IRLIB_REJECTIONS
+  irreject_t *Entry=&irrejections.log[irrejections.total++ & (IR_REJECT_LOG-1)];
+  Entry->protocol=IRreject_protocol; Entry->reason=reason; Entry->offset=index;
+  Entry->measured=value; Entry->expected=expected;
+  irrejections.histogram[IRreject_protocol][reason]++;
+#endif
+#ifdef IRLIB_TRACE
+  Serial.print(F(" Protocol failed because ")); Serial.print(s); Serial.println(F(" wrong."));
+  if(reason==IRLIB_REJECT_RAW_COUNT || (value==0 && expected==0)) return false;
+  Serial.print(F("Error occurred with rawbuf[")); Serial.print(index,DEC); Serial.print(F("]=")); Serial.print(value,DEC);
+  Serial.print(F(" expected:")); Serial.println(expected,DEC);
+#endif
+  return false;
 };
 #endif
+
+#ifdef IRLIB_REJECTIONS
+irrejections_t irrejections;
+IR_types_t IRreject_protocol; //the decoder running now; set by IRLIB_ATTEMPT
+
+void IRrejections_clear(void) {
+  memset(&irrejections,0,sizeof(irrejections));
+}
+
+const __FlashStringHelper *IRreject_reason(uint8_t reason) {
+  if(reason>=IRLIB_REJECT_REASONS) reason=IRLIB_REJECT_OTHER;
+  const __FlashStringHelper *Names[IRLIB_REJECT_REASONS]={F("raw count"),F("header mark"),F("header space"),
+    F("data mark"),F("data space"),F("trailer bit"),F("other"),F("integrity")};
+  return Names[reason];
+}
+
+void IRrejections_dump(void) {
+#ifdef USE_DUMP
+  uint16_t First=irrejections.total>IR_REJECT_LOG ? irrejections.total-IR_REJECT_LOG : 0;
+  Serial.print(irrejections.total,DEC); Serial.println(F(" rejections, latest:"));
+  for(uint16_t i=First; i!=irrejections.total; i++) {
+    irreject_t *Entry=&irrejections.log[i & (IR_REJECT_LOG-1)];
+    Serial.print(Pnames(Entry->protocol)); Serial.print(F("\t")); Serial.print(IRreject_reason(Entry->reason));
+    if(Entry->reason==IRLIB_REJECT_RAW_COUNT) {
+      Serial.print(F("\trawlen=")); Serial.println(Entry->measured,DEC);
+      continue;
+    }
+    Serial.print(F("\trawbuf[")); Serial.print(Entry->offset,DEC); Serial.print(F("]=")); Serial.print(Entry->measured,DEC);
+    Serial.print(F(" expected:")); Serial.println(Entry->expected,DEC);
+  }
+  for(uint8_t p=0; p<=LAST_PROTOCOL; p++) {
+    for(uint8_t r=0; r<IRLIB_REJECT_REASONS; r++) {
+      if(!irrejections.histogram[p][r]) continue;
+      Serial.print(Pnames(p)); Serial.print(F("\t")); Serial.print(IRreject_reason(r));
+      Serial.print(F("\t")); Serial.println(irrejections.histogram[p][r],DEC);
+    }
+  }
+#else
+  DumpUnavailable();
+#endif
+}
+#endif
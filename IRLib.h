@@ -39,6 +39,15 @@
 // methods virtual, which will be slightly slower, which is why it is optional.
 //#define IRLIB_TRACE
 // #define IRLIB_TEST
+// If IRLIB_PROFILE is defined the interrupt routines report where they start and end through
+// the GPIOR0 register, so that a simulator can count their cycles. See extras/avr-bench.
+//#define IRLIB_PROFILE
+// If IRLIB_STATS is defined the receivers and IRdecode::decode keep the counters in irstats_t
+// below, so a sketch can find out why frames go missing. It costs a few cycles per interrupt.
+//#define IRLIB_STATS
+// If IRLIB_REJECTIONS is defined every decoder that turns a frame down records why in
+// irrejections (see below) instead of needing IRLIB_TRACE, which prints while decoding.
+//#define IRLIB_REJECTIONS
 
 /* If not using the IRrecv class but only using IRrecvPCI or IRrecvLoop you can eliminate
  * some conflicts with the duplicate definition of ISR by turning this feature off.
@@ -103,26 +112,97 @@ typedef enum
 
 const __FlashStringHelper *Pnames(IR_types_t Type); //Returns a character string that is name of protocol.
 
+/* The data bits of a frame, for protocols that do not fit in an unsigned long.
+ * The value is a number of "length" bits whose most significant bit is the first one sent.
+ * The least significant 64 bits are kept in "low", so up to 64 bits only ever touch that.
+ * Anything above goes into the small array "ext", most significant byte first. Nothing is
+ * allocated; raise IR_PAYLOAD_BITS if you need frames longer than 128 bits.
+ */
+#define IR_PAYLOAD_BITS 128 //maximum number of bits; at least 64
+class IRpayload
+{
+public:
+  IRpayload(void) {clear();};
+  void clear(void);
+  void set(uint64_t data, uint8_t nbits);  //for frames of up to 64 bits
+  void shiftIn(bool bit);                  //appends a bit as the new least significant one
+  uint8_t byteAt(uint8_t n) const;         //byte n counting from the least significant one
+  bool bitAt(uint16_t n) const;            //bit n counting from the least significant one
+  uint64_t low;
+  uint8_t ext[(IR_PAYLOAD_BITS-64+7)/8];
+  uint16_t length;                         //number of bits held
+};
+
+/* Integrity checks, for IRdecodeBase::checks. Several protocols send a field twice, once
+ * inverted, or add a checksum, but the decoders pass any value whose timings match. Each
+ * check is a few bit operations on the decoded value, and a frame that fails it is rejected
+ * as if it had not matched, so the next decoder of IRdecode gets to try it. NEC and Samsung32
+ * have the same timing, so with IR_CHECK_NEC_ADDRESS an NEC frame with a 16 bit address, or a
+ * damaged address, decodes as Samsung32, which has no address check.
+ */
+#define IR_CHECK_NEC_COMMAND   0x01 //NEC, NECx, Samsung32: the command byte is followed by its complement
+#define IR_CHECK_NEC_ADDRESS   0x02 //NEC: so is the address byte; leave it off for 16 bit (extended) addresses
+#define IR_CHECK_PANASONIC_OLD 0x04 //the second 11 bits are the complement of the first 11
+#define IR_CHECK_PANASONIC     0x08 //the byte after the 24 bits of value is their XOR
+#define IR_CHECK_ALL           0x0F
+
+/* The fields of a frame. value holds the bits in the order they were sent, the first one
+ * highest, but NEC, NECx, Samsung32, Sony, JVC and both Panasonic protocols send every field
+ * least significant bit first, so the address and command in value are bit reversed. The
+ * decoders split value into fields as well, with a small table, and IRsend::send takes them.
+ *   NEC            address and command; a 16 bit address is "extended"
+ *   NECx           16 bit address and command
+ *   Samsung32      address and command
+ *   Sony           7 bit command, 5 or 8 bit address, and the 8 bit subAddress of 20 bit codes
+ *   RC5            5 bit address, 7 bit command (the 7th is the inverted field bit), toggle
+ *   RC6            8 bit address and command of mode 0, toggle
+ *   Panasonic_Old  5 bit address (device) and 6 bit command (function)
+ *   JVC            address and command; repeat for the frames without a header
+ *   Panasonic      address (device), subAddress (sub-device) and command (function)
+ * An NEC REPEAT frame has only repeat set.
+ */
+typedef struct {
+  uint16_t address;
+  uint8_t subAddress;
+  uint8_t command;
+  bool extended;      //the address is 16 bits rather than 8 sent twice
+  bool toggle;
+  bool repeat;
+} IRfields;
+
+uint8_t IRreverse(uint8_t data, uint8_t nbits=8); //the low nbits of data in reverse order
+void IRsplitFields(IR_types_t type, unsigned long value, uint8_t bits, IRfields *fields);
+//The value of a frame with these fields; bits is needed for Sony and RC6
+unsigned long IRjoinFields(IR_types_t type, const IRfields &fields, uint8_t bits);
+
 // Base class for decoding raw results
 class IRdecodeBase
 {
 public:
   IRdecodeBase(void);
   IR_types_t decode_type;           // NEC, SONY, RC5, UNKNOWN etc.
-  unsigned long value;           // Decoded value
+  unsigned long value;           // Decoded value; the low 32 bits of payload
   unsigned char bits;            // Number of bits in decoded value
+  IRpayload payload;             // All decoded bits, for protocols longer than 32 bits
   volatile uint16_t *rawbuf; // Raw intervals in microseconds; GS: now ALWAYS points to irparams.rawbuf1; keep this variable, even though redundant with irparams.rawbuf1, for easy public access to the data 
   uint16_t rawlen;          // Number of records in rawbuf; keep this variable, even though redundant with irparams.rawlen, for easy public access to the data 
   bool ignoreHeader;             // Relaxed header detection allows AGC to settle
+  unsigned char carrier;         // Carrier of the frame in kHz, e.g. from IRfrequency::pair; 0 if not measured
+  uint8_t checks;                // IR_CHECK_ flags: integrity checks the decoders run; none by default
+  uint16_t checkFailures;        // Times a decoder matched the timings but a check failed; IRdecode may count a frame twice
+  IRfields fields;               // value split into address, command etc.; see IRfields
   virtual void reset(void);      // Initializes the decoder
   virtual bool decode(void);     // This base routine always returns false override with your routine
-  bool decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
+  bool decodeGeneric(uint16_t Raw_Count, unsigned int Head_Mark, unsigned int Head_Space, 
                      unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero);
   virtual void dumpResults (void);
   void useDoubleBuffer(volatile uint16_t *p_buffer); //use this to allow double-buffering; see extensive double-buffer notes in IRLibRData.h. 
   // void copyBuf (IRdecodeBase *source);//copies rawbuf and rawlen from one decoder to another; GS: REMOVED, NO LONGER NEEDED; double-buffers are done differently now 
 protected:
   uint16_t offset;           // Index into rawbuf used various places
+  bool carrierFits(IR_types_t type); // true if carrier is 0 or within IR_CARRIER_TOLERANCE of the protocol's
+  bool checkFailed(void);           // counts the failure and returns false
+  IRdecodeBase(volatile uint16_t *buffer); // Decodes from buffer and leaves irparams alone; see IRdecodeFrame
 };
 
 class IRdecodeHash: public virtual IRdecodeBase
@@ -214,15 +294,62 @@ public virtual IRdecodeRC5,
 public virtual IRdecodeRC6,
 public virtual IRdecodePanasonic_Old,
 public virtual IRdecodeJVC,
-public virtual IRdecodeNECx
+public virtual IRdecodeNECx,
 public virtual IRdecodePanasonic,
-public virtual IRdecodeSamsung32,
+public virtual IRdecodeSamsung32
 // , public virtual IRdecodeADDITIONAL //add additional protocols here
 {
 public:
   virtual bool decode(void);    // Calls each decode routine individually
 };
 
+//Carrier in kHz that the protocol is sent at, as IRsend uses it; 0 for UNKNOWN and HASH_CODE
+unsigned char IRcarrier(IR_types_t type);
+
+/* What IRdecodeFrame::decodeFrame found. decode_type is UNKNOWN if no decoder took the frame. */
+typedef struct {
+  IR_types_t decode_type;
+  unsigned long value;
+  unsigned char bits;
+  IRpayload payload;
+  IRfields fields;
+} IRdecodeResult;
+
+/* Decodes frames that come from somewhere other than a receiver, e.g. a capture file on a
+ * host. Every other decoder uses the receiver's buffer irparams.rawbuf1; this one has a buffer
+ * of its own and its constructor does not touch irparams. All working state is in the object,
+ * so separate objects may decode on separate threads. Built with IRLIB_STATS or
+ * IRLIB_REJECTIONS the decoders also update global counters, and that is no longer true.
+ */
+class IRdecodeFrame: public IRdecode
+{
+public:
+  IRdecodeFrame(void);
+  //Decodes count durations in us, rawbuf[0] first, as getResults would leave them. Entries past RAWBUF are ignored.
+  IRdecodeResult decodeFrame(const uint16_t *durations, uint16_t count);
+protected:
+  uint16_t Buffer[RAWBUF];
+};
+
+/* A pulse program holds the mark and space durations of one or more frames in microseconds,
+ * plus their carrier frequency. Even entries are marks, odd entries are spaces. Any sender
+ * records into a program instead of transmitting after you call its record() method.
+ * IRsendMulti plays programs back on several emitters at once. Like the double buffer
+ * used by the receivers, the duration buffer is created by your sketch.
+ */
+class IRpulseProgram
+{
+public:
+  IRpulseProgram(uint16_t *buffer, uint16_t bufferSize);
+  void clear(void);
+  void add(bool isMark, unsigned int usec); //appends; merges with the previous entry if it is the same kind
+  uint16_t *durations;
+  uint16_t size;      //capacity of durations
+  uint16_t length;    //number of entries used
+  unsigned char khz;  //carrier frequency set by the sender's enableIROut
+  bool overflow;      //true if the frame did not fit in the buffer
+};
+
 //Base class for sending signals
 class IRsendBase
 {
@@ -231,12 +358,21 @@ public:
   void sendGeneric(unsigned long data,  unsigned char Num_Bits, unsigned int Head_Mark, unsigned int Head_Space, 
                    unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero, 
 				   unsigned char kHz, bool Stop_Bits, unsigned long Max_Extent=0);
+  void sendGeneric(const IRpayload &data, unsigned int Head_Mark, unsigned int Head_Space, 
+                   unsigned int Mark_One, unsigned int Mark_Zero, unsigned int Space_One, unsigned int Space_Zero, 
+				   unsigned char kHz, bool Stop_Bits, unsigned long Max_Extent=0);
+  void record(IRpulseProgram *program); //send into a pulse program instead of the IR LED; pass NULL to transmit again
 protected:
+  IRpulseProgram *Recording;
   void enableIROut(unsigned char khz);
   VIRTUAL void mark(unsigned int usec);
   VIRTUAL void space(unsigned int usec);
   unsigned long Extent;
-  unsigned char OnTime,OffTime,iLength;//used by bit-bang output.
+  void bitBangConfig(unsigned char khz);//used by bit-bang output.
+  void bitBangMark(unsigned int time);//used by bit-bang output.
+  volatile uint8_t *BitBangPort; uint8_t BitBangMask;//used by bit-bang output.
+  unsigned char OnLoops,OffLoops;//used by bit-bang output; delay loop counts for the on and off part of one carrier period
+  unsigned int PeriodScale;//used by bit-bang output; carrier periods per microsecond, times 65536
 };
 
 class IRsendNEC: public virtual IRsendBase
@@ -310,8 +446,8 @@ public virtual IRsendRC5,
 public virtual IRsendRC6,
 public virtual IRsendPanasonic_Old,
 public virtual IRsendJVC,
-public virtual IRsendNECx
-public virtual IRsendPanasonic
+public virtual IRsendNECx,
+public virtual IRsendPanasonic,
 public virtual IRsendSamsung32
 
 
@@ -319,6 +455,35 @@ public virtual IRsendSamsung32
 {
 public:
   void send(IR_types_t Type, unsigned long data, unsigned int data2, bool autoRepeatSend=true); //by default, automatically repeat the send command, if applicable: ex: for Sony, repeat the send code 3 times, per the standard; this may want to be manually set to false, however, in the event you are sending custom IR digital data streams using such protocols, in which case automatically sending each code repeatedly will corrupt the custom digital data stream being sent. ~GS
+  //The same from fields. data2 is the number of bits for Sony and RC6; 0 picks 12, 15 or 20 for
+  //Sony from the fields and 20 for RC6. JVC sends a first frame unless fields.repeat is set.
+  void send(IR_types_t Type, const IRfields &fields, unsigned int data2=0, bool autoRepeatSend=true);
+};
+
+/* Sends on several emitters at the same time from one carrier so that controlling several
+ * devices takes as long as the longest frame instead of the sum of all of them. Each emitter
+ * has its own gate pin which is HIGH while that emitter's program is in a mark.
+ * With a hardware timer the carrier stays on IR_SEND_PWM_PIN and each emitter must only light
+ * when both the carrier and its gate are active (for example the carrier drives a shared
+ * low-side transistor and each gate pin feeds one LED through its resistor).
+ * With IR_SEND_BIT_BANG the gate pins are the emitters themselves and are modulated directly
+ * by the bit-bang carrier; in that case all of them must be on the same port as pins[0].
+ * There is only one carrier, that of programs[0]. A program recorded at another frequency is
+ * only accepted if it is within IR_MULTI_KHZ_SPREAD of it (38 and 40 kHz, but not 36 and 40),
+ * which a receiver still picks up at close range; a program whose khz is 0 takes it as is.
+ * send() returns false and sends nothing if count is 0 or over IR_MULTI_MAX_EMITTERS, if a
+ * program overflowed its buffer while it was recorded, if the carriers are further apart, or if
+ * a bit-bang emitter is on another port.
+ */
+#define IR_MULTI_MAX_EMITTERS 8
+#define IR_MULTI_KHZ_SPREAD 2
+class IRsendMulti: public virtual IRsendBase
+{
+public:
+  //the same program on every emitter, for more coverage
+  bool send(const IRpulseProgram *program, const uint8_t pins[], uint8_t count);
+  //programs[i] is sent on pins[i]; all use the carrier frequency of programs[0]
+  bool send(const IRpulseProgram *programs[], const uint8_t pins[], uint8_t count);
 };
 
 // Changed this to a base class so it can be extended
@@ -335,10 +500,15 @@ public:
   void enableIRIn(void);
   virtual void resume(void);
   unsigned char getPinNum(void);
+  bool isSelfEcho(IRdecodeBase *decoder); //true if the frame in decoder is one we just sent ourselves
+  bool calibrate(IRdecodeBase *decoder); //call after a successful decode(); moves Mark_Excess toward the skew this frame shows. False if the protocol has no timings to compare with
   //variables:
   int16_t Mark_Excess; //us; excess Mark time/lacking Space time, due to IR receiver filtering; *must* be *signed*, to allow negative values! For more info, see extensive "Notes on Mark_Excess" in IRLibMatch.h. 
+  bool ignoreSelfEcho; //default true; getResults drops frames for which isSelfEcho is true and returns false instead
+  uint16_t selfEchoCount; //number of frames dropped as self-echo
 protected:
   void init(void);
+  int16_t Excess_Filter; //calibrate's running estimate of Mark_Excess, times 2^IR_CALIBRATE_SHIFT
 };
 
 /* Original IRrecv class uses 50µs interrupts to sample input. While this is generally
@@ -397,30 +567,58 @@ public:
 private:
   unsigned char intrnum;
 };
+//The pin change ISR of IRrecvPCI calls this with micros() and the pin state. Call it yourself
+//to feed simulated edges into the receiver.
+void IRrecvPCI_Edge(unsigned long t_now, bool pinState);
 
 /* This class facilitates detection of frequency of an IR signal. Requires a TSMP58000
  * or equivalent device connected to the hardware interrupt pin.
  * Create an instance of the object passing the interrupt number.
+ * The interrupt routine keeps running totals instead of a buffer of time stamps: each carrier
+ * cycle from IR_FREQ_MIN_INTERVAL to IR_FREQ_MAX_INTERVAL us long is added to a sum, a count
+ * and a histogram as it arrives, shorter ones are ignored as glitches, and longer ones are
+ * the gaps between bursts. computeFreq() can be called at any time and costs only a division.
+ * enableFreqDetect(true) also measures the duty cycle. That takes an interrupt on both edges,
+ * which a 16MHz AVR can only keep up with up to about 40kHz.
+ * With a demodulating receiver on another pin, keep frequency detection enabled and call
+ * pair() after each getResults(). The carrier of the frame then goes with it to decode(),
+ * which skips the protocols sent at other frequencies (see IRcarrier).
  */
-//Un-comment only one of the following three lines depending on available RAM
-//#define FREQUENCY_BUFFER_TYPE unsigned char
-#define FREQUENCY_BUFFER_TYPE int
-//#define FREQUENCY_BUFFER_TYPE long
+#define IR_FREQ_MIN_INTERVAL 10  //us; 100kHz
+#define IR_FREQ_MAX_INTERVAL 50  //us; 20kHz
+#define IR_FREQ_BINS (IR_FREQ_MAX_INTERVAL-IR_FREQ_MIN_INTERVAL+1)
+#define IR_FREQ_SAMPLES 255      //haveData() is true from this many cycles on
+typedef struct {
+  unsigned long fall;      //micros() of the last falling edge
+  unsigned long last;      //and of the last edge of either kind
+  unsigned long sum;       //us; cycles counted
+  unsigned long lowSum;    //us of those the output was low; duty cycle only
+  unsigned long pending;   //us the output was low in the current cycle
+  uint16_t count;          //cycles counted; all totals are halved when it would overflow
+  uint16_t bursts;         //gaps longer than IR_FREQ_MAX_INTERVAL, so marks seen; wraps around
+  bool low;                //the output is low; duty cycle only
+  uint16_t histogram[IR_FREQ_BINS]; //cycles by length, from IR_FREQ_MIN_INTERVAL us
+} IRfreqState;
+
 class IRfrequency
 {
 public:
   //Note this is interrupt number, not pin number
   IRfrequency(unsigned char inum);
-  void enableFreqDetect(void);
+  void enableFreqDetect(bool measureDuty=false); //true: measure the duty cycle as well
   bool haveData(void);      //detect if data is received
   void disableFreqDetect(void);
+  void clear(void);         //starts the totals over; detection and the last results stay
   void computeFreq(void);	//computes but does not print results
   void dumpResults(bool Detail);	//computes and prints result
   unsigned char getPinNum(void);//get value computed from interrupt number
+  bool pair(IRdecodeBase *decoder); //after getResults: measures this frame's carrier into decoder->carrier and starts over
   double results; //results in kHz
-  unsigned char samples; //number of samples used in computation
+  uint16_t samples; //number of samples used in computation
+  unsigned char duty; //percent of each cycle the output is low; 0 if not measured
+  uint16_t bursts; //marks seen since the totals were started
 private:
-  volatile unsigned FREQUENCY_BUFFER_TYPE Time_Stamp[256]; //MUST be volatile because used both in and outside ISRs
+  volatile IRfreqState State; //MUST be volatile because used both in and outside ISRs
   unsigned char intrnum, pin;
   unsigned int i;
   unsigned long sum;
@@ -441,6 +639,109 @@ void do_Blink(bool blinkState);
  * “attachInterrupt()” Arduino function.  It is used by both IRrecvPCI and IRfrequency.
  */
 unsigned char Pin_from_Intr(unsigned char inum);
+#ifdef IRLIB_STATS
+/* Receive statistics. The interrupt routines only ever add to these counters, so a sketch
+ * can send them to its telemetry as they are, or as differences since the last snapshot.
+ * The 16 bit counters wrap around. IRstats_snapshot copies all of them with interrupts off,
+ * so the copy is consistent; IRstats_clear sets them back to 0.
+ */
+typedef struct {
+  uint16_t framesCompleted;  //frames returned by getResults (self-echoes not included)
+  uint16_t framesDropped;    //frames that started while a single-buffered receiver was paused,
+                             //before getResults collected the previous frame and detached the ISR
+  uint16_t overflows;        //times an entry was stored on the last slot of a full RAWBUF
+  uint16_t edgesRejected;    //IRrecvPCI: edges ignored because of MINIMUM_TIME_GAP_PERMITTED;
+                             //IRrecv: 50us samples at which an edge was held back for that reason
+  uint16_t endByISR;         //ends of frame found by the interrupt routine
+  uint16_t endByPoll;        //ends of frame found by IRrecvPCI::getResults
+  uint16_t decodeAttempts[LAST_PROTOCOL+1];  //by IRdecode::decode, per protocol
+  uint16_t decodeSuccesses[LAST_PROTOCOL+1];
+  uint16_t maxISRCycles;     //longest IRrecv or IRrecvPCI interrupt routine; on AVR this is read
+                             //from Timer0, so it is a multiple of 64 cycles (4us at 16MHz)
+} irstats_t;
+void IRstats_snapshot(irstats_t *copy);
+void IRstats_clear(void);
+#endif
+
+//Why a decoder turned a frame down; see IRLIB_REJECTIONS and IRLIB_TRACE
+#define IRLIB_REJECT_RAW_COUNT    0 //wrong number of entries; measured is rawlen
+#define IRLIB_REJECT_HEADER_MARK  1
+#define IRLIB_REJECT_HEADER_SPACE 2
+#define IRLIB_REJECT_DATA_MARK    3
+#define IRLIB_REJECT_DATA_SPACE   4
+#define IRLIB_REJECT_TRAILER_BIT  5 //RC5/RC6 double width bit
+#define IRLIB_REJECT_OTHER        6 //any other check, such as a wrong Panasonic identifier
+#define IRLIB_REJECT_INTEGRITY    7 //an integrity check of IRdecodeBase::checks
+#define IRLIB_REJECT_REASONS      8
+
+#ifdef IRLIB_REJECTIONS
+/* Decode rejections. Each time a decoder turns a frame down it adds an entry to a small ring
+ * and counts it in a histogram by protocol and reason. Trying the whole chain on an unknown
+ * frame gives one entry per decoder, so the ring holds the last frame or two. Decoders
+ * outside the library (see the Samsung36 example) are filed under UNKNOWN. Nothing is printed,
+ * so it can stay on; IRrejections_dump prints it all when you ask.
+ */
+#ifndef IR_REJECT_LOG
+#define IR_REJECT_LOG 16 //entries in the ring; must be a power of 2
+#endif
+typedef struct {
+  IR_types_t protocol;
+  uint8_t reason;     //IRLIB_REJECT_...
+  uint8_t offset;     //index into rawbuf of the entry that failed
+  uint16_t measured;  //us; rawbuf[offset], or rawlen for IRLIB_REJECT_RAW_COUNT
+  uint16_t expected;  //us; 0 if there is no single right value
+} irreject_t;
+typedef struct {
+  irreject_t log[IR_REJECT_LOG];
+  uint16_t total;     //entries ever added; log[(total-1)%IR_REJECT_LOG] is the newest
+  uint16_t histogram[LAST_PROTOCOL+1][IRLIB_REJECT_REASONS];
+} irrejections_t;
+extern irrejections_t irrejections;
+void IRrejections_clear(void);
+const __FlashStringHelper *IRreject_reason(uint8_t reason);
+void IRrejections_dump(void); //the ring, newest last, then the histogram, over Serial
+#endif
+
+/* Timing quality. Give IRtimingStats each frame you decode and it keeps, in constant memory,
+ * how its marks and spaces compare with the nominal timings of the protocol (those calibrate
+ * uses): a running mean and variance for each kind of mark and space, by Welford's method,
+ * and the worst deviation per protocol. A worst deviation that creeps toward PERCENT_TOLERANCE,
+ * or jitter that grows, shows a misaligned emitter or a failing receiver before frames are lost.
+ * The classes describe one protocol: the one given to the constructor or, with UNKNOWN, the
+ * first one added. The frame count and worst deviation are kept for every protocol.
+ */
+#define IR_NOMINAL_TIMINGS 5 //most nominal timings of any protocol
+class IRtimingClass
+{
+public:
+  uint16_t nominal;    //us; 0 if the protocol has no such timing
+  uint16_t count;      //stops at 65535
+  uint16_t low, high;  //us; shortest and longest seen
+  float mean;          //us
+  float m2;            //sum of squared differences from the mean
+  void clear(void);
+  void add(uint16_t measured);
+  float variance(void) const {return count>1? m2/(count-1): 0;} //us squared
+  float jitter(void) const {return sqrt(variance());}             //standard deviation, us
+  float bias(void) const {return count? mean-nominal: 0;}         //us
+};
+
+class IRtimingStats
+{
+public:
+  IRtimingStats(IR_types_t protocol=UNKNOWN);
+  bool add(IRdecodeBase *decoder); //after a successful decode(); false if the protocol has no nominal timings
+  void clear(void);                //keeps the protocol the classes describe
+  void dump(void);                 //over Serial
+  IR_types_t protocol;
+  IRtimingClass marks[IR_NOMINAL_TIMINGS], spaces[IR_NOMINAL_TIMINGS]; //by nominal timing of protocol
+  uint16_t frames[LAST_PROTOCOL+1];
+  uint16_t worst[LAST_PROTOCOL+1];       //us; largest difference between an entry and its nominal timing
+  uint8_t worstPercent[LAST_PROTOCOL+1]; //the same, in percent of that timing
+private:
+  void setProtocol(IR_types_t type);
+};
+
 // Some useful constants
 // Decoded value for NEC when a repeat code is received
 #define REPEAT 0xffffffff
@@ -0,0 +1,90 @@
+/* IRLibCombine.cpp from IRLib - an Arduino library for infrared encoding and decoding
+ * Decodes a damaged frame by majority vote over the copies a remote sends of it.
+ * See IRLibCombine.h
+ */
+#include "IRLibCombine.h"
+#include "IRLibMatch.h"
+
+IRcombiner::IRcombiner(uint16_t *buffer, uint8_t frames) {
+  Buffer=buffer;
+  Frames= frames>IR_COMBINE_MAX? IR_COMBINE_MAX: frames;
+  //too few to ever vote; the buffer cannot be assumed to hold IR_COMBINE_MIN, so keep none
+  if(Frames<IR_COMBINE_MIN) Frames=0;
+  clear();
+}
+
+void IRcombiner::clear(void) {
+  group=Next=0;
+  Rawlen=0;
+  Type=UNKNOWN;
+  voted=false;
+  weakest=100; weakIndex=0;
+}
+
+/* The median of entry index over the group. There are IR_COMBINE_MAX at most, so they are
+ * sorted by insertion. With an even count it is the mean of the middle two.
+ */
+uint16_t IRcombiner::vote(uint16_t index) {
+  uint16_t Sorted[IR_COMBINE_MAX];
+  for(uint8_t f=0; f<group; f++) {
+    uint16_t V=Buffer[f*RAWBUF+index];
+    uint8_t j=f;
+    for(; j>0 && Sorted[j-1]>V; j--) Sorted[j]=Sorted[j-1];
+    Sorted[j]=V;
+  }
+  if(group & 1) return Sorted[group/2];
+  return ((uint32_t)Sorted[group/2-1]+Sorted[group/2]+1)/2;
+}
+
+uint8_t IRcombiner::agree(uint16_t index, uint16_t value) {
+  uint8_t Agree=0;
+  for(uint8_t f=0; f<group; f++)
+    if(MATCH(Buffer[f*RAWBUF+index],value)) Agree++;
+  return (uint16_t)Agree*100/group;
+}
+
+uint8_t IRcombiner::confidence(uint16_t index) {
+  if(!group || index>=Rawlen) return 0;
+  return agree(index,vote(index));
+}
+
+bool IRcombiner::decode(IRdecodeBase *decoder) {
+  if(!Frames) return decoder->decode();
+  unsigned long Now=millis();
+  uint16_t Length=decoder->rawlen;
+  if(Length>RAWBUF) Length=RAWBUF;
+  bool Decoded=decoder->decode();
+  if(Length!=Rawlen || Now-Last>IR_COMBINE_GAP
+    || (Decoded && Type!=UNKNOWN && (decoder->decode_type!=Type || decoder->value!=Value))) {
+    group=Next=0; //a new group
+    Type=UNKNOWN;
+  }
+  Rawlen=Length; Last=Now;
+  uint16_t *Slot=Buffer+Next*RAWBUF;
+  for(uint16_t i=0; i<Length; i++) Slot[i]=decoder->rawbuf[i];
+  Next=(Next+1)%Frames;
+  if(group<Frames) group++;
+  voted=false;
+  if(Decoded) {
+    Type=decoder->decode_type; Value=decoder->value;
+    return true;
+  }
+  if(group<IR_COMBINE_MIN) return false;
+  //rawbuf[0] is the gap before the frame and is left as it is
+  uint8_t Weakest=100; uint16_t WeakIndex=0, Changed=0;
+  for(uint16_t i=1; i<Length; i++) {
+    uint16_t Vote=vote(i);
+    uint8_t C=agree(i,Vote);
+    if(C<Weakest) {Weakest=C; WeakIndex=i;}
+    if(!MATCH(Slot[i],Vote)) Changed++;
+    decoder->rawbuf[i]=Vote;
+  }
+  if(Changed>IR_COMBINE_REPAIR) {
+    //more than damage: most likely another key, so the frame is left as it came
+    for(uint16_t i=1; i<Length; i++) decoder->rawbuf[i]=Slot[i];
+    return false;
+  }
+  weakest=Weakest; weakIndex=WeakIndex;
+  voted=true;
+  return decoder->decode();
+}
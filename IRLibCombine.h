@@ -0,0 +1,54 @@
+/* IRLibCombine.h from IRLib - an Arduino library for infrared encoding and decoding
+ * Decodes a damaged frame by majority vote over the copies a remote sends of it.
+ * See CHANGELOG.txt
+ *
+ * Sony sends every code three times, and most remotes resend theirs while a key is held.
+ * Sunlight or a fluorescent lamp can stretch or cut one mark or space of a copy, and a copy
+ * that fails to decode is lost even though the copies before it had that entry right.
+ * IRcombiner keeps the last few frames that had the same number of entries and came in
+ * quick succession. When a frame does not decode by itself, each entry is replaced by the
+ * median of that entry over the frames kept, and the result is decoded instead. With three
+ * copies, any entry that is wrong in only one of them is put right.
+ * Only frames of the same length are combined, so a glitch that splits a mark in two, which
+ * adds entries, is not repaired. A frame that decodes by itself to another code than the
+ * group's starts a new group. A vote is only decoded if the frame differs from it in no more
+ * than IR_COMBINE_REPAIR entries, so that a damaged frame of the next key pressed is not
+ * turned into a copy of the last one. The buffer is yours: frames*RAWBUF entries.
+ */
+
+#ifndef IRLibCombine_h
+#define IRLibCombine_h
+#include "IRLib.h"
+
+#define IR_COMBINE_GAP 250 //ms; a longer pause between frames starts a new group
+#define IR_COMBINE_MIN 3   //frames a group needs before it is voted on
+#define IR_COMBINE_MAX 8   //frames kept at most
+#define IR_COMBINE_REPAIR 1 //entries of a frame the vote may change
+
+class IRcombiner
+{
+public:
+  //buffer holds frames*RAWBUF entries. frames over IR_COMBINE_MAX keeps IR_COMBINE_MAX; under
+  //IR_COMBINE_MIN keeps none, and decode() is then just decoder->decode().
+  IRcombiner(uint16_t *buffer, uint8_t frames);
+  //Instead of decoder->decode(). Keeps the frame, decodes it and, if that fails, decodes the
+  //vote of the group in the decoder's rawbuf.
+  bool decode(IRdecodeBase *decoder);
+  uint8_t confidence(uint16_t index); //percent of the group that agrees, within MATCH, with the vote on entry index
+  void clear(void);
+  bool voted;          //the last decode() took the vote
+  uint8_t group;       //frames in the group
+  uint8_t weakest;     //the lowest confidence of any entry of the last vote
+  uint16_t weakIndex;  //and its entry
+protected:
+  uint16_t *Buffer;
+  uint8_t Frames, Next;
+  uint16_t Rawlen;
+  unsigned long Last;  //millis() of the last frame
+  IR_types_t Type;     //and code of the frames of the group that decoded by themselves; UNKNOWN if none did
+  unsigned long Value;
+  uint16_t vote(uint16_t index);
+  uint8_t agree(uint16_t index, uint16_t value);
+};
+
+#endif //IRLibCombine_h
@@ -0,0 +1,88 @@
+/* IRLibDump.cpp from IRLib - an Arduino library for infrared encoding and decoding
+ * A compact binary dump of received frames that never makes the sketch wait for Serial.
+ * See IRLibDump.h for the record format.
+ */
+#include "IRLibDump.h"
+
+IRdump::IRdump(Print &port) {
+  Port=&port;
+  Head=Count=Building=0;
+  Overflow=false; Seq=0; dropped=0;
+}
+
+void IRdump::put(uint8_t data) {
+  if(Count+Building>=IR_DUMP_BUFFER) {Overflow=true; return;}
+  Buffer[(Head+Count+Building)%IR_DUMP_BUFFER]=data;
+  Building++;
+}
+void IRdump::put16(uint16_t data) {put(data); put(data>>8);}
+void IRdump::put32(uint32_t data) {put16(data); put16(data>>16);}
+
+//zigzag, so that small negative numbers are short too, then 7 bits at a time
+void IRdump::putVarint(int32_t data) {
+  uint32_t Zigzag=((uint32_t)data<<1) ^ (uint32_t)(data>>31);
+  while(Zigzag>=0x80) {put(Zigzag|0x80); Zigzag>>=7;}
+  put(Zigzag);
+}
+
+void IRdump::start(uint8_t type) {
+  Building=0; Overflow=false;
+  put(IR_DUMP_SYNC1); put(IR_DUMP_SYNC2);
+  put(type); put(Seq++);
+  put16(0); //length, filled in by finish
+}
+
+/*
+ * Fills in the length, adds the CRC and hands the record to poll. The CRC is the same
+ * CRC-16/CCITT as IRlink uses, computed bit by bit over the record in the ring.
+ */
+bool IRdump::finish(void) {
+  uint16_t Length=Building-6, Crc=0xFFFF;
+  uint16_t Start=Head+Count;
+  Buffer[(Start+4)%IR_DUMP_BUFFER]=Length;
+  Buffer[(Start+5)%IR_DUMP_BUFFER]=Length>>8;
+  for(uint16_t i=2; !Overflow && i<Building; i++) {
+    Crc^=(uint16_t)Buffer[(Start+i)%IR_DUMP_BUFFER]<<8;
+    for(uint8_t b=0; b<8; b++) Crc= (Crc&0x8000)? (Crc<<1)^0x1021 : Crc<<1;
+  }
+  put16(Crc);
+  if(Overflow) {dropped++; Building=0; return false;}
+  Count+=Building; Building=0;
+  poll();
+  return true;
+}
+
+bool IRdump::add(IRdecodeBase &decoder) {
+  start(IR_DUMP_FRAME);
+  put32(millis());
+  put(decoder.decode_type); put(decoder.bits); put32(decoder.value);
+  put16(decoder.rawlen);
+  for(uint16_t i=0; i<decoder.rawlen && !Overflow; i++)
+    putVarint(i<3 ? (int32_t)decoder.rawbuf[i] : (int32_t)decoder.rawbuf[i]-(int32_t)decoder.rawbuf[i-2]);
+  return finish();
+}
+
+#ifdef USE_ATTACH_INTERRUPTS
+bool IRdump::add(IRfrequency &freq) {
+  start(IR_DUMP_FREQ);
+  put32(millis());
+  put16((uint16_t)(freq.results*100.0+0.5));
+  put(freq.samples>255? 255: freq.samples); //the record has one byte for it
+  return finish();
+}
+#endif
+
+void IRdump::poll(void) {
+#if ARDUINO >= 10606
+  int Room=Port->availableForWrite();
+#else
+  int Room=1; //no availableForWrite on older cores; one byte at a time rarely waits
+#endif
+  while(Count && Room-- > 0) {
+    Port->write(Buffer[Head]);
+    Head=(Head+1)%IR_DUMP_BUFFER;
+    Count--;
+  }
+}
+
+bool IRdump::busy(void) {return Count!=0;}
@@ -0,0 +1,67 @@
+/* IRLibDump.h from IRLib - an Arduino library for infrared encoding and decoding
+ * A compact binary dump of received frames that never makes the sketch wait for Serial.
+ * See CHANGELOG.txt
+ *
+ * dumpResults prints a few hundred characters per frame. At 9600 baud that is longer than
+ * several frames of air time, and the receiver misses codes while it waits. IRdump instead
+ * encodes each frame in about a fifth of the bytes into a buffer of its own. poll(), called
+ * from loop(), moves only what the serial transmit buffer can take without blocking. If the
+ * buffer is full, the frame is dropped and counted, and the sketch never stalls. The port is
+ * asked with availableForWrite() how much it takes; one that always answers 0, as Print does
+ * unless the port overrides it, is never written to.
+ * extras/host/tools/irdump turns the stream back into text, CSV or a replay trace.
+ *
+ * Record:  0xA5 0x5A       sync
+ *          type            IR_DUMP_FRAME or IR_DUMP_FREQ
+ *          sequence        counts up by one per record, dropped ones included
+ *          length          2 bytes, of the body
+ *          body
+ *          CRC-16/CCITT    2 bytes, over type, sequence, length and body
+ * Multi-byte numbers are little endian.
+ * IR_DUMP_FRAME body: millis() 4 bytes, protocol, bits, value 4 bytes, rawlen 2 bytes, then the rawlen
+ *   entries of rawbuf in us. Entries 0 to 2 (gap, header mark and space) are stored as they
+ *   are. Each later one is stored as its difference from the entry two before, which is the
+ *   previous mark or space. All of them are zigzag varints: 7 bits per byte, low bits first,
+ *   top bit set on every byte but the last. Most data entries take one byte.
+ * IR_DUMP_FREQ body: millis() 4 bytes, frequency in units of 10Hz 2 bytes, samples.
+ */
+
+#ifndef IRLibDump_h
+#define IRLibDump_h
+#include "IRLib.h"
+
+#define IR_DUMP_SYNC1 0xA5
+#define IR_DUMP_SYNC2 0x5A
+#define IR_DUMP_FRAME 'R'
+#define IR_DUMP_FREQ  'Q'
+#ifndef IR_DUMP_BUFFER
+#define IR_DUMP_BUFFER 192 //bytes; an NEC frame takes about 105
+#endif
+
+class IRdump
+{
+public:
+  IRdump(Print &port=Serial); //any port: HardwareSerial, or the USB Serial of 32u4 and SAMD boards
+  bool add(IRdecodeBase &decoder); //call after decode(); false if the frame was dropped
+#ifdef USE_ATTACH_INTERRUPTS
+  bool add(IRfrequency &freq);     //call after computeFreq()
+#endif
+  void poll(void);    //call from loop(); writes what the port takes without waiting
+  bool busy(void);    //true while records are waiting to be written
+  uint16_t dropped;   //records that did not fit in the buffer
+protected:
+  Print *Port;
+  uint8_t Buffer[IR_DUMP_BUFFER];
+  uint16_t Head, Count;  //oldest byte not written yet, and how many are waiting
+  uint16_t Building;     //bytes of the record being built, which follow the waiting ones
+  bool Overflow;         //the record being built did not fit
+  uint8_t Seq;
+  void start(uint8_t type);
+  bool finish(void);
+  void put(uint8_t data);
+  void put16(uint16_t data);
+  void put32(uint32_t data);
+  void putVarint(int32_t data);
+};
+
+#endif //IRLibDump_h
@@ -0,0 +1,37 @@
+/* IRLibKeymap.cpp from IRLib - an Arduino library for infrared encoding and decoding
+ * Maps decoded codes to key numbers from a table in flash.
+ * See IRLibKeymap.h for how to write the table.
+ */
+#include "IRLibKeymap.h"
+
+IRkeymap::IRkeymap(const IRkeymapEntry *table, uint16_t count) {
+  Table=table;
+  Count=count;
+}
+
+/* Two binary searches. The first finds the first key of the protocol, which gives the mask,
+ * and the second looks for the masked value among the keys from there on.
+ */
+uint16_t IRkeymap::lookup(IR_types_t protocol, unsigned long value) const {
+  uint16_t Low=0, High=Count;
+  while(Low<High) {
+    uint16_t Mid=(Low+High)/2;
+    if(pgm_read_byte(&Table[Mid].protocol)<protocol) Low=Mid+1; else High=Mid;
+  }
+  if(Low==Count || pgm_read_byte(&Table[Low].protocol)!=protocol) return IR_KEYMAP_NONE;
+  value&=pgm_read_dword(&Table[Low].mask);
+  High=Count;
+  while(Low<High) {
+    uint16_t Mid=(Low+High)/2;
+    if(pgm_read_byte(&Table[Mid].protocol)==protocol && pgm_read_dword(&Table[Mid].value)<value) Low=Mid+1;
+    else High=Mid;
+  }
+  if(Low==Count || pgm_read_byte(&Table[Low].protocol)!=protocol
+    || pgm_read_dword(&Table[Low].value)!=value) return IR_KEYMAP_NONE;
+  return pgm_read_word(&Table[Low].key);
+}
+
+uint16_t IRkeymap::lookup(const IRdecodeBase *decoder) const {
+  if(decoder->decode_type==UNKNOWN) return IR_KEYMAP_NONE;
+  return lookup(decoder->decode_type, decoder->value);
+}
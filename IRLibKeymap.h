@@ -0,0 +1,67 @@
+/* IRLibKeymap.h from IRLib - an Arduino library for infrared encoding and decoding
+ * Maps decoded codes to key numbers from a table in flash.
+ * See CHANGELOG.txt
+ *
+ * Instead of a switch over every code of the remote, list the codes once, in a table:
+ *   enum {KEY_NONE, KEY_LEFT, KEY_RIGHT, KEY_0};  //0 is IR_KEYMAP_NONE
+ *   constexpr IRkeymapEntry My_Keys[] PROGMEM = {
+ *     IRkeymapKey(SONY, 0x46bca, KEY_LEFT),
+ *     IRkeymapKey(SONY, 0x86bca, KEY_RIGHT),
+ *     IRkeymapKey(SONY, 0x90bca, KEY_0)
+ *   };
+ *   static_assert(IRkeymap_valid(My_Keys, IR_KEYMAP_SIZE(My_Keys)), "My_Keys is out of order");
+ *   IRkeymap My_Map(My_Keys, IR_KEYMAP_SIZE(My_Keys));
+ * and after each decode switch over My_Map.lookup(&My_Decoder), or index an array of
+ * functions with it.
+ * The table must be sorted by protocol and then by value, without duplicates. The
+ * static_assert checks that while the sketch compiles, so a misplaced entry is an error
+ * rather than a key that is never found. lookup() is then a binary search: with 500 keys it
+ * takes 9 comparisons at most, whichever key was pressed.
+ * A mask leaves bits, such as the RC5 toggle bit, out of the comparison. All the keys of one
+ * protocol have the same mask, and their values have none of the bits it leaves out.
+ */
+
+#ifndef IRLibKeymap_h
+#define IRLibKeymap_h
+#include "IRLib.h"
+
+#define IR_KEYMAP_NONE 0 //what lookup() returns for a code that is not in the table
+#define IR_KEYMAP_ALL 0xFFFFFFFFUL //the mask that compares every bit
+#define IR_KEYMAP_SIZE(table) (sizeof(table)/sizeof((table)[0]))
+
+typedef struct {
+  IR_types_t protocol;
+  uint32_t value;
+  uint32_t mask;   //bits of the decoded value that are compared
+  uint16_t key;
+} IRkeymapEntry;
+
+constexpr IRkeymapEntry IRkeymapKey(IR_types_t protocol, uint32_t value, uint16_t key,
+  uint32_t mask=IR_KEYMAP_ALL) {
+  return IRkeymapEntry{protocol, value, mask, key};
+}
+
+constexpr bool IRkeymap_before(const IRkeymapEntry &a, const IRkeymapEntry &b) {
+  return a.protocol<b.protocol || (a.protocol==b.protocol && a.mask==b.mask && a.value<b.value);
+}
+
+//True if the table is sorted and its masks are consistent. It halves the table at each
+//level, so the compiler's recursion limit allows tables far larger than any remote.
+constexpr bool IRkeymap_valid(const IRkeymapEntry *table, uint16_t count) {
+  return count<2? (count==0 || (table[0].value & ~table[0].mask)==0u):
+    IRkeymap_valid(table, count/2) && IRkeymap_before(table[count/2-1], table[count/2])
+    && IRkeymap_valid(table+count/2, count-count/2);
+}
+
+class IRkeymap
+{
+public:
+  IRkeymap(const IRkeymapEntry *table, uint16_t count); //table is in PROGMEM
+  uint16_t lookup(IR_types_t protocol, unsigned long value) const; //the key, or IR_KEYMAP_NONE
+  uint16_t lookup(const IRdecodeBase *decoder) const;              //of the frame decoded
+protected:
+  const IRkeymapEntry *Table;
+  uint16_t Count;
+};
+
+#endif //IRLibKeymap_h
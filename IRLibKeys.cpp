@@ -0,0 +1,113 @@
+/* IRLibKeys.cpp from IRLib - an Arduino library for infrared encoding and decoding
+ * Key press, hold and release events from decoded frames.
+ * See IRLibKeys.h for how each protocol repeats.
+ */
+#include "IRLibKeys.h"
+
+/* How each protocol repeats a held key. release is a little more than the longest time
+ * between two frames of a held key, so a release is reported that long after the last one.
+ * extra is the number of frames every press sends beyond the first, which are not holds.
+ */
+typedef struct {
+  uint16_t release; //ms
+  uint8_t extra;
+} IRkeyTiming;
+
+static const IRkeyTiming IRkeyTimings[LAST_PROTOCOL+1] PROGMEM = {
+  {200, 0}, //UNKNOWN, not used
+  {160, 0}, //NEC: REPEAT frames every 108ms
+  {100, 2}, //SONY: a frame every 45ms, at least three per press
+  {170, 0}, //RC5: every 114ms
+  {170, 0}, //RC6: every 114ms
+  {170, 0}, //PANASONIC_OLD
+  {120, 1}, //JVC: header-less frames every 60ms or so; IRsendJVC follows every frame with one
+  {160, 0}, //NECX: every 108ms
+  {190, 0}, //PANASONIC_NEW: every 130ms or so
+  {160, 0}, //SAMSUNG32: every 108ms
+  {200, 0}  //HASH_CODE
+};
+
+uint16_t IRkey_releaseTime(IR_types_t type) {
+  if(type>LAST_PROTOCOL) type=UNKNOWN;
+  return pgm_read_word(&IRkeyTimings[type].release);
+}
+
+static uint8_t IRkey_extra(IR_types_t type) {
+  if(type>LAST_PROTOCOL) return 0;
+  return pgm_read_byte(&IRkeyTimings[type].extra);
+}
+
+//RC5: the bit after the field bit. RC6: the trailer bit, which follows the three mode bits.
+unsigned long IRkey_toggle(IR_types_t type, uint8_t bits) {
+  if(type==RC5 && bits>=2) return 1UL<<(bits-2);
+  if(type==RC6 && bits>=4) return 1UL<<(bits-4);
+  return 0;
+}
+
+IRkeys::IRkeys(void) {
+  clear();
+}
+
+void IRkeys::clear(void) {
+  Head=Count=0;
+  Held=false;
+  dropped=0;
+}
+
+void IRkeys::push(IRkeyAction action) {
+  if(Count==IR_KEY_QUEUE) {
+    if(dropped<255) dropped++;
+    return;
+  }
+  IRkeyEvent *E=&Queue[(Head+Count)%IR_KEY_QUEUE];
+  Count++;
+  uint8_t Extra=IRkey_extra(Type);
+  E->action=action;
+  E->protocol=Type;
+  E->value=Key;
+  E->repeats= Frames>Extra? Frames-Extra: 0;
+  E->period= Frames? (Last-First)/Frames: 0;
+  E->duration=Last-First;
+}
+
+void IRkeys::release(void) {
+  push(IR_KEY_RELEASE);
+  Held=false;
+}
+
+void IRkeys::add(IRdecodeBase *decoder) {
+  unsigned long Now=millis();
+  if(Held && Now-Last>IRkey_releaseTime(Type)) release();
+  IR_types_t NewType=decoder->decode_type;
+  if(NewType==UNKNOWN) return;
+  unsigned long Value=decoder->value;
+  if(NewType==NEC && Value==REPEAT) {
+    //only ever follows an NEC frame; Samsung32 frames decode as NEC too
+    if(!Held || Type!=NEC) return;
+  } else {
+    unsigned long Bit=IRkey_toggle(NewType,decoder->bits);
+    if(!Held || NewType!=Type || (Value & ~Bit)!=Key || (Value & Bit)!=Toggle) {
+      if(Held) release();
+      Held=true;
+      Type=NewType;
+      Key=Value & ~Bit;
+      Toggle=Value & Bit;
+      Frames=0;
+      First=Last=Now;
+      push(IR_KEY_PRESS);
+      return;
+    }
+  }
+  Last=Now;
+  if(Frames<0xFFFF) Frames++;
+  if(Frames>IRkey_extra(Type)) push(IR_KEY_HOLD);
+}
+
+bool IRkeys::getEvent(IRkeyEvent *event) {
+  if(Held && millis()-Last>IRkey_releaseTime(Type)) release();
+  if(!Count) return false;
+  *event=Queue[Head];
+  Head=(Head+1)%IR_KEY_QUEUE;
+  Count--;
+  return true;
+}
@@ -0,0 +1,64 @@
+/* IRLibKeys.h from IRLib - an Arduino library for infrared encoding and decoding
+ * Key press, hold and release events from decoded frames.
+ * See CHANGELOG.txt
+ *
+ * A remote repeats while a key is held, and every protocol does it its own way: NEC sends
+ * REPEAT frames, JVC sends the code again without a header, Sony sends every code at least
+ * three times, and RC5 and RC6 send the same code and flip a toggle bit on each new press.
+ * IRkeys takes care of all of that. Give it every frame you decode and it reports:
+ *   IR_KEY_PRESS    the first frame of a key
+ *   IR_KEY_HOLD     each further frame while the key is held, with the count and rate
+ *   IR_KEY_RELEASE  once no frame of the key came for the protocol's release time, or
+ *                   another key was pressed
+ * A Sony press that only sends its three frames is a press and a release, without holds, and
+ * so is a JVC press that sends its frame and the one header-less repeat that follows it.
+ * A REPEAT frame with no key held, as when its first frame was lost, is ignored. So is a
+ * frame that did not decode.
+ * Events wait in a small queue until getEvent() takes them. Call it from loop() even when no
+ * frame came, because that is where releases are found.
+ */
+
+#ifndef IRLibKeys_h
+#define IRLibKeys_h
+#include "IRLib.h"
+
+#define IR_KEY_QUEUE 4 //events; a frame makes at most two (release and press)
+
+enum IRkeyAction {IR_KEY_NONE, IR_KEY_PRESS, IR_KEY_HOLD, IR_KEY_RELEASE};
+
+typedef struct {
+  IRkeyAction action;
+  IR_types_t protocol;
+  unsigned long value;    //the key's code, with RC5 and RC6 toggle bits cleared
+  uint16_t repeats;       //hold: holds so far, 1 for the first; release: all of them
+  uint16_t period;        //ms between frames of the key, averaged since the press; 0 on press
+  unsigned long duration; //ms since the press; on release, to the last frame of the key
+} IRkeyEvent;
+
+class IRkeys
+{
+public:
+  IRkeys(void);
+  void add(IRdecodeBase *decoder); //after each decode(), whatever it returned
+  bool getEvent(IRkeyEvent *event); //from loop(); true if there was an event, which is removed
+  void clear(void);                //forgets the key held and any waiting events
+  uint8_t dropped;                 //events lost because the queue was full; stops at 255
+protected:
+  IRkeyEvent Queue[IR_KEY_QUEUE];
+  uint8_t Head, Count;
+  bool Held;             //a key is down; Key describes it
+  IR_types_t Type;
+  unsigned long Key;     //without the toggle bit
+  unsigned long Toggle;  //the toggle bit of the last frame
+  uint16_t Frames;       //frames of the key after the first
+  unsigned long First, Last; //millis() of the first and last frame
+  void push(IRkeyAction action);
+  void release(void);
+};
+
+//RC5 or RC6 toggle bit of a code of that many bits; 0 for other protocols
+unsigned long IRkey_toggle(IR_types_t type, uint8_t bits);
+//ms without a frame after which a held key of that protocol is released
+uint16_t IRkey_releaseTime(IR_types_t type);
+
+#endif //IRLibKeys_h
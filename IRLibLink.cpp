@@ -0,0 +1,184 @@
+/* IRLibLink.cpp from IRLib - an Arduino library for infrared encoding and decoding
+ * A framed data link for sending arbitrary bytes between two Arduinos over IR.
+ * See IRLibLink.h for the frame format.
+ */
+#include "IRLibLink.h"
+#include "IRLibMatch.h"
+#include "IRLibRData.h"
+
+IRlink::IRlink(uint8_t *rxBuffer, uint16_t rxSize) {
+  RxBuffer=rxBuffer; RxSize=rxSize; RxLen=0;
+  RxComplete=RxDropping=false; RxSeq=0xFF;
+  unit=IR_LINK_UNIT; khz=IR_LINK_KHZ; crc16=true;
+  useAck=false; retries=3; ackTimeout=250;
+  failed=false; crcErrors=0; control=0;
+  TxData=NULL; TxLen=TxPos=0; TxSeq=0; TxFrameLen=0; TxTries=0;
+  TxWaiting=false;
+}
+
+uint8_t IRlink::maxPayload(void) {
+  int Bytes=IR_LINK_FRAME_BYTES - 2 - (crc16? 2:1);
+  return constrain(Bytes, 0, 255);
+}
+
+/*
+ * CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) or CRC-8 (polynomial 0x07, initial
+ * value 0). Pass the result of the previous call to continue over more data. Computed bit by
+ * bit; a table would cost 512 bytes of flash to save a few hundred microseconds per frame,
+ * which is nothing next to the time the frame spends in the air.
+ */
+uint16_t IRlink::crc(uint16_t Crc, const uint8_t *data, uint8_t len) {
+  for(uint8_t i=0; i<len; i++) {
+    if(crc16) {
+      Crc^= (uint16_t)data[i] << 8;
+      for(uint8_t b=0; b<8; b++) Crc= (Crc & 0x8000)? (Crc<<1) ^ 0x1021: Crc<<1;
+    } else {
+      Crc^= data[i];
+      for(uint8_t b=0; b<8; b++) Crc= (Crc & 0x80)? ((Crc<<1) ^ 0x07) & 0xFF: (Crc<<1) & 0xFF;
+    }
+  }
+  return Crc;
+}
+
+void IRlink::sendByte(uint8_t data) {
+  for(uint8_t i=0; i<4; i++) {
+    mark(unit); space(unit*(1+(data>>6)));
+    data<<=2;
+  }
+}
+
+void IRlink::sendFrame(uint8_t controlByte, const uint8_t *data, uint8_t len) {
+  uint8_t Head[2]={controlByte,len};
+  uint16_t Crc=crc(crc(crc16? 0xFFFF:0, Head, 2), data, len);
+  Extent=0;
+  enableIROut(khz);
+  mark(unit*IR_LINK_HEAD_MARK); space(unit*IR_LINK_HEAD_SPACE);
+  sendByte(controlByte); sendByte(len);
+  for(uint8_t i=0; i<len; i++) sendByte(data[i]);
+  if(crc16) sendByte(Crc>>8);
+  sendByte(Crc & 0xFF);
+  mark(unit);
+  space(LONG_SPACE_US+unit); //long enough for any receiver to end the frame
+}
+
+/*
+ * Without acknowledgement the whole message is sent here, one frame after the other, and
+ * write returns when it is done. With useAck only the first frame is sent. Each ACK that
+ * decode receives sends the next one and poll repeats a frame whose ACK does not arrive
+ * in time. The data must stay unchanged until busy() returns false.
+ */
+bool IRlink::write(const uint8_t *data, uint16_t len) {
+  if(busy()) return false;
+  TxData=data; TxLen=len; TxPos=0; TxTries=0;
+  failed=false;
+  if(useAck) {
+    sendNext();
+    return true;
+  }
+  do sendNext(); while(TxPos<TxLen);
+  return true;
+}
+
+bool IRlink::busy(void) {
+  return TxWaiting;
+}
+
+//Sends the frame starting at TxPos; without acknowledgement it is considered delivered right away
+void IRlink::sendNext(void) {
+  uint16_t Left=TxLen-TxPos;
+  uint8_t Max=maxPayload();
+  uint8_t Control=(TxSeq<<4) & 0xF0;
+  TxFrameLen= (Left>Max)? Max: Left;
+  if(TxPos==0) Control|=IR_LINK_FIRST;
+  if(TxPos+TxFrameLen<TxLen) Control|=IR_LINK_MORE;
+  if(useAck) Control|=IR_LINK_NEEDACK;
+  sendFrame(Control, TxData+TxPos, TxFrameLen);
+  if(useAck) {
+    TxWaiting=true; TxTime=millis();
+  } else {
+    TxPos+=TxFrameLen; TxSeq=(TxSeq+1) & 0x0F;
+  }
+}
+
+void IRlink::poll(void) {
+  if(!TxWaiting || millis()-TxTime < ackTimeout) return;
+  if(TxTries>=retries) {
+    TxWaiting=false; failed=true;
+    return;
+  }
+  TxTries++;
+  sendNext();
+}
+
+/*
+ * Symbols are told apart by the length of mark plus space, rounded to whole units.
+ * Mark_Excess moves time from the space to the mark but leaves the sum alone.
+ */
+bool IRlink::decode(void) {
+  uint8_t Frame[IR_LINK_FRAME_BYTES];
+  uint8_t Bytes, CrcBytes= crc16? 2:1;
+  IRLIB_ATTEMPT_MESSAGE(F("Link"));
+  if(rawlen<4+8*(2+CrcBytes) || (rawlen-4)%8) return RAW_COUNT_ERROR;
+  Bytes=(rawlen-4)/8;
+  offset=1;
+  if(!MATCH(rawbuf[offset],unit*IR_LINK_HEAD_MARK)) return HEADER_MARK_ERROR(unit*IR_LINK_HEAD_MARK);
+  offset++;
+  if(!MATCH(rawbuf[offset],unit*IR_LINK_HEAD_SPACE)) return HEADER_SPACE_ERROR(unit*IR_LINK_HEAD_SPACE);
+  offset++;
+  for(uint8_t i=0; i<Bytes; i++) {
+    uint8_t Data=0;
+    for(uint8_t j=0; j<4; j++) {
+      unsigned int Units=(rawbuf[offset]+rawbuf[offset+1]+unit/2)/unit;
+      if(Units<2 || Units>5) return DATA_SPACE_ERROR(unit*3);
+      Data=(Data<<2) | (Units-2);
+      offset+=2;
+    }
+    Frame[i]=Data;
+  }
+  uint16_t Crc=Frame[Bytes-1];
+  if(crc16) Crc|=(uint16_t)Frame[Bytes-2]<<8;
+  if(Frame[1]!=Bytes-2-CrcBytes || crc(crc16? 0xFFFF:0, Frame, Bytes-CrcBytes)!=Crc) {
+    crcErrors++;
+    return IRLIB_REJECTION_MESSAGE(F("link length or CRC"));
+  }
+  control=Frame[0];
+  uint8_t Seq=control>>4;
+  if(control & IR_LINK_ACK) {
+    if(TxWaiting && Seq==TxSeq) {
+      TxWaiting=false;
+      TxPos+=TxFrameLen; TxSeq=(TxSeq+1) & 0x0F; TxTries=0;
+      if(TxPos<TxLen) sendNext();
+    }
+    return true;
+  }
+  if(control & IR_LINK_NEEDACK) {
+    sendFrame(IR_LINK_ACK | (control & 0xF0), NULL, 0);
+    if(Seq==RxSeq) return true; //our ACK got lost and this is a repeat
+  }
+  if(control & IR_LINK_FIRST) {
+    RxLen=0; RxComplete=RxDropping=false;
+  } else if(Seq!=((RxSeq+1) & 0x0F)) {
+    RxDropping=true; //lost a frame in between
+  }
+  RxSeq=Seq;
+  if(RxComplete) return true; //stray frame after the end of a message
+  if(RxLen+Frame[1]>RxSize) RxDropping=true;
+  if(!RxDropping) {
+    memcpy(RxBuffer+RxLen, Frame+2, Frame[1]);
+    RxLen+=Frame[1];
+    if(!(control & IR_LINK_MORE)) RxComplete=true;
+  }
+  return true;
+}
+
+bool IRlink::available(void) {
+  return RxComplete;
+}
+
+uint16_t IRlink::read(uint8_t *data, uint16_t size) {
+  if(!RxComplete) return 0;
+  uint16_t Len= (RxLen>size)? size: RxLen;
+  memcpy(data, RxBuffer, Len);
+  RxComplete=false;
+  return Len;
+}
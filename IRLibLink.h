@@ -0,0 +1,82 @@
+/* IRLibLink.h from IRLib - an Arduino library for infrared encoding and decoding
+ * A framed data link for sending arbitrary bytes between two Arduinos over IR.
+ * See CHANGELOG.txt
+ *
+ * Remote control protocols carry 12 to 32 bits per frame with long lead-outs. The link
+ * instead uses two bits per mark/space pair in the manner of Phillips RC-MM (see the rcmm
+ * example). Every mark is one unit long and the space after it is 1 to 4 units, so a pair
+ * is 2 to 5 units. The receiver only looks at the sum of mark and space, which does not
+ * change with Mark_Excess.
+ *
+ * Frame:  header mark 8 units, space 4 units
+ *         control byte   sequence number in the upper nibble, IR_LINK_ flags in the lower
+ *         length byte    number of payload bytes in this frame
+ *         payload
+ *         CRC-16/CCITT (or CRC-8 if crc16 is false) over control, length and payload
+ *         stop mark 1 unit, then at least LONG_SPACE_US of space so the receiver sees the end
+ * Bytes are sent most significant bits first, four symbols per byte.
+ *
+ * A message longer than one frame is split into several, the first with IR_LINK_FIRST and
+ * all but the last with IR_LINK_MORE. How much fits in a frame depends on RAWBUF, because
+ * the receivers have to hold the whole frame. Both ends must use the same unit, carrier,
+ * CRC and RAWBUF.
+ */
+
+#ifndef IRLibLink_h
+#define IRLibLink_h
+#include "IRLib.h"
+
+#define IR_LINK_UNIT 300 //us; default length of one unit; keep it above MINIMUM_TIME_GAP_PERMITTED plus your receiver's minimum burst length
+#define IR_LINK_KHZ 38   //default carrier
+#define IR_LINK_HEAD_MARK 8 //units
+#define IR_LINK_HEAD_SPACE 4 //units
+
+//control byte flags
+#define IR_LINK_MORE    0x01 //another frame of this message follows
+#define IR_LINK_FIRST   0x02 //first frame of a message
+#define IR_LINK_NEEDACK 0x04 //the receiver must answer with an IR_LINK_ACK frame
+#define IR_LINK_ACK     0x08 //acknowledges the frame with the same sequence number
+
+//Bytes per frame that fit in the receive buffer: gap, header mark and space, 8 entries per byte and the
+//stop mark. The receivers keep the last buffer entry free, hence 5 rather than 4.
+#define IR_LINK_FRAME_BYTES ((RAWBUF-5)/8)
+
+class IRlink: public virtual IRdecodeBase, public virtual IRsendBase
+{
+public:
+  //Received messages are reassembled in a buffer created by your sketch
+  IRlink(uint8_t *rxBuffer, uint16_t rxSize);
+  //settings; both ends must agree on unit, khz and crc16
+  unsigned int unit;        //us
+  unsigned char khz;        //carrier frequency
+  bool crc16;               //CRC-16 if true, CRC-8 if false
+  bool useAck;              //request an acknowledgement for every frame and retry without one
+  uint8_t retries;          //number of times a frame is repeated before giving up
+  unsigned int ackTimeout;  //ms to wait for an acknowledgement
+  //sending
+  bool write(const uint8_t *data, uint16_t len);
+  bool busy(void);          //true until the last frame of the last write has been acknowledged
+  void poll(void);          //call from loop() when useAck is true; repeats frames that were not acknowledged
+  bool failed;              //true if the last write gave up after retries
+  uint8_t maxPayload(void); //payload bytes per frame
+  void sendFrame(uint8_t control, const uint8_t *data, uint8_t len);
+  //receiving
+  virtual bool decode(void); //true if rawbuf holds a valid link frame; call after your receiver's getResults
+  bool available(void);     //true when a complete message has been reassembled
+  uint16_t read(uint8_t *data, uint16_t size); //copies the message out and returns its length
+  uint8_t control;          //control byte of the last decoded frame
+  uint16_t crcErrors;       //frames that looked like link frames but failed the CRC or length check
+protected:
+  void sendByte(uint8_t data);
+  void sendNext(void);
+  uint16_t crc(uint16_t Crc, const uint8_t *data, uint8_t len);
+  uint8_t *RxBuffer; uint16_t RxSize, RxLen;
+  bool RxComplete, RxDropping;
+  uint8_t RxSeq;            //sequence number of the last frame accepted, 0xFF for none
+  const uint8_t *TxData; uint16_t TxLen, TxPos;
+  uint8_t TxSeq, TxFrameLen, TxTries;
+  bool TxWaiting;           //a frame has been sent and its acknowledgement is due
+  unsigned long TxTime;     //millis() when it was sent
+};
+
+#endif //IRLibLink_h
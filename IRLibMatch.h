@@ -65,6 +65,12 @@ your receiver, run the "IRanalyze.ino" sketch and carefully compare your outputs
 should be getting for your particular protocol. You can find the timing values for each 
 protocol in the decode functions of this library, ex: "IRdecodeNEC::decode" lists the timing
 values used when decoding the very popular NEC protocol. 
+Instead of tuning it by hand you can call My_Receiver.calibrate(&My_Decoder) after each
+successful decode(). It compares every mark and space of the frame with the nominal timings of
+the protocol, and moves Mark_Excess 1/2^IR_CALIBRATE_SHIFT of the way toward the skew it finds,
+within MARK_EXCESS_MIN and MARK_EXCESS_MAX. Mark_Excess then follows the receiver you actually
+have, its temperature and its age. It can only learn from frames that still decode, so start
+from a value that works.
 */
 
 //============================================================================================
@@ -73,10 +79,17 @@ values used when decoding the very popular NEC protocol.
 #define USEC_PER_TICK 50  //us; microseconds per clock interrupt tick
 #define PERCENT_TOLERANCE 25  //%; percent tolerance in measurements
 #define MARK_EXCESS_DEFAULT 50 //us; Mark_Excess; see notes above.
+#define MARK_EXCESS_MIN -100 //us; IRrecvBase::calibrate keeps Mark_Excess at or above this
+#define MARK_EXCESS_MAX 150  //us; and at or below this
+#define IR_CALIBRATE_SHIFT 3 //calibrate moves Mark_Excess 1/8 of the way to each frame's estimate
 #define DEFAULT_ABS_TOLERANCE 125 //us; absolute tolerance in microseconds
 #define MINIMUM_TIME_GAP_PERMITTED 150 //us; minimum Mark or Space period permitted; GS: for use in IRrecv & IRrecvPCI: if a Mark or Space is less than this value I will filter it out, as if it never occurred. Note: Looking in the IRremote library, file "ir_Mitsubishi.cpp," I see that MITSUBISHI_HDR_MARK is only 250us, and in "ir_Sharp.cpp," SHARP_BIT_MARK is 245us, so I wouldn't recommend making this value much above 150us. Keep it below 0.75 * the_smallest_mark_or_space_for_any_valid_IR_protocol for sure, or you risk filtering out valid data. 0.75 * 245 = 183.75us, so keep "MINIMUM_TIME_GAP_PERMITTED" below that. 
 #define LONG_SPACE_US 7800 //us; minimum long Space (IR receiver HIGH time) between IR transmissions; NB: GS note: this value should be >= ~1.25 * the_largest_space_any_valid_IR_protocol_might_have. The largest Space in any valid IR protocol that I can find is 6200us for "DISH_RPT_SPACE" in the Dish protocol (see IRremote library, ir_Dish.cpp). 1.25 * 6200 = 7750us, so 7800us is a good value to choose.
 
+#define ECHO_TOLERANCE_US 500 //us; a received frame is our own transmission (self-echo) if it has the same number of marks as a frame we just sent and starts and ends within this much of it. Covers the receiver's delay, IRrecv's 50us ticks and Mark_Excess.
+#define IR_CARRIER_TOLERANCE 1 //kHz; IRdecode::decode first tries the protocols whose carrier (IRcarrier) is within this of the measured one, and the rest only if none of those decodes. 1 tells 36, 38, 40 and 57kHz apart.
+#define IR_CARRIER_MIN_SAMPLES 32 //IRfrequency::pair reports no carrier (0) from fewer usable intervals than this
+
 //For conversions from microseconds to 50-us-interval clock "ticks":
 #define US_TO_TICKS(us) (us/USEC_PER_TICK) //converts from units of us to 50us counts, or clock "ticks" 
 
@@ -103,20 +116,43 @@ values used when decoding the very popular NEC protocol.
 #define MATCH_MARK(t,u) MATCH(t,u)
 #define MATCH_SPACE(t,u) MATCH(t,u)
 
+//IRLIB_ATTEMPT(type,s) starts a decoder of the library, and the rejections that follow are filed
+//under type. Decoders that use IRLIB_ATTEMPT_MESSAGE instead are filed under UNKNOWN.
+#ifdef IRLIB_REJECTIONS
+extern IR_types_t IRreject_protocol;
+#define IRLIB_ATTEMPT(type,s) {IRLIB_ATTEMPT_MESSAGE(s); IRreject_protocol=(type);}
+#else
+#define IRLIB_ATTEMPT(type,s) IRLIB_ATTEMPT_MESSAGE(s)
+#endif
+
 #ifdef IRLIB_TRACE
 void IRLIB_ATTEMPT_MESSAGE(const __FlashStringHelper * s);
 void IRLIB_TRACE_MESSAGE(const __FlashStringHelper * s);
-byte IRLIB_REJECTION_MESSAGE(const __FlashStringHelper * s);
-byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected);
-#define RAW_COUNT_ERROR IRLIB_REJECTION_MESSAGE(F("number of raw samples"));
-#define HEADER_MARK_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("header mark"),offset,irparams.rawbuf1[offset],expected);
-#define HEADER_SPACE_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("header space"),offset,irparams.rawbuf1[offset],expected);
-#define DATA_MARK_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("data mark"),offset,irparams.rawbuf1[offset],expected);
-#define DATA_SPACE_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("data space"),offset,irparams.rawbuf1[offset],expected);
-#define TRAILER_BIT_ERROR(expected) IRLIB_DATA_ERROR_MESSAGE(F("RC5/RC6 trailer bit length"),offset,irparams.rawbuf1[offset],expected);
+#define IRLIB_REJECT_TEXT(s) (s)
+#else
+#ifdef IRLIB_REJECTIONS
+#define IRLIB_ATTEMPT_MESSAGE(s) (IRreject_protocol=UNKNOWN)
 #else
 #define IRLIB_ATTEMPT_MESSAGE(s)
+#endif
 #define IRLIB_TRACE_MESSAGE(s)
+#define IRLIB_REJECT_TEXT(s) NULL //only IRLIB_TRACE prints the text, so keep it out of flash
+#endif
+
+//The errors return false from the decoder, after IRLIB_TRACE printed them and/or IRLIB_REJECTIONS
+//recorded them
+#if defined(IRLIB_TRACE) || defined(IRLIB_REJECTIONS)
+byte IRLIB_REJECT(uint8_t reason, const __FlashStringHelper * s, unsigned char index, unsigned int value, unsigned int expected);
+#define IRLIB_REJECTION_MESSAGE(s) IRLIB_REJECT(IRLIB_REJECT_OTHER,IRLIB_REJECT_TEXT(s),0,0,0)
+#define IRLIB_DATA_ERROR_MESSAGE(s,i,v,e) IRLIB_REJECT(IRLIB_REJECT_OTHER,IRLIB_REJECT_TEXT(s),i,v,e)
+#define RAW_COUNT_ERROR IRLIB_REJECT(IRLIB_REJECT_RAW_COUNT,IRLIB_REJECT_TEXT(F("number of raw samples")),0,rawlen,0);
+#define HEADER_MARK_ERROR(expected) IRLIB_REJECT(IRLIB_REJECT_HEADER_MARK,IRLIB_REJECT_TEXT(F("header mark")),offset,rawbuf[offset],expected);
+#define HEADER_SPACE_ERROR(expected) IRLIB_REJECT(IRLIB_REJECT_HEADER_SPACE,IRLIB_REJECT_TEXT(F("header space")),offset,rawbuf[offset],expected);
+#define DATA_MARK_ERROR(expected) IRLIB_REJECT(IRLIB_REJECT_DATA_MARK,IRLIB_REJECT_TEXT(F("data mark")),offset,rawbuf[offset],expected);
+#define DATA_SPACE_ERROR(expected) IRLIB_REJECT(IRLIB_REJECT_DATA_SPACE,IRLIB_REJECT_TEXT(F("data space")),offset,rawbuf[offset],expected);
+#define TRAILER_BIT_ERROR(expected) IRLIB_REJECT(IRLIB_REJECT_TRAILER_BIT,IRLIB_REJECT_TEXT(F("RC5/RC6 trailer bit length")),offset,rawbuf[offset],expected);
+#define INTEGRITY_ERROR IRLIB_REJECT(IRLIB_REJECT_INTEGRITY,IRLIB_REJECT_TEXT(F("integrity check")),0,0,0)
+#else
 #define IRLIB_REJECTION_MESSAGE(s) false
 #define IRLIB_DATA_ERROR_MESSAGE(s,i,v,e) false
 #define RAW_COUNT_ERROR false
@@ -125,6 +161,7 @@ byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index
 #define DATA_MARK_ERROR(expected) false
 #define DATA_SPACE_ERROR(expected) false
 #define TRAILER_BIT_ERROR(expected) false
+#define INTEGRITY_ERROR false
 #endif
 
 //For identifying Marks & Spaces in IR codes:
@@ -144,4 +181,43 @@ byte IRLIB_DATA_ERROR_MESSAGE(const __FlashStringHelper * s, unsigned char index
 #define PROFILE_PIN3_HIGH   PORTD |= _BV(3) //write Arduino pin D3 HIGH
 #define PROFILE_PIN3_LOW    PORTD &= ~_BV(3) //write Arduino pin D3 LOW
 
+//FOR CYCLE PROFILING UNDER A SIMULATOR (see extras/avr-bench)
+//-with IRLIB_PROFILE defined, each ISR writes its IRLIB_PROFILE_ id to GPIOR0 on entry, a second id if it
+//takes the end-of-frame path, and 0 when it is done. The simulator counts the cycles from the first
+//write to the 0 and files them under the last id. GPIOR0 is unused by Arduino, and a write is one "out"
+//instruction (1 cycle). ISR prologue and epilogue are outside the measurement.
+#ifdef IRLIB_PROFILE
+#define IRLIB_PROFILE_MARK(id) (GPIOR0 = (id))
+#else
+#define IRLIB_PROFILE_MARK(id)
+#endif
+#define IRLIB_PROFILE_END      0
+#define IRLIB_PROFILE_TICK     1 //ISR(IR_RECV_INTR_NAME)
+#define IRLIB_PROFILE_TICK_EOF 2 //  that found the end of a frame
+#define IRLIB_PROFILE_PCI      3 //IRrecvPCI_Handler
+#define IRLIB_PROFILE_PCI_EOF  4 //  that found the end of a frame
+#define IRLIB_PROFILE_FREQ     5 //IRfreqISR
+
+//RECEIVE STATISTICS (see irstats_t in IRLib.h)
+//-IRLIB_STATS_ISR_START/END go at the entry and every exit of a receive ISR to track maxISRCycles.
+// On AVR they read Timer0, which Arduino runs at F_CPU/64 for millis(); elsewhere micros().
+#ifdef IRLIB_STATS
+#define IRLIB_STATS_INC(counter) (irstats.counter++)
+#ifdef __AVR__
+#define IRLIB_STATS_CLOCK() TCNT0
+#define IRLIB_STATS_CYCLES_PER_CLOCK 64
+typedef uint8_t irstats_clock_t;
+#else
+#define IRLIB_STATS_CLOCK() micros()
+#define IRLIB_STATS_CYCLES_PER_CLOCK (F_CPU/1000000L)
+typedef unsigned long irstats_clock_t;
+#endif
+#define IRLIB_STATS_ISR_START irstats_clock_t Stats_ISR_Start = IRLIB_STATS_CLOCK()
+#define IRLIB_STATS_ISR_END IRstats_ISRDone(Stats_ISR_Start)
+#else
+#define IRLIB_STATS_INC(counter) ((void)0)
+#define IRLIB_STATS_ISR_START
+#define IRLIB_STATS_ISR_END
+#endif
+
 #endif //IRLibMatch_h
\ No newline at end of file
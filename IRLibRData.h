@@ -75,6 +75,7 @@ typedef struct {
   bool interruptIsDetached; //true if the ISR's interrupt handler is detached; ie: the interrupt is no longer occurring at all
   volatile uint16_t* volatile rawbuf2; //GS added; a volatile pointer to volatile data--an extra buffer; this will become the *secondary* buffer, written do by the IRrecvPCI ISR, for example, while rawbuf1 will remain the *primary* buffer, accessed directly during decoding. This pointer will point to an external buffer that the user must create in their main sketch for use with IRrecvPCI; the user will pass this buffer in via the IRdecodeBase::useDoubleBuffer method. 
   uint16_t rawlen2; //corresponds to the length of rawbuf2, above; used by IRrecvPCI when double-buffered 
+  unsigned long frameEndTime; //micros() at the end of the last mark of the frame in rawbuf1; set along with rawlen1, used to recognise self-echo 
   bool dataStateChangedToReady; //GS added; IR code buffer *change* state: true if dataStateIsReady (found inside checkForEndOfIRCode()) just made a transition from false to true; false otherwise. This may seem redundant, but it is not. dataStateIsReady indicates the present state, dataStateChangedToReady indicates state transitions. We only want My_Receiver.getResults to return true if the data state *transitioned* from false to true (ie: dataStateChangedToReady==true), so that we only decode a given set of data once. If getResults returned true just because dataStateIsready==true, then if you rapidly called getResults again and again it would keep wasting time decoding and returning the same set of data again and again, rather than decoding and returning each set of data only *once.* 
   
   //for LED blinking 
@@ -85,4 +86,31 @@ typedef struct {
 } 
 irparams_t;
 extern volatile irparams_t irparams;
+#ifdef IRLIB_STATS
+extern volatile irstats_t irstats; //see IRLib.h; only ever incremented inside the ISRs
+#endif
+
+/*
+ * When the receive interrupt keeps running while we send, the receiver also picks up our own
+ * transmission. IRsendBase logs the last few frames it sent here, one entry per burst of
+ * marks without a space of LONG_SPACE_US or more in between, which is the way the receivers
+ * split frames. IRrecvBase::isSelfEcho compares a received frame against this log.
+ * Only the first mark of a frame reads micros(); the end is the start plus the durations sent
+ * since, so each further mark and space costs a couple of additions.
+ * It is only used outside of ISRs so it need not be volatile.
+ */
+#define IR_ECHO_FRAMES 4
+typedef struct {
+  unsigned long start;  //micros() at the start of the first mark
+  unsigned long length; //us from the start to the end of the last mark
+  uint16_t marks;       //number of marks; 0 means unused
+} irecho_frame_t;
+
+typedef struct {
+  irecho_frame_t frame[IR_ECHO_FRAMES];
+  unsigned long sent; //us of marks and spaces sent since frame[last] started
+  uint8_t last;  //index of the frame being sent or most recently sent
+  bool open;     //true while marks are still being added to frame[last]
+} irecho_t;
+extern irecho_t irecho;
 #endif
@@ -91,6 +91,10 @@
 /* Pinoccio Scout */
 #elif defined(__AVR_ATmega256RFR2__)
 	#define IR_SEND_TIMER3		3
+/* Linux host build (see extras/host). There are no timers; the virtual hardware in
+ * extras/host/hal supplies the carrier and the 50us tick. */
+#elif defined(IRLIB_HOST)
+	#define IR_SEND_HOST		3
 /* Arduino Duemilanove, Diecimila, LilyPad, Mini, Fio, etc */
 #else
 	//#define IR_SEND_TIMER1	9
@@ -101,15 +105,16 @@
  * The definition must include the pin number for bit-bang output.  This could be any
  * available digital output pin. It need not be a designated PWM pin.
  * NOTE: By un-commenting this line, you are forcing the library to ignore
- * hardware detection and timer specifications above. The bit-bang frequency
- * code is not as accurate as using a hardware timer but it is more flexible and 
- * less hardware platform dependent.
+ * hardware detection and timer specifications above. The bit-bang carrier is
+ * generated by a cycle-counted assembly loop (see IRbitBangCarrier in IRLib.cpp)
+ * so its frequency and duty cycle no longer depend on what the compiler emits.
+ * Interrupts are disabled while the carrier is high and run while it is low.
  */
 //#define IR_SEND_BIT_BANG  3  //Be sure to set this pin number if you un-comment
 
-/* This is a fudge factor that adjusts bit-bang timing. Feel free to experiment
- * for best results.*/
-#define IR_BIT_BANG_OVERHEAD 10
+/* Duty cycle of the bit-bang carrier in percent. 33% matches the hardware timer
+ * output below (OCRxB = pwmval / 3).*/
+#define IR_BIT_BANG_DUTY 33
 
 /* We are going to presume that you want to use the same hardware timer to control
  * the 50 microsecond interrupt used by the IRrecv receiver class as was specified
@@ -170,6 +175,8 @@
 		#define IR_RECV_TIMER4_HS
 	#elif defined(IR_SEND_TIMER5)
 		#define IR_RECV_TIMER5
+	#elif defined(IR_SEND_HOST)
+		#define IR_RECV_HOST
 	#else
 		#error "Unable to set IR_RECV_TIMER"
 	#endif
@@ -177,16 +184,17 @@
 
 #if defined(IR_SEND_BIT_BANG)  //defines for bit-bang output
 	#define IR_SEND_PWM_PIN	IR_SEND_BIT_BANG
-	#define IR_SEND_PWM_START   unsigned int jmax=time/iLength;\
-		for(unsigned int j=0;j<jmax;j++) {\
-		  digitalWrite(IR_SEND_BIT_BANG, HIGH);  delayMicroseconds(OnTime);\
-		  digitalWrite(IR_SEND_BIT_BANG, LOW);   delayMicroseconds(OffTime);}
+	#define IR_SEND_PWM_START   bitBangMark(time)
 	#define IR_SEND_MARK_TIME(time) 
 	#define IR_SEND_PWM_STOP
-	#define IR_SEND_CONFIG_KHZ(val)  float Length=1000.0/(float)khz;\
-		iLength=int(Length+0.5); OnTime=int(Length/3.0); \
-		OffTime=iLength-OnTime-IR_BIT_BANG_OVERHEAD-(val<40);
-
+	#define IR_SEND_CONFIG_KHZ(val)  bitBangConfig(val)
+	/* Cycle counts of the loop in IRbitBangCarrier: the carrier is high for
+	 * 3*OnLoops+2 cycles and low for 3*OffLoops+8 cycles. */
+	#define IR_BIT_BANG_HIGH_CYCLES(n) (3*(n)+2)
+	#define IR_BIT_BANG_LOW_CYCLES(n)  (3*(n)+8)
+	void IRbitBangCarrier(volatile uint8_t *port, uint8_t mask, uint8_t onLoops, uint8_t offLoops, uint16_t periods);
+	/* Carrier periods bitBangMark sends between two looks at micros(); about 0.8ms at 38kHz */
+	#define IR_BIT_BANG_BURST 32
 #elif defined(IR_SEND_TIMER1) // defines for timer1 (16 bits)
 	#define IR_SEND_PWM_START     (TCCR1A |= _BV(COM1A1))
 	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
@@ -272,6 +280,12 @@
 	#else
 		#define IR_SEND_PWM_PIN	IR_SEND_TIMER5
 	#endif
+#elif defined(IR_SEND_HOST) // defines for the host build's virtual carrier
+	#define IR_SEND_PWM_PIN	IR_SEND_HOST
+	#define IR_SEND_PWM_START     IRhost_carrier(true)
+	#define IR_SEND_MARK_TIME(time)  My_delay_uSecs(time)
+	#define IR_SEND_PWM_STOP    IRhost_carrier(false)
+	#define IR_SEND_CONFIG_KHZ(val) IRhost_configCarrier(val)
 #else // unknown timer
 	#error "Internal code configuration error, no known IR_SEND_TIMER# defined\n"
 #endif
@@ -338,10 +352,31 @@
 	#define IR_RECV_CONFIG_TICKS() ({ \
 		TCCR5A = 0;   TCCR5B = _BV(WGM52) | _BV(CS50); \
 		OCR5A = SYSCLOCK * USEC_PER_TICK / 1000000;   TCNT5 = 0; })
+#elif defined(IR_RECV_HOST)  // defines for the host build's virtual tick timer
+	#define IR_RECV_ENABLE_INTR    IRhost_enableTicks(IR_RECV_INTR_NAME)
+	#define IR_RECV_DISABLE_INTR   IRhost_enableTicks(NULL)
+	#define IR_RECV_INTR_NAME      IRhost_tick_ISR
+	#define IR_RECV_CONFIG_TICKS() IRhost_configTicks(USEC_PER_TICK)
 #else // unknown timer
 	#error "Internal code configuration error, no known IR_RECV_TIMER# defined\n"
 #endif
 
+/* Sending reprograms the IR_SEND_TIMER for the carrier. Only when IRrecv uses that same timer
+ * does its 50us interrupt have to stop while we send, after which you must call enableIRIn
+ * again. With IR_RECV_TIMER_OVERRIDE on another timer, with bit-bang output or with IRrecvPCI
+ * the receiver keeps running during a transmission. Bit-bang output only disables interrupts
+ * while the carrier is high, which delays the receive ISR by up to that long.
+ */
+#if !defined(IR_SEND_BIT_BANG) && ( \
+	(defined(IR_SEND_TIMER1) && defined(IR_RECV_TIMER1)) || \
+	(defined(IR_SEND_TIMER2) && defined(IR_RECV_TIMER2)) || \
+	(defined(IR_SEND_TIMER3) && defined(IR_RECV_TIMER3)) || \
+	(defined(IR_SEND_TIMER4) && defined(IR_RECV_TIMER4)) || \
+	(defined(IR_SEND_TIMER4_HS) && defined(IR_RECV_TIMER4_HS)) || \
+	(defined(IR_SEND_TIMER5) && defined(IR_RECV_TIMER5)) )
+	#define IR_SEND_RECV_SAME_TIMER
+#endif
+
 //Defines for blinking the LED
 //DEPRECATED BY GS
 /* #if defined(CORE_LED0_PIN)
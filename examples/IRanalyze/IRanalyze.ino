@@ -11,6 +11,8 @@
 /* IRanalyze receives repeated values from a remote and averages the results. Should help in
  * analyzing unknown protocols. You have to press the same key repeatedly. If you press a 
  * different key the totals reset and it computes new averages.
+ * To get the header, encoding and bit count worked out for you, dump a few presses of a few
+ * keys with IRdump and run extras/host/tools/iranalyze on them.
  */
  
 /*
@@ -0,0 +1,111 @@
+/* Example program for from IRLib - an Arduino library for infrared encoding and decoding
+ * Loopback test of the IRlink data link. No IR hardware is needed.
+ *
+ * Two links talk to each other through a simulated wire. Each link records what it sends
+ * into a pulse program instead of the IR LED, and the marks and spaces are then fed to the
+ * IRrecvPCI interrupt handler through IRrecvPCI_Edge, exactly as the pin change interrupt
+ * would have. The time stamps are shifted into the past so that the frame has already
+ * ended by the time getResults looks at it. Leave the receiver pin (interrupt 0) unconnected.
+ *
+ * The sketch sends messages with and without acknowledgement, drops a frame on the wire to
+ * make the sender repeat it, and prints PASS or FAIL for each test.
+ */
+#include <IRLib.h>
+#include <IRLibLink.h>
+#include <IRLibMatch.h>
+
+IRrecvPCI My_Receiver(0);
+
+uint8_t BufferA[16], BufferB[64];
+IRlink A(BufferA,sizeof(BufferA)), B(BufferB,sizeof(BufferB));
+
+//A sends data frames to B, B answers with acknowledgements
+uint16_t AirAB[3*RAWBUF], AirBA[RAWBUF];
+IRpulseProgram WireAB(AirAB,3*RAWBUF), WireBA(AirBA,RAWBUF);
+
+uint8_t Drop; //number of frames still to be lost on the wire
+uint8_t Frames; //number of frames that went across
+
+//Plays entries First..Last of a pulse program into the receiver and lets the link decode them
+void play(IRpulseProgram *wire, uint16_t First, uint16_t Last, IRlink *to) {
+  unsigned long T=0;
+  for(uint16_t i=First; i<=Last; i++) T+=wire->durations[i];
+  T=micros()-T; //the last entry is a space of at least LONG_SPACE_US, so the frame is over by now
+  for(uint16_t i=First; i<=Last; i++) {
+    IRrecvPCI_Edge(T, (i & 1)? SPACE_START: MARK_START);
+    T+=wire->durations[i];
+  }
+  if(My_Receiver.getResults(to)) {
+    to->decode();
+    My_Receiver.resume();
+  }
+}
+
+//Splits the pulse program into frames at the long spaces and delivers them one at a time
+void deliver(IRpulseProgram *wire, IRlink *to) {
+  uint16_t First=0;
+  for(uint16_t i=1; i<wire->length; i+=2) {
+    if(wire->durations[i]>=LONG_SPACE_US || i==wire->length-1) {
+      Frames++;
+      if(Drop) Drop--;
+      else play(wire,First,i,to);
+      First=i+1;
+    }
+  }
+  wire->clear();
+}
+
+//Moves frames both ways until the wire is quiet and A has nothing left to repeat
+void run(void) {
+  do {
+    while(WireAB.length || WireBA.length) {
+      deliver(&WireAB,&B);
+      deliver(&WireBA,&A);
+    }
+    if(A.busy()) {
+      delay(A.ackTimeout+1);
+      A.poll();
+    }
+  } while(A.busy() || WireAB.length);
+}
+
+void check(const __FlashStringHelper *name, const uint8_t *data, uint16_t len) {
+  uint8_t Got[sizeof(BufferB)];
+  uint16_t GotLen=0;
+  bool Ok=B.available();
+  if(Ok) GotLen=B.read(Got,sizeof(Got));
+  Ok= Ok && GotLen==len && !memcmp(Got,data,len) && !A.failed;
+  Serial.print(Ok? F("PASS "): F("FAIL ")); Serial.print(name);
+  Serial.print(F(": ")); Serial.print(len); Serial.print(F(" bytes in "));
+  Serial.print(Frames); Serial.println(F(" frames"));
+  Frames=0;
+}
+
+void setup() {
+  Serial.begin(9600);
+  delay(2000);while(!Serial);//delay for Leonardo
+  My_Receiver.enableIRIn();
+  A.record(&WireAB); B.record(&WireBA);
+  uint8_t Message[20];
+  for(uint8_t i=0; i<sizeof(Message); i++) Message[i]=i*37+1;
+
+  A.write(Message,sizeof(Message));
+  run(); check(F("no acknowledgement"),Message,sizeof(Message));
+
+  A.useAck=B.useAck=true;
+  A.write(Message,sizeof(Message));
+  run(); check(F("acknowledged"),Message,sizeof(Message));
+
+  Drop=1; //the first data frame is lost and has to be repeated
+  A.write(Message+3,11);
+  run(); check(F("repeat after loss"),Message+3,11);
+
+  A.crc16=B.crc16=false;
+  A.write(Message,1);
+  run(); check(F("CRC-8"),Message,1);
+
+  Serial.println(F("DONE"));
+}
+
+void loop() {
+}
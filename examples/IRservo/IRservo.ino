@@ -4,6 +4,7 @@
  * "IRservo" Control a servo using an IR remote
  */
 #include <IRLib.h>
+#include <IRLibKeymap.h>
 #include <Servo.h> 
 /* Note: Servo library uses TIMER1. The default timer for IRLib on Arduino Uno
  * is TIMER2 so there is no conflict. However a default timer on Arduino Leonardo
@@ -11,23 +12,30 @@
  * as specified in IRLibTimer.h. Also you will need to modify the input being used.
  */
 // You will have to set these values depending on the protocol
-// and remote codes that you are using. These are from my Sony DVD/VCR
-#define MY_PROTOCOL SONY
-#define RIGHT_ARROW   0x86bca //Move several clockwise
-#define LEFT_ARROW    0x46bca //Move servo counterclockwise
-#define SELECT_BUTTON 0xd0bca //Center the servo
-#define UP_ARROW      0x42bca //Increased number of degrees servo moves
-#define DOWN_ARROW    0xc2bca //Decrease number of degrees servo moves
-#define BUTTON_0 0x90bca  //Pushing buttons 0-9 moves to fix positions
-#define BUTTON_1 0x00bca  // each 20 degrees greater
-#define BUTTON_2 0x80bca
-#define BUTTON_3 0x40bca
-#define BUTTON_4 0xc0bca
-#define BUTTON_5 0x20bca
-#define BUTTON_6 0xa0bca
-#define BUTTON_7 0x60bca
-#define BUTTON_8 0xe0bca
-#define BUTTON_9 0x10bca
+// and remote codes that you are using. These are from my Sony DVD/VCR.
+// The table is in flash and must be sorted by protocol and then by code;
+// the static_assert below stops the compile if it is not.
+enum {KEY_NONE, KEY_LEFT, KEY_RIGHT, KEY_SELECT, KEY_UP, KEY_DOWN,
+      KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9};
+constexpr IRkeymapEntry My_Keys[] PROGMEM = {
+  IRkeymapKey(SONY, 0x00bca, KEY_1),      //Pushing buttons 0-9 moves to fix positions
+  IRkeymapKey(SONY, 0x10bca, KEY_9),      // each 20 degrees greater
+  IRkeymapKey(SONY, 0x20bca, KEY_5),
+  IRkeymapKey(SONY, 0x40bca, KEY_3),
+  IRkeymapKey(SONY, 0x42bca, KEY_UP),     //Increased number of degrees servo moves
+  IRkeymapKey(SONY, 0x46bca, KEY_LEFT),   //Move servo counterclockwise
+  IRkeymapKey(SONY, 0x60bca, KEY_7),
+  IRkeymapKey(SONY, 0x80bca, KEY_2),
+  IRkeymapKey(SONY, 0x86bca, KEY_RIGHT),  //Move several clockwise
+  IRkeymapKey(SONY, 0x90bca, KEY_0),
+  IRkeymapKey(SONY, 0xa0bca, KEY_6),
+  IRkeymapKey(SONY, 0xc0bca, KEY_4),
+  IRkeymapKey(SONY, 0xc2bca, KEY_DOWN),   //Decrease number of degrees servo moves
+  IRkeymapKey(SONY, 0xd0bca, KEY_SELECT), //Center the servo
+  IRkeymapKey(SONY, 0xe0bca, KEY_8)
+};
+static_assert(IRkeymap_valid(My_Keys, IR_KEYMAP_SIZE(My_Keys)), "My_Keys is out of order");
+IRkeymap My_Map(My_Keys, IR_KEYMAP_SIZE(My_Keys));
 
 IRrecv My_Receiver(11);//Receive on pin 11
 IRdecode My_Decoder; 
@@ -49,23 +57,15 @@ void loop()
 { 
     if (My_Receiver.GetResults(&My_Decoder)) {
        My_Decoder.decode();
-       if(My_Decoder.decode_type==MY_PROTOCOL) {
-          switch(My_Decoder.value) {
-            case LEFT_ARROW:    pos=min(180,pos+Speed); break;
-            case RIGHT_ARROW:   pos=max(0,pos-Speed); break;
-            case SELECT_BUTTON: pos=90; break;
-            case UP_ARROW:      Speed=min(10, Speed+1); break;
-            case DOWN_ARROW:    Speed=max(1, Speed-1); break;
-            case BUTTON_0:      pos=0*20; break;
-            case BUTTON_1:      pos=1*20; break;
-            case BUTTON_2:      pos=2*20; break;
-            case BUTTON_3:      pos=3*20; break;
-            case BUTTON_4:      pos=4*20; break;
-            case BUTTON_5:      pos=5*20; break;
-            case BUTTON_6:      pos=6*20; break;
-            case BUTTON_7:      pos=7*20; break;
-            case BUTTON_8:      pos=8*20; break;
-            case BUTTON_9:      pos=9*20; break;
+       uint16_t Key=My_Map.lookup(&My_Decoder);
+       if(Key!=IR_KEYMAP_NONE) {
+          switch(Key) {
+            case KEY_LEFT:      pos=min(180,pos+Speed); break;
+            case KEY_RIGHT:     pos=max(0,pos-Speed); break;
+            case KEY_SELECT:    pos=90; break;
+            case KEY_UP:        Speed=min(10, Speed+1); break;
+            case KEY_DOWN:      Speed=max(1, Speed-1); break;
+            default:            pos=(Key-KEY_0)*20; break; //KEY_0 to KEY_9
           }
         My_Servo.write(pos); // tell servo to go to position in variable 'pos' 
        }
@@ -10,8 +10,9 @@
  * This example demonstrates how to extend this library to add a new protocol
  * without actually modifying or recompiling the library itself. It implements a 36 bit
  * Samsung protocol that is used on a Blu-ray player that I own.
- * Because a 36 bit value will not fit in the value field (only 32 bits) we have to create
- * a second value field.  This is a modified version of the IRecord example.
+ * A 36 bit value does not fit in the value field (only 32 bits) so all 36 bits are
+ * kept in the decoder's payload field and sent from an IRpayload.
+ * This is a modified version of the IRecord example.
  */
 #include <IRLib.h>
 #include <IRLibMatch.h>
@@ -22,20 +23,16 @@ class IRdecodeSamsung36: public virtual IRdecodeBase
 {
 public:
   bool decode(void); 
-  unsigned int value2;
-  void Reset(void);
 private:
   bool GetBit(void);
-  int offset;
-  unsigned long data;
 };
 
 class IRsendSamsung36: public virtual IRsendBase
 {
 public:
-  void send(unsigned long data, unsigned long data2);
+  void send(const IRpayload &data);
 private:
-  void PutBits (unsigned long data, int nbits);
+  void PutBits (const IRpayload &data, int first, int nbits);
 };
 /* If moving this code to IRLib.h instead of the line below at about 
    line 60 you should search for the line that says...
@@ -75,15 +72,15 @@ public virtual IRsendSamsung36  //No comma here
 */
 /* Because not all of the data bits are contiguous in the stream
  * we created this little routine to get one data bit.
- * We then call it in a loop as needed.
+ * We then call it in a loop as needed. All 36 bits go into the payload.
  */
 bool IRdecodeSamsung36::GetBit(void) {
   if (!MATCH(rawbuf[offset],500)) return DATA_MARK_ERROR(500);
   offset++;
   if (MATCH(rawbuf[offset],1500)) 
-    data = (data << 1) | 1;
+    payload.shiftIn(1);
   else if (MATCH(rawbuf[offset],500)) 
-    data <<= 1;
+    payload.shiftIn(0);
   else return DATA_SPACE_ERROR(1500);
   offset++;
   return true;
@@ -93,61 +90,51 @@ bool IRdecodeSamsung36::decode(void) {
   if (rawlen != 78) return RAW_COUNT_ERROR;
   if (!MATCH(rawbuf[1],4500))  return HEADER_MARK_ERROR(4500);
   if (!MATCH(rawbuf[2],4500)) return HEADER_SPACE_ERROR(4500);
-  offset=3; data=0;
+  offset=3; payload.clear();
   //Get first 16 bits
   while (offset < 16*2+2) if(!GetBit()) return false;
   //Skip middle header
   if (!MATCH(rawbuf[offset],500))  return DATA_MARK_ERROR(500);
   offset++;
   if (!MATCH(rawbuf[offset],4500)) return DATA_SPACE_ERROR(4400);
-  //save first 16 bits in "value2" and reset data
-  offset++; value2=data; data=0;
+  offset++;
   //12 bits into this second segment there is a 68us space
   //so we find one of the raw values to eliminate that
   rawbuf[62]=rawbuf[62]-68;
   //this gets remaining 20 bits
   while(offset<77)if(!GetBit()) return false;
   bits =36;//set bit length
-  value = data;//put remaining 12 bits in value
-  decode_type= static_cast<IRTYPES>SAMSUNG36;
+  value = (uint32_t)payload.low;//low 32 bits; the top 4 are only in payload
+  decode_type= SAMSUNG36;
   return true;
 };
-//The Reset method clears out the data however we have extra data to clear
-void IRdecodeSamsung36::Reset(void) {
-  IRdecodeBase::Reset();//respect your parents
-  value2=0;
-};
-//Similar to GetBits, this routine sends just one bit of data.
+//Sends nbits bits of the payload starting at bit "first" (counted from the most significant).
 //Need this because data bits are not contiguous in the stream
-void IRsendSamsung36::PutBits (unsigned long data, int nbits){
+void IRsendSamsung36::PutBits (const IRpayload &data, int first, int nbits){
    for (int i = 0; i < nbits; i++) {
-      if (data & 0x80000000) {
+      if (data.bitAt(35-first-i)) {
         mark(500);  space(1500);
       } else {
         mark(500);  space(500);
       };
-      data <<= 1;
    }
 }
 
-void IRsendSamsung36::send(unsigned long data, unsigned long data2) {
-   data <<= 32-20;
-   data2 <<= 32-16;
+void IRsendSamsung36::send(const IRpayload &data) {
    enableIROut(38);
    mark(4500); space(4500);//Send header
-   PutBits (data2, 16);//Send data2 16 bits
+   PutBits (data, 0, 16);//Send device and sub device, 16 bits
    mark (500); space (4500);//Send break
-   PutBits (data, 12);//Send 12 bits
+   PutBits (data, 16, 12);//Send 12 bits
    space(68);//Send tiny break
-   data <<= 12;
-   PutBits (data, 8);mark(500); //Final eight bits and one stop bit
+   PutBits (data, 28, 8);mark(500); //Final eight bits and one stop bit
    space(118*500);//Lead out is 118 times the base time 500
 };
 /*
  * This concludes the portion that you could move to IRLib.cpp
  * Additionally at apprx. line 39 add F("Samsung36"), to the list
  * between NECx and hash code.
- * Also add "case SAMSUNG36:IRsendSamsung36::send(data,nbits); break;
+ * Also add "case SAMSUNG36:IRsendSamsung36::send(payload); break;
  * at about line 238.  Also at about 400 add
  *   if (IRdecodeSamsung36::decode()) return true;
  */
@@ -163,14 +150,14 @@ public virtual IRsend,
 public virtual IRsendSamsung36
 {
 public:
-//Note: data2 is the number of bits for non-Samsung36 protocols
-  void send(IRTYPES Type, unsigned long data, int data2);
+//Note: payload is only used by Samsung36, data and nbits only by the other protocols
+  void send(IR_types_t Type, unsigned long data, int nbits, const IRpayload &payload);
 };
-void MyCustomSend::send(IRTYPES Type, unsigned long data, int data2) {
+void MyCustomSend::send(IR_types_t Type, unsigned long data, int nbits, const IRpayload &payload) {
   if (Type==SAMSUNG36)
-    IRsendSamsung36::send(data,data2);
+    IRsendSamsung36::send(payload);
   else
-    IRsend::send(Type, data, data2);
+    IRsend::send(Type, data, nbits);
 }
 class MyCustomDecode: 
 public virtual IRdecode,
@@ -178,18 +165,18 @@ public virtual IRdecodeSamsung36
 {
 public:
   virtual bool decode(void);    // Calls each decode routine individually
-  void DumpResults(void);
+  void dumpResults(void);
 };
 bool MyCustomDecode::decode(void) {
   if (IRdecodeSamsung36::decode()) return true;
   return IRdecode::decode ();
 }
-void MyCustomDecode::DumpResults(void){
+void MyCustomDecode::dumpResults(void){
   if(decode_type==SAMSUNG36) {
-    Serial.print(F("Decoded Samsung36: Value:")); Serial.print(value, HEX);
-    Serial.print(F(": Value2:")); Serial.print(value2, HEX);
+    Serial.print(F("Decoded Samsung36: High:")); Serial.print(payload.byteAt(4), HEX);
+    Serial.print(F(": Low:")); Serial.print(value, HEX);
   };
-  IRdecode::DumpResults();
+  IRdecode::dumpResults();
 };
 
 MyCustomDecode My_Decoder;
@@ -199,9 +186,10 @@ MyCustomSend My_Sender;
 int RECV_PIN = 11;
 
 IRrecv My_Receiver(RECV_PIN);
-IRTYPES codeType;         // The type of code
+IR_types_t codeType;      // The type of code
 unsigned long codeValue;  // The data bits
-int codeBits;             // The length of the code in bits or for Samsung is storage for data2
+int codeBits;             // The length of the code in bits
+IRpayload codePayload;    // All 36 bits of a Samsung36 code
 bool GotOne; 
 
 void setup()
@@ -209,7 +197,7 @@ void setup()
   GotOne=false;
   codeType=UNKNOWN; 
   codeValue=0; 
-  codeBits=0;//Stores data2 on Samsung36. Stores number of bits on another protocols
+  codeBits=0;
   Serial.begin(9600);
   delay(2000); while(!Serial);
   Serial.println(F("Send a code from your remote and we will record it."));
@@ -220,16 +208,16 @@ void loop() {
   if (Serial.available()>0) {
     unsigned char c=Serial.read();
     if (c=='p') {//Send a test pattern
-      GotOne= true;  codeType=SAMSUNG36; codeValue=0x12345; codeBits=0x6789;
+      GotOne= true;  codeType=SAMSUNG36; codePayload.set(0x678912345ULL,36);
     }
     if(GotOne) {
-      My_Sender.send(codeType,codeValue,codeBits);
+      My_Sender.send(codeType,codeValue,codeBits,codePayload);
       Serial.print(F("Sent "));
       if (codeType==SAMSUNG36) {
-        Serial.print(F("Samsung36 Value:0x"));
-        Serial.print(codeValue, HEX);
-        Serial.print(F(" Value2:0x"));
-        Serial.println(codeBits, HEX);
+        Serial.print(F("Samsung36 High:0x"));
+        Serial.print(codePayload.byteAt(4), HEX);
+        Serial.print(F(" Low:0x"));
+        Serial.println((unsigned long)codePayload.low, HEX);
       } else {
         Serial.print(Pnames(codeType));
         Serial.print(F(" Value:0x"));
@@ -240,7 +228,7 @@ void loop() {
       My_Receiver.enableIRIn(); // Re-enable receiver
     }
   } 
-  else if (My_Receiver.GetResults(&My_Decoder)) {
+  else if (My_Receiver.getResults(&My_Decoder)) {
     My_Decoder.decode();
     if(My_Decoder.decode_type == UNKNOWN) {
       Serial.println(F("Unknown type received. Ignoring."));
@@ -248,9 +236,10 @@ void loop() {
       codeType= My_Decoder.decode_type;
       codeValue= My_Decoder.value;
       codeBits= My_Decoder.bits;
+      codePayload= My_Decoder.payload;
       GotOne=true;
     }
-    My_Decoder.DumpResults();
+    My_Decoder.dumpResults();
     delay(1000);
     My_Receiver.resume(); 
   }
@@ -0,0 +1,57 @@
+/* isr_bench.ino - firmware for the ISR cycle benchmark (see README.md)
+ * Built once per receiver with BENCH_MODE set by the Makefile, and with IRLIB_PROFILE so that
+ * the interrupt routines report their cycles through GPIOR0. The main loop does what a normal
+ * sketch does with each frame: decode it and resume. The simulator drives interrupt 0 (pin 2)
+ * with IR frames, or interrupt 1 (pin 3) with carrier pulses for IRfrequency.
+ * BENCH_SEND is built with IR_SEND_BIT_BANG and sends NEC frames at BENCH_KHZ from the loop
+ * while IRrecv keeps running; the simulator times the carrier on the output pin and counts
+ * the ticks.
+ */
+#include <IRLib.h>
+
+#define BENCH_IRRECV 1
+#define BENCH_PCI    2
+#define BENCH_FREQ   3
+#define BENCH_SEND   4
+
+#if BENCH_MODE==BENCH_IRRECV
+IRrecv My_Receiver(2);
+#elif BENCH_MODE==BENCH_PCI
+IRrecvPCI My_Receiver(0);
+#elif BENCH_MODE==BENCH_FREQ
+IRfrequency My_Freq(1);
+#elif BENCH_MODE==BENCH_SEND
+IRrecv My_Receiver(2);
+IRsend My_Sender;
+#else
+#error "BENCH_MODE must be BENCH_IRRECV, BENCH_PCI, BENCH_FREQ or BENCH_SEND"
+#endif
+IRdecode My_Decoder;
+
+void setup() {
+#if BENCH_MODE==BENCH_FREQ
+  My_Freq.enableFreqDetect();
+#else
+  My_Receiver.enableIRIn();
+#endif
+}
+
+void loop() {
+#if BENCH_MODE==BENCH_FREQ
+  if (My_Freq.haveData()) {
+    My_Freq.disableFreqDetect();
+    My_Freq.computeFreq();
+    My_Freq.enableFreqDetect();
+  }
+#else
+#if BENCH_MODE==BENCH_SEND
+  //NEC timings at the carrier under test; the 9024us header is the longest mark
+  My_Sender.sendGeneric(0x61A0F00FUL, 32, 564*16, 564*8, 564, 564, 564*3, 564, BENCH_KHZ, true);
+  delay(40);
+#endif
+  if (My_Receiver.getResults(&My_Decoder)) {
+    My_Decoder.decode();
+    My_Receiver.resume();
+  }
+#endif
+}
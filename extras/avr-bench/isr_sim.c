@@ -0,0 +1,266 @@
+/* isr_sim.c - runs isr_bench firmware under simavr and reports ISR cycles (see README.md)
+ *
+ *   isr_sim -m <mcu> -f <firmware.elf> [-t trace] [-n frames] [-k khz] [-b id=cycles ...]
+ *   isr_sim -m <mcu> -f <firmware.elf> -c khz [-d duty] [-n frames]
+ *
+ * The firmware is built with IRLIB_PROFILE, so every ISR writes an id to GPIOR0 on entry, a
+ * second id if it takes the end-of-frame path, and 0 on exit (see IRLibMatch.h). This program
+ * watches those writes and counts the cycles of each invocation under the last id written.
+ *
+ * The input is an irreplay text trace (-t, see extras/host/sim/IRLibSim.h) or, by default, a
+ * built-in signal: NEC frames alternating with an over-long burst that fills the receive
+ * buffer, which gives the longest end-of-frame copy. -k modulates every mark with a carrier of
+ * that frequency, for IRfrequency. Edges go to pin 2 (interrupt 0), or to pin 3 (interrupt 1)
+ * with -k.
+ *
+ * -c is for the BENCH_SEND firmware, which sends with the bit-bang carrier on pin 9 while the
+ * IRrecv tick keeps running. No input is played. Every edge of pin 9 is time stamped and each
+ * carrier period and its high time are measured; they must average within 1% of khz and within
+ * 2 points of duty percent (33 by default, IR_BIT_BANG_DUTY). The longest mark, from its first
+ * rise to its last fall, must be within 2% of the 9024us NEC header the firmware sends. The
+ * tick ISR must also have run for at least 95% of the 50us ticks, which it cannot if
+ * interrupts stay off for whole marks.
+ *
+ * Exits with 1 if the maximum of any id exceeds its budget, if the firmware never ran
+ * the end-of-frame path (or IRfreqISR with -k) it was meant to exercise, or if a -c check fails.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "avr_ioport.h"
+
+#define GPIOR0_ADDR 0x3E   /* data space address of GPIOR0 on the ATmega328P and ATmega2560 */
+#define IDS 6
+static const char *Id_Name[IDS] = {"", "IRrecv tick ISR", "IRrecv tick ISR, end of frame",
+  "IRrecvPCI_Handler", "IRrecvPCI_Handler, end of frame", "IRfreqISR"};
+/* Initial budgets in cycles. The tick ISR has to finish well inside its 50us period (800 cycles
+ * at 16MHz); the end-of-frame copy of up to RAWBUF entries is allowed longer. */
+static unsigned long Budget[IDS] = {0, 400, 2400, 600, 2400, 200};
+
+static struct {
+  unsigned long count;
+  uint64_t min, max, sum;
+} Stats[IDS];
+static uint8_t Current;  /* id of the invocation in progress, 0 if none */
+static uint64_t Start;
+
+static void profileWrite(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param) {
+  (void)param;
+  avr->data[addr] = v;
+  if (v >= IDS) return;
+  if (v) {
+    if (!Current) Start = avr->cycle;
+    Current = v;
+    return;
+  }
+  if (!Current) return;
+  uint64_t Cycles = avr->cycle - Start;
+  if (!Stats[Current].count || Cycles < Stats[Current].min) Stats[Current].min = Cycles;
+  if (Cycles > Stats[Current].max) Stats[Current].max = Cycles;
+  Stats[Current].sum += Cycles;
+  Stats[Current].count++;
+  Current = 0;
+}
+
+/* The bit-bang carrier on the output pin, in cycles. A rise less than two nominal periods after
+ * the one before ends a period; a later one starts a new mark. */
+static struct {
+  uint64_t nominal;        /* cycles per period at the requested frequency */
+  uint64_t rise, fall;     /* of the period in progress */
+  uint64_t markStart, maxMark;
+  unsigned long periods, marks;
+  uint64_t minPeriod, maxPeriod, sumPeriod;
+  uint64_t minHigh, maxHigh, sumHigh;
+} Carrier;
+
+static void carrierEdge(struct avr_irq_t *irq, uint32_t value, void *param) {
+  avr_t *Avr = (avr_t *)param;
+  (void)irq;
+  if (!value) {Carrier.fall = Avr->cycle; return;}
+  if (Carrier.rise && Avr->cycle - Carrier.rise < 2 * Carrier.nominal) {
+    uint64_t Period = Avr->cycle - Carrier.rise, High = Carrier.fall - Carrier.rise;
+    if (!Carrier.periods || Period < Carrier.minPeriod) Carrier.minPeriod = Period;
+    if (!Carrier.periods || High < Carrier.minHigh) Carrier.minHigh = High;
+    if (Period > Carrier.maxPeriod) Carrier.maxPeriod = Period;
+    if (High > Carrier.maxHigh) Carrier.maxHigh = High;
+    Carrier.sumPeriod += Period;
+    Carrier.sumHigh += High;
+    Carrier.periods++;
+  } else {
+    if (Carrier.marks && Carrier.fall - Carrier.markStart > Carrier.maxMark) Carrier.maxMark = Carrier.fall - Carrier.markStart;
+    Carrier.markStart = Avr->cycle;
+    Carrier.marks++;
+  }
+  Carrier.rise = Avr->cycle;
+}
+
+typedef struct {uint64_t t; uint8_t level;} edge_t;  /* t in us */
+static edge_t *Edges;
+static size_t Edge_Count, Edge_Size;
+
+static void addEdge(uint64_t t, uint8_t level) {
+  if (Edge_Count == Edge_Size) {
+    Edge_Size = Edge_Size ? 2 * Edge_Size : 4096;
+    Edges = realloc(Edges, Edge_Size * sizeof(edge_t));
+    if (!Edges) {perror("isr_sim"); exit(2);}
+  }
+  Edges[Edge_Count].t = t;
+  Edges[Edge_Count++].level = level;
+}
+
+/* A mark from t to t+len, either as one low level or as carrier pulses */
+static void addMark(uint64_t t, unsigned len, unsigned khz) {
+  if (!khz) {addEdge(t, 0); addEdge(t + len, 1); return;}
+  unsigned Period = 1000 / khz; /* us; the receiver pulses low for the first half of every period */
+  if (!Period) Period = 1;
+  for (unsigned p = 0; p < len; p += Period) {
+    addEdge(t + p, 0);
+    addEdge(t + p + (Period + 1) / 2, 1);
+  }
+}
+
+static uint64_t builtInSignal(unsigned frames, unsigned khz) {
+  uint64_t t = 20000;
+  uint32_t Value = 0x61A0F00F;
+  for (unsigned f = 0; f < frames; f++) {
+    if (f & 1) { /* 70 marks: more edges than RAWBUF holds */
+      for (int i = 0; i < 70; i++) {addMark(t, 400, khz); t += 800;}
+    } else {     /* NEC */
+      addMark(t, 9000, khz); t += 13500;
+      for (int i = 31; i >= 0; i--) {
+        addMark(t, 560, khz);
+        t += 560 + (((Value + f) >> i) & 1 ? 1690 : 560);
+      }
+      addMark(t, 560, khz); t += 560;
+    }
+    t += 40000;
+  }
+  return t;
+}
+
+static uint64_t loadTrace(const char *path, unsigned khz) {
+  FILE *f = fopen(path, "r");
+  char Line[256];
+  uint64_t MarkStart = 0, End = 0;
+  int InMark = 0;
+  if (!f) {perror(path); exit(2);}
+  while (fgets(Line, sizeof(Line), f)) {
+    unsigned long long t; unsigned Level;
+    if (Line[0] == '#' || Line[0] == 'F' || sscanf(Line, "%llu %u", &t, &Level) != 2) continue;
+    if (!Level && !InMark) MarkStart = t;
+    else if (Level && InMark) addMark(MarkStart, (unsigned)(t - MarkStart), khz);
+    InMark = !Level;
+    End = t;
+  }
+  fclose(f);
+  return End + 200000;
+}
+
+static int usage(void) {
+  fprintf(stderr, "usage: isr_sim -m <mcu> -f <firmware.elf> [-t trace] [-n frames] [-k khz] [-b id=cycles ...]\n"
+    "       isr_sim -m <mcu> -f <firmware.elf> -c khz [-d duty] [-n frames]\n");
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  const char *Mcu = NULL, *Elf = NULL, *Trace = NULL;
+  unsigned Frames = 20, Khz = 0, SendKhz = 0, Duty = 33;
+  int c;
+  while ((c = getopt(argc, argv, "m:f:t:n:k:b:c:d:")) != -1) {
+    switch (c) {
+      case 'm': Mcu = optarg; break;
+      case 'f': Elf = optarg; break;
+      case 't': Trace = optarg; break;
+      case 'n': Frames = atoi(optarg); break;
+      case 'k': Khz = atoi(optarg); break;
+      case 'c': SendKhz = atoi(optarg); break;
+      case 'd': Duty = atoi(optarg); break;
+      case 'b': {
+        int Id; unsigned long Cycles;
+        if (sscanf(optarg, "%d=%lu", &Id, &Cycles) != 2 || Id < 1 || Id >= IDS) return usage();
+        Budget[Id] = Cycles;
+        break;
+      }
+      default: return usage();
+    }
+  }
+  if (!Mcu || !Elf || (SendKhz && (Khz || Trace))) return usage();
+
+  elf_firmware_t Fw;
+  memset(&Fw, 0, sizeof(Fw));
+  if (elf_read_firmware(Elf, &Fw)) {fprintf(stderr, "isr_sim: cannot read %s\n", Elf); return 2;}
+  strncpy(Fw.mmcu, Mcu, sizeof(Fw.mmcu) - 1);
+  if (!Fw.frequency) Fw.frequency = 16000000;
+  avr_t *Avr = avr_make_mcu_by_name(Fw.mmcu);
+  if (!Avr) {fprintf(stderr, "isr_sim: unknown mcu %s\n", Mcu); return 2;}
+  avr_init(Avr);
+  avr_load_firmware(Avr, &Fw);
+  avr_register_io_write(Avr, GPIOR0_ADDR, profileWrite, NULL);
+
+  /* Arduino pin 2 and 3 are interrupts 0 and 1: PD2/PD3 on the Uno, PE4/PE5 on the Mega */
+  int Mega = !strcmp(Mcu, "atmega2560") || !strcmp(Mcu, "atmega1280");
+  avr_irq_t *Pin = avr_io_getirq(Avr, AVR_IOCTL_IOPORT_GETIRQ(Mega ? 'E' : 'D'),
+    Mega ? (Khz ? 5 : 4) : (Khz ? 3 : 2));
+  avr_raise_irq(Pin, 1);
+  if (SendKhz) { /* Arduino pin 9: PB1 on the Uno, PH6 on the Mega */
+    Carrier.nominal = Avr->frequency / (SendKhz * 1000UL);
+    avr_irq_register_notify(avr_io_getirq(Avr, AVR_IOCTL_IOPORT_GETIRQ(Mega ? 'H' : 'B'), Mega ? 6 : 1),
+      carrierEdge, Avr);
+  }
+
+  /* BENCH_SEND sends a 68ms NEC frame and waits 40ms per loop */
+  uint64_t End = SendKhz ? 20000 + Frames * 110000ULL : Trace ? loadTrace(Trace, Khz) : builtInSignal(Frames, Khz);
+  uint64_t CyclesPerUs = Avr->frequency / 1000000;
+  uint64_t Stop = End * CyclesPerUs;
+  size_t Next = 0;
+  while (Avr->cycle < Stop) {
+    while (Next < Edge_Count && Edges[Next].t * CyclesPerUs <= Avr->cycle) {
+      avr_raise_irq(Pin, Edges[Next].level);
+      Next++;
+    }
+    int State = avr_run(Avr);
+    if (State == cpu_Done || State == cpu_Crashed) {
+      fprintf(stderr, "isr_sim: firmware stopped (state %d) at cycle %llu\n", State, (unsigned long long)Avr->cycle);
+      return 2;
+    }
+  }
+
+  int Failed = 0;
+  printf("%s, %s, %u frames at %lu MHz\n", Mcu, Elf, Trace ? 0 : Frames, (unsigned long)CyclesPerUs);
+  printf("%-34s %8s %8s %8s %8s %8s %s\n", "", "count", "min", "avg", "max", "budget", "max us");
+  for (int i = 1; i < IDS; i++) {
+    if (!Stats[i].count) continue;
+    int Over = Stats[i].max > Budget[i];
+    Failed |= Over;
+    printf("%-34s %8lu %8llu %8.1f %8llu %8lu %6.2f %s\n", Id_Name[i], Stats[i].count,
+      (unsigned long long)Stats[i].min, (double)Stats[i].sum / Stats[i].count,
+      (unsigned long long)Stats[i].max, Budget[i], (double)Stats[i].max / CyclesPerUs, Over ? "OVER BUDGET" : "ok");
+  }
+  if (SendKhz) {
+    if (!Carrier.periods) {printf("no carrier on pin 9\n"); return 1;}
+    double Period = (double)Carrier.sumPeriod / Carrier.periods, High = (double)Carrier.sumHigh / Carrier.periods;
+    double Freq = Avr->frequency / Period / 1000, Percent = 100 * High / Period;
+    unsigned long Ticks = (unsigned long)(Stop / (50 * CyclesPerUs));
+    int FreqOff = Freq < SendKhz * 0.99 || Freq > SendKhz * 1.01;
+    int DutyOff = Percent < Duty - 2.0 || Percent > Duty + 2.0;
+    int TicksLost = Stats[1].count < Ticks * 95 / 100;
+    double Mark = (double)Carrier.maxMark / CyclesPerUs;
+    int MarkOff = Mark < 9024 * 0.98 || Mark > 9024 * 1.02;
+    printf("%-34s %8lu %8llu %8.1f %8llu %6.2f kHz %s\n", "carrier period", Carrier.periods,
+      (unsigned long long)Carrier.minPeriod, Period, (unsigned long long)Carrier.maxPeriod, Freq, FreqOff ? "OFF" : "ok");
+    printf("%-34s %8lu %8llu %8.1f %8llu %6.2f %%   %s\n", "carrier high", Carrier.periods,
+      (unsigned long long)Carrier.minHigh, High, (unsigned long long)Carrier.maxHigh, Percent, DutyOff ? "OFF" : "ok");
+    printf("%-34s %8lu longest %.1f us %s\n", "carrier marks", Carrier.marks, Mark, MarkOff ? "OFF" : "ok");
+    printf("%-34s %8lu of %lu %s\n", "IRrecv ticks while sending", Stats[1].count, Ticks, TicksLost ? "LOST" : "ok");
+    return Failed | FreqOff | DutyOff | MarkOff | TicksLost;
+  }
+  /* the end-of-frame path must have been exercised, otherwise the worst case is not covered */
+  if (Khz ? !Stats[5].count : !(Stats[2].count || Stats[4].count)) {
+    printf("the firmware never took the path under test\n");
+    Failed = 1;
+  }
+  return Failed;
+}
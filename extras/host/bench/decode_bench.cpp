@@ -0,0 +1,300 @@
+/* decode_bench.cpp - decode throughput benchmark for the IRLib host build
+ *
+ * Builds a corpus with the library's own senders: for every protocol, valid frames with exact
+ * timing, jittered copies (every duration moved by up to +-JITTER_PERCENT), and invalid frames
+ * (truncated copies and random timings). It then times these cases:
+ *   - each IRdecodeX::decode on valid and jittered frames of its own protocol
+ *   - the full IRdecode::decode fall-through chain on each protocol's valid frames
+ *   - the chain on invalid frames, the worst case where every decoder is tried and fails
+ *   - IRdecodeHash::decode on all valid frames
+ *   - IRsymbolDecoder (sim/IRLibClassify.h), the chain on IRclassify sets, on the same frames
+ * It reports ns/frame, CPU time stamp cycles/frame (x86 only) and the share of frames decoded
+ * correctly. Each case's time includes copying the frame into rawbuf, as getResults would.
+ *
+ *   decode_bench [--quick] [--csv out.csv] [--compare baseline.csv] [--capture file]
+ *
+ * --csv saves the results as a baseline and --compare prints the change against one.
+ * --capture adds a case for the chain on the frames of a binary capture (sim/IRLibCapture.h),
+ * counted as ok when it decodes them as they were decoded when captured. The exit
+ * status is nonzero if a decoder fails on any of its valid frames.
+ * These are host numbers. They give the relative cost of decoders and of changes to them, not
+ * the time on an ATmega. There is no AVR version of this bench yet: extras/avr-bench only
+ * counts the cycles of the interrupt routines, not of the decoders.
+ */
+#include <IRLib.h>
+#include <IRLibMatch.h>
+#include <IRLibRData.h>
+#include "IRLibCapture.h"
+#include "IRLibClassify.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles(void) {return __rdtsc();}
+#define HAVE_CYCLES 1
+#else
+static inline uint64_t cycles(void) {return 0;}
+#define HAVE_CYCLES 0
+#endif
+
+#define FRAMES_PER_PROTOCOL 16
+#define JITTER_PERCENT 10
+#define BATCHES 15
+#define LEAD_GAP 20000 //us; rawbuf[0], the gap before the frame
+
+struct Frame {
+  uint16_t raw[RAWBUF];
+  uint16_t rawlen;
+  IR_types_t type;      //what the decoder should report; UNKNOWN for invalid frames
+  uint32_t value;
+};
+
+struct Protocol {
+  IR_types_t type;
+  unsigned int data2;
+  uint32_t mask;        //bits of the value the protocol carries
+  IR_types_t decodesAs; //Samsung32 frames are taken by NEC, which is earlier in the chain
+  bool (*decode)(IRdecode &d);
+  const char *decoder;
+};
+
+static bool decodeNEC(IRdecode &d) {return d.IRdecodeNEC::decode();}
+static bool decodeSony(IRdecode &d) {return d.IRdecodeSony::decode();}
+static bool decodeRC5(IRdecode &d) {return d.IRdecodeRC5::decode();}
+static bool decodeRC6(IRdecode &d) {return d.IRdecodeRC6::decode();}
+static bool decodePanasonic_Old(IRdecode &d) {return d.IRdecodePanasonic_Old::decode();}
+static bool decodeJVC(IRdecode &d) {return d.IRdecodeJVC::decode();}
+static bool decodeNECx(IRdecode &d) {return d.IRdecodeNECx::decode();}
+static bool decodePanasonic(IRdecode &d) {return d.IRdecodePanasonic::decode();}
+static bool decodeSamsung32(IRdecode &d) {return d.IRdecodeSamsung32::decode();}
+
+static const Protocol Protocols[] = {
+  {NEC,           0,  0xFFFFFFFF, NEC,           decodeNEC,           "IRdecodeNEC"},
+  {SONY,          20, 0x000FFFFF, SONY,          decodeSony,          "IRdecodeSony"},
+  {RC5,           0,  0x00001FFF, RC5,           decodeRC5,           "IRdecodeRC5"},
+  {RC6,           20, 0x000FFFFF, RC6,           decodeRC6,           "IRdecodeRC6"},
+  {PANASONIC_OLD, 0,  0x003FFFFF, PANASONIC_OLD, decodePanasonic_Old, "IRdecodePanasonic_Old"},
+  {JVC,           1,  0x0000FFFF, JVC,           decodeJVC,           "IRdecodeJVC"},
+  {NECX,          0,  0xFFFFFFFF, NECX,          decodeNECx,          "IRdecodeNECx"},
+  {PANASONIC_NEW, 0,  0x00FFFFFF, PANASONIC_NEW, decodePanasonic,     "IRdecodePanasonic"},
+  {SAMSUNG32,     0,  0xFFFFFFFF, NEC,           decodeSamsung32,     "IRdecodeSamsung32"},
+};
+#define PROTOCOL_COUNT (sizeof(Protocols)/sizeof(Protocols[0]))
+
+static uint32_t Seed = 12345;
+static uint32_t random32(void) {Seed = Seed * 1664525 + 1013904223; return Seed;}
+
+//Records one frame with IRsend. The frame ends at the first long space (JVC sends a repeat
+//frame after it), and that space is not part of what a receiver returns.
+static Frame record(const Protocol &p, uint32_t value) {
+  static uint16_t Buffer[2 * RAWBUF];
+  IRpulseProgram Program(Buffer, 2 * RAWBUF);
+  IRsend Sender;
+  Frame F;
+  Sender.record(&Program);
+  Sender.send(p.type, value, p.data2, false);
+  Sender.record(NULL);
+  F.raw[0] = LEAD_GAP;
+  F.rawlen = 1;
+  for (uint16_t i = 0; i < Program.length && F.rawlen < RAWBUF; i += 2) {
+    F.raw[F.rawlen++] = Program.durations[i];
+    if (i + 2 >= Program.length || Program.durations[i + 1] >= LONG_SPACE_US) break;
+    if (F.rawlen < RAWBUF) F.raw[F.rawlen++] = Program.durations[i + 1];
+  }
+  F.type = p.decodesAs;
+  F.value = value;
+  return F;
+}
+
+static Frame jitter(Frame F) {
+  for (uint16_t i = 1; i < F.rawlen; i++) {
+    int Range = F.raw[i] * JITTER_PERCENT / 100;
+    F.raw[i] += (int)(random32() % (2 * Range + 1)) - Range;
+  }
+  return F;
+}
+
+struct Result {
+  std::string name;
+  std::vector<Frame> frames;
+  bool (*decode)(IRdecode &d); //NULL for IRdecodeHash
+  double ns, cyc;
+  unsigned ok;
+};
+
+static std::vector<Result> Results;
+static long Repeats = 400;
+
+//Adds a case and counts the frames decoded as the expected protocol and value
+static void measure(const std::string &name, const std::vector<Frame> &frames, bool (*decode)(IRdecode &d)) {
+  IRdecode D;
+  IRdecodeHash H;
+  Result R = {name, frames, decode, 0, 0, 0};
+  for (size_t i = 0; i < frames.size(); i++) {
+    D.reset(); //also clears rawlen
+    memcpy((void *)D.rawbuf, frames[i].raw, frames[i].rawlen * sizeof(uint16_t));
+    D.rawlen = H.rawlen = frames[i].rawlen;
+    if (!decode) {
+      if (H.decode()) R.ok++;
+    } else if (decode(D) && D.decode_type == frames[i].type && (uint32_t)D.value == frames[i].value) {
+      R.ok++;
+    }
+  }
+  Results.push_back(R);
+}
+
+/*
+ * Every case is timed BATCHES times, going round all the cases each time, and the fastest
+ * run counts. Noise from the rest of the system comes in bursts; this way a burst spoils
+ * one run of a few cases rather than every run of one case.
+ */
+static void timeAll(void) {
+  IRdecode D;
+  IRdecodeHash H;
+  volatile bool Sink;
+  for (int b = 0; b < BATCHES; b++) {
+    for (size_t c = 0; c < Results.size(); c++) {
+      Result &R = Results[c];
+      const std::vector<Frame> &F = R.frames;
+      auto Start = std::chrono::steady_clock::now();
+      uint64_t C0 = cycles();
+      for (long n = 0; n < Repeats; n++) {
+        for (size_t i = 0; i < F.size(); i++) {
+          memcpy((void *)D.rawbuf, F[i].raw, F[i].rawlen * sizeof(uint16_t));
+          if (!R.decode) {H.rawlen = F[i].rawlen; Sink = H.decode();}
+          else {D.rawlen = F[i].rawlen; Sink = R.decode(D);}
+        }
+      }
+      uint64_t C1 = cycles();
+      double Ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+      double Count = (double)Repeats * F.size();
+      if (!b || Ns / Count < R.ns) {
+        R.ns = Ns / Count;
+        R.cyc = (C1 - C0) / Count;
+      }
+    }
+  }
+  (void)Sink;
+}
+
+static bool decodeChain(IRdecode &d) {return d.decode();}
+
+static IRsymbolDecoder Symbols;
+static bool decodeSymbols(IRdecode &d) {
+  IRdecodeResult R = Symbols.decode((const uint16_t *)d.rawbuf, d.rawlen);
+  d.decode_type = R.decode_type;
+  d.value = R.value;
+  return R.decode_type != UNKNOWN;
+}
+
+int main(int argc, char **argv) {
+  const char *CsvOut = NULL, *Compare = NULL, *Capture = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--quick")) Repeats = 2;
+    else if (!strcmp(argv[i], "--csv") && i + 1 < argc) CsvOut = argv[++i];
+    else if (!strcmp(argv[i], "--compare") && i + 1 < argc) Compare = argv[++i];
+    else if (!strcmp(argv[i], "--capture") && i + 1 < argc) Capture = argv[++i];
+    else {
+      fprintf(stderr, "usage: decode_bench [--quick] [--csv out.csv] [--compare baseline.csv] [--capture file]\n");
+      return 2;
+    }
+  }
+  IRhost_reset();
+  //let the CPU clock ramp up before anything is timed
+  for (auto Start = std::chrono::steady_clock::now(); std::chrono::steady_clock::now() - Start < std::chrono::milliseconds(Repeats / 10););
+
+  std::vector<Frame> Valid[PROTOCOL_COUNT], Jittered[PROTOCOL_COUNT], AllValid, Invalid;
+  for (unsigned p = 0; p < PROTOCOL_COUNT; p++) {
+    for (int i = 0; i < FRAMES_PER_PROTOCOL; i++) {
+      Frame F = record(Protocols[p], random32() & Protocols[p].mask);
+      Valid[p].push_back(F);
+      Jittered[p].push_back(jitter(F));
+      AllValid.push_back(F);
+      Frame T = F;
+      T.rawlen = F.rawlen / 2 | 1;
+      T.type = UNKNOWN;
+      Invalid.push_back(T);
+    }
+  }
+  for (int i = 0; i < FRAMES_PER_PROTOCOL; i++) {
+    Frame F;
+    F.rawlen = 10 + random32() % (RAWBUF - 10);
+    F.raw[0] = LEAD_GAP;
+    for (uint16_t j = 1; j < F.rawlen; j++) F.raw[j] = 200 + random32() % 2800;
+    F.type = UNKNOWN; F.value = 0;
+    Invalid.push_back(F);
+  }
+
+  for (unsigned p = 0; p < PROTOCOL_COUNT; p++) {
+    std::string Name = Protocols[p].decoder;
+    std::vector<Frame> Own = Valid[p];
+    if (Protocols[p].decodesAs != Protocols[p].type)
+      for (size_t i = 0; i < Own.size(); i++) Own[i].type = Protocols[p].type;
+    measure(Name + " valid", Own, Protocols[p].decode);
+    std::vector<Frame> OwnJitter = Jittered[p];
+    for (size_t i = 0; i < OwnJitter.size(); i++) OwnJitter[i].type = Protocols[p].type;
+    measure(Name + " jittered", OwnJitter, Protocols[p].decode);
+  }
+  for (unsigned p = 0; p < PROTOCOL_COUNT; p++)
+    measure(std::string("IRdecode chain ") + (const char *)Pnames(Protocols[p].type), Valid[p], decodeChain);
+  measure("IRdecode chain invalid (worst case)", Invalid, decodeChain);
+  measure("IRdecodeHash all valid", AllValid, NULL);
+  for (unsigned p = 0; p < PROTOCOL_COUNT; p++)
+    measure(std::string("IRsymbolDecoder ") + (const char *)Pnames(Protocols[p].type), Valid[p], decodeSymbols);
+  measure("IRsymbolDecoder invalid (worst case)", Invalid, decodeSymbols);
+  if (Capture) {
+    IRcaptureFile File;
+    if (!File.open(Capture)) return 1;
+    std::vector<Frame> Captured(File.size());
+    for (size_t i = 0; i < File.size(); i++) {
+      IRcaptureFrame C = File.frame(i);
+      Captured[i].rawlen = C.durations(Captured[i].raw, RAWBUF);
+      Captured[i].type = C.protocol;
+      Captured[i].value = C.value;
+    }
+    measure("IRdecode chain capture", Captured, decodeChain);
+    measure("IRsymbolDecoder capture", Captured, decodeSymbols);
+  }
+  timeAll();
+
+  std::map<std::string, double> Baseline;
+  if (Compare) {
+    FILE *f = fopen(Compare, "r");
+    if (!f) {perror(Compare); return 1;}
+    char Line[256];
+    while (fgets(Line, sizeof(Line), f)) {
+      char *Comma = strchr(Line, ',');
+      if (!Comma || !strncmp(Line, "case,", 5)) continue;
+      *Comma = 0;
+      Baseline[Line] = atof(Comma + 1);
+    }
+    fclose(f);
+  }
+
+  int Failed = 0;
+  printf("IRclassify: %s\n", IRclassify_implementation());
+  printf("%-40s %10s %10s %8s%s\n", "case", "ns/frame", HAVE_CYCLES ? "cyc/frame" : "", "ok", Compare ? "   vs baseline" : "");
+  for (size_t i = 0; i < Results.size(); i++) {
+    const Result &R = Results[i];
+    printf("%-40s %10.1f %10.0f %4u/%-3u", R.name.c_str(), R.ns, R.cyc, R.ok, (unsigned)R.frames.size());
+    if (Compare && Baseline.count(R.name))
+      printf("   %+6.1f%%", 100.0 * (R.ns - Baseline[R.name]) / Baseline[R.name]);
+    printf("\n");
+    //every decoder must take all of its own valid frames
+    if (R.name.find(" valid") != std::string::npos && R.name.find("Hash") == std::string::npos && R.ok != R.frames.size()) Failed++;
+  }
+  if (CsvOut) {
+    FILE *f = fopen(CsvOut, "w");
+    if (!f) {perror(CsvOut); return 1;}
+    fprintf(f, "case,ns_per_frame,cycles_per_frame,ok,frames\n");
+    for (size_t i = 0; i < Results.size(); i++)
+      fprintf(f, "%s,%.2f,%.0f,%u,%u\n", Results[i].name.c_str(), Results[i].ns, Results[i].cyc, Results[i].ok, (unsigned)Results[i].frames.size());
+    fclose(f);
+  }
+  return Failed ? 1 : 0;
+}
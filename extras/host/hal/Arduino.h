@@ -0,0 +1,126 @@
+/* Arduino.h for the IRLib host build (see extras/host/README.md)
+ * This is NOT the Arduino core. It is a small shim that provides just enough of the Arduino API
+ * for IRLib.cpp to compile and run on a workstation: a virtual microsecond clock, virtual pins,
+ * interrupts that can be fired by the test code, and a Serial object whose output is captured.
+ * The functions that control the virtual hardware are declared in IRLibHost.h.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <type_traits>
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+#ifndef ARDUINO
+#define ARDUINO 10800 //a core with Print::availableForWrite
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define LED_BUILTIN 13
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+//Arduino defines min and max as macros. Templates keep them from clashing with the C++ library.
+template<class A, class B> inline typename std::common_type<A,B>::type min(A a, B b) {return (b < a) ? b : a;}
+template<class A, class B> inline typename std::common_type<A,B>::type max(A a, B b) {return (a < b) ? b : a;}
+
+//Program memory is ordinary memory on the host
+#define PROGMEM
+#define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+//Virtual pins
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+#define digitalPinToPort(pin) ((pin)/8)
+#define digitalPinToBitMask(pin) ((uint8_t)(1 << ((pin)%8)))
+#define portOutputRegister(port) (&IRhost_ports[(port)])
+#define portInputRegister(port) (&IRhost_ports[(port)])
+#define digitalPinToInterrupt(pin) ((pin)==2 ? 0 : ((pin)==3 ? 1 : -1))
+extern volatile uint8_t IRhost_ports[];
+
+//Virtual clock; delays advance it
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+//Interrupts
+void attachInterrupt(uint8_t inum, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t inum);
+#define cli()
+#define sei()
+#define interrupts()
+#define noInterrupts()
+
+//Minimal Print class with the overloads IRLib and its examples use
+class Print {
+public:
+  virtual size_t write(uint8_t c) = 0;
+  virtual int availableForWrite(void) {return 0;}
+  size_t write(const char *s) {size_t n=0; while(*s) n+=write((uint8_t)*s++); return n;}
+  size_t write(const uint8_t *buf, size_t len) {size_t n=0; while(len--) n+=write(*buf++); return n;}
+  size_t print(const __FlashStringHelper *s) {return write(reinterpret_cast<const char *>(s));}
+  size_t print(const char *s) {return write(s);}
+  size_t print(char c) {return write((uint8_t)c);}
+  size_t print(unsigned char n, int base=DEC) {return printNumber(n, base);}
+  size_t print(int n, int base=DEC) {return printSigned(n, base);}
+  size_t print(unsigned int n, int base=DEC) {return printNumber(n, base);}
+  size_t print(long n, int base=DEC) {return printSigned(n, base);}
+  size_t print(unsigned long n, int base=DEC) {return printNumber(n, base);}
+  size_t print(long long n, int base=DEC) {return printSigned(n, base);}
+  size_t print(unsigned long long n, int base=DEC) {return printNumber(n, base);}
+  size_t print(double n, int digits=2);
+  size_t println(void) {return write("\r\n");}
+  template<class T> size_t println(T v) {size_t n=print(v); return n+println();}
+  template<class T> size_t println(T v, int fmt) {size_t n=print(v, fmt); return n+println();}
+private:
+  size_t printNumber(unsigned long long n, int base);
+  size_t printSigned(long long n, int base);
+};
+
+//Serial output is kept in memory; see IRhost_serialOutput in IRLibHost.h
+class HardwareSerial: public Print {
+public:
+  void begin(unsigned long) {}
+  void end(void) {}
+  int available(void) {return 0;}
+  int read(void) {return -1;}
+  virtual int availableForWrite(void);
+  void flush(void) {}
+  operator bool() {return true;}
+  virtual size_t write(uint8_t c);
+  using Print::write;
+};
+extern HardwareSerial Serial;
+
+#include "IRLibHost.h"
+
+#endif //Arduino_h
@@ -0,0 +1,47 @@
+/* IRLibHost.h - control of the virtual hardware used by the IRLib host build
+ * Test, benchmark and replay programs use these calls to move the virtual clock, drive the
+ * receiver input pin, watch the infrared output and read back what was printed to Serial.
+ * Nothing here exists on a real Arduino.
+ */
+#ifndef IRLibHost_h
+#define IRLibHost_h
+#include <stdint.h>
+#include <stddef.h>
+
+//Puts the clock back to zero and clears pins, interrupts, tick timer, carrier and Serial output
+void IRhost_reset(void);
+
+//Virtual clock in microseconds. IRhost_advance fires any timer ticks that fall due on the way.
+uint64_t IRhost_now(void);
+void IRhost_advance(unsigned long us);
+void IRhost_advanceTo(uint64_t t_us);
+
+//Drive an input pin as an IR receiver would (idle HIGH, LOW during a mark). Fires the
+//interrupt attached to that pin, if any, at the current virtual time.
+void IRhost_setPin(uint8_t pin, bool level);
+
+//The infrared output. IR_SEND_PWM_START/STOP switch the carrier; IR_SEND_CONFIG_KHZ sets it.
+void IRhost_carrier(bool on);
+void IRhost_configCarrier(unsigned char khz);
+unsigned char IRhost_carrierKHz(void);
+bool IRhost_carrierIsOn(void);
+//Connect the carrier to an input pin the way a receiver looking at our own LED would see it
+//(LOW while the carrier is on). Pass 255 to disconnect.
+void IRhost_loopback(uint8_t recvpin);
+//Called on every carrier transition with the virtual time stamp
+typedef void (*IRhost_carrierHook)(uint64_t t_us, bool on);
+void IRhost_onCarrierEdge(IRhost_carrierHook hook);
+
+//The periodic timer used by IRrecv. A NULL handler disables it.
+void IRhost_configTicks(unsigned int usecPerTick);
+void IRhost_enableTicks(void (*handler)(void));
+extern "C" void IRhost_tick_ISR(void); //the name IRLibTimer.h gives ISR(IR_RECV_INTR_NAME)
+
+//Serial output is collected in memory and optionally echoed to stdout
+const char *IRhost_serialOutput(void);
+size_t IRhost_serialSize(void); //bytes of output; binary output may contain zeros
+void IRhost_serialClear(void);
+void IRhost_serialEcho(bool echo);
+void IRhost_serialTxRoom(int bytes); //value reported by Serial.availableForWrite()
+
+#endif //IRLibHost_h
@@ -0,0 +1,7 @@
+/* avr/interrupt.h for the IRLib host build
+ * An ISR becomes an ordinary C function that the host HAL calls from its virtual timer.
+ */
+#ifndef IRLibHost_interrupt_h
+#define IRLibHost_interrupt_h
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+#endif
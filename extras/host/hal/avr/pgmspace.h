@@ -0,0 +1,2 @@
+/* avr/pgmspace.h for the IRLib host build; everything lives in Arduino.h */
+#include <Arduino.h>
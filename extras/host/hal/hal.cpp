@@ -0,0 +1,144 @@
+/* hal.cpp - virtual hardware for the IRLib host build; see IRLibHost.h */
+#include <Arduino.h>
+#include <stdio.h>
+#include <string>
+
+#define HOST_PINS 64
+#define HOST_INTERRUPTS 2
+volatile uint8_t IRhost_ports[HOST_PINS/8];
+HardwareSerial Serial;
+
+static uint64_t Now;
+static uint8_t Pin_Mode[HOST_PINS];
+static uint8_t Pin_Input[HOST_PINS];
+static void (*Handlers[HOST_INTERRUPTS])(void);
+static int Handler_Mode[HOST_INTERRUPTS];
+static const uint8_t Intr_Pin[HOST_INTERRUPTS] = {2, 3}; //same as Pin_from_Intr for an Uno
+static void (*Tick_Handler)(void);
+static unsigned int Tick_Period = 50;
+static uint64_t Next_Tick;
+static int In_Handler; //nonzero while a simulated ISR runs; nested interrupts wait until it returns
+static bool Carrier_On;
+static unsigned char Carrier_KHz;
+static uint8_t Loopback_Pin = 255;
+static IRhost_carrierHook Carrier_Hook;
+static std::string Serial_Text;
+static bool Serial_Echo;
+static int Serial_Room = 63;
+
+void IRhost_reset(void) {
+  Now = 0;
+  memset((void *)IRhost_ports, 0, sizeof(IRhost_ports));
+  memset(Pin_Mode, INPUT, sizeof(Pin_Mode));
+  memset(Pin_Input, HIGH, sizeof(Pin_Input));
+  for (int i = 0; i < HOST_INTERRUPTS; i++) Handlers[i] = NULL;
+  Tick_Handler = NULL; Tick_Period = 50; Next_Tick = 0; In_Handler = 0;
+  Carrier_On = false; Carrier_KHz = 0; Loopback_Pin = 255; Carrier_Hook = NULL;
+  Serial_Text.clear(); Serial_Room = 63;
+}
+
+uint64_t IRhost_now(void) {return Now;}
+
+void IRhost_advanceTo(uint64_t t) {
+  while (!In_Handler && Tick_Handler && Next_Tick <= t) {
+    if (Next_Tick > Now) Now = Next_Tick;
+    Next_Tick += Tick_Period;
+    In_Handler++; Tick_Handler(); In_Handler--;
+  }
+  if (t > Now) Now = t;
+}
+
+void IRhost_advance(unsigned long us) {IRhost_advanceTo(Now + us);}
+
+void IRhost_setPin(uint8_t pin, bool level) {
+  if (pin >= HOST_PINS || Pin_Input[pin] == level) return;
+  Pin_Input[pin] = level;
+  for (int i = 0; i < HOST_INTERRUPTS; i++) {
+    if (Intr_Pin[i] != pin || !Handlers[i]) continue;
+    if (Handler_Mode[i] == CHANGE || (Handler_Mode[i] == FALLING && !level) || (Handler_Mode[i] == RISING && level))
+      {In_Handler++; Handlers[i](); In_Handler--;}
+  }
+}
+
+void IRhost_carrier(bool on) {
+  if (on == Carrier_On) return;
+  Carrier_On = on;
+  if (Carrier_Hook) Carrier_Hook(Now, on);
+  if (Loopback_Pin != 255) IRhost_setPin(Loopback_Pin, !on);
+}
+void IRhost_configCarrier(unsigned char khz) {Carrier_KHz = khz;}
+unsigned char IRhost_carrierKHz(void) {return Carrier_KHz;}
+bool IRhost_carrierIsOn(void) {return Carrier_On;}
+void IRhost_loopback(uint8_t recvpin) {Loopback_Pin = recvpin;}
+void IRhost_onCarrierEdge(IRhost_carrierHook hook) {Carrier_Hook = hook;}
+
+void IRhost_configTicks(unsigned int usecPerTick) {Tick_Period = usecPerTick ? usecPerTick : 1;}
+void IRhost_enableTicks(void (*handler)(void)) {
+  if (handler && !Tick_Handler) Next_Tick = Now + Tick_Period;
+  Tick_Handler = handler;
+}
+
+const char *IRhost_serialOutput(void) {return Serial_Text.c_str();}
+size_t IRhost_serialSize(void) {return Serial_Text.size();}
+void IRhost_serialClear(void) {Serial_Text.clear();}
+void IRhost_serialEcho(bool echo) {Serial_Echo = echo;}
+void IRhost_serialTxRoom(int bytes) {Serial_Room = bytes;}
+
+//Arduino API
+void pinMode(uint8_t pin, uint8_t mode) {if (pin < HOST_PINS) Pin_Mode[pin] = mode;}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= HOST_PINS) return;
+  if (val) IRhost_ports[digitalPinToPort(pin)] |= digitalPinToBitMask(pin);
+  else IRhost_ports[digitalPinToPort(pin)] &= ~digitalPinToBitMask(pin);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= HOST_PINS) return LOW;
+  if (Pin_Mode[pin] == OUTPUT) return (IRhost_ports[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH : LOW;
+  return Pin_Input[pin];
+}
+
+//Every call to micros() costs one microsecond so that polling loops such as
+//"while(micros()-start < t);" make progress.
+unsigned long micros(void) {uint64_t t = Now; IRhost_advance(1); return (unsigned long)t;}
+unsigned long millis(void) {return (unsigned long)(Now / 1000);}
+void delay(unsigned long ms) {IRhost_advance(ms * 1000UL);}
+void delayMicroseconds(unsigned int us) {IRhost_advance(us);}
+
+void attachInterrupt(uint8_t inum, void (*handler)(void), int mode) {
+  if (inum >= HOST_INTERRUPTS) return;
+  Handlers[inum] = handler; Handler_Mode[inum] = mode;
+}
+void detachInterrupt(uint8_t inum) {if (inum < HOST_INTERRUPTS) Handlers[inum] = NULL;}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+  char buf[8 * sizeof(n) + 1];
+  char *p = &buf[sizeof(buf) - 1];
+  *p = 0;
+  if (base < 2) base = 10;
+  do {
+    int d = n % base; n /= base;
+    *--p = d < 10 ? '0' + d : 'A' + d - 10;
+  } while (n);
+  return write(p);
+}
+
+size_t Print::printSigned(long long n, int base) {
+  if (base == 10 && n < 0) return write((uint8_t)'-') + printNumber(-(unsigned long long)n, 10);
+  return printNumber((unsigned long long)n, base); //like Arduino, other bases print the raw bits
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+int HardwareSerial::availableForWrite(void) {return Serial_Room;}
+
+size_t HardwareSerial::write(uint8_t c) {
+  Serial_Text += (char)c;
+  if (Serial_Echo) putchar(c);
+  return 1;
+}
@@ -0,0 +1,11 @@
+/* util/atomic.h for the IRLib host build
+ * Host "interrupts" are plain function calls made by the simulation code, never asynchronous,
+ * so an atomic block only has to run its body once.
+ */
+#ifndef IRLibHost_atomic_h
+#define IRLibHost_atomic_h
+#define ATOMIC_RESTORESTATE 1
+#define ATOMIC_FORCEON 2
+#define ATOMIC_BLOCK(type) for(int _irlib_atomic_once = 1; _irlib_atomic_once; _irlib_atomic_once = 0)
+#define NONATOMIC_BLOCK(type) ATOMIC_BLOCK(type)
+#endif
@@ -0,0 +1,411 @@
+/* IRLibAnalyze.cpp - infers the parameters of an unknown protocol; see IRLibAnalyze.h */
+#include "IRLibAnalyze.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPLIT_SLACK 50   //us; with 20% of the duration, the gap between sorted durations that splits a peak
+#define KMEANS_ROUNDS 20
+
+uint64_t IRanalyzeFrame::end(void) const {
+  uint64_t t = start;
+  for (size_t i = 0; i < durations.size(); i++) t += durations[i];
+  return t;
+}
+
+std::vector<IRanalyzeFrame> IRanalyze_frames(const IRtrace &trace, uint32_t gap_us) {
+  std::vector<IRanalyzeFrame> Frames;
+  IRanalyzeFrame Frame;
+  const std::vector<IRtraceEdge> &E = trace.edges;
+  for (size_t i = 0; i + 1 < E.size(); i++) {
+    uint64_t d = E[i + 1].t - E[i].t;
+    if (E[i].level == 0) { //a mark
+      if (Frame.durations.empty()) Frame.start = E[i].t;
+      Frame.durations.push_back(d > 0xFFFF ? 0xFFFF : d);
+    } else if (!Frame.durations.empty()) {
+      if (d > gap_us) {Frames.push_back(Frame); Frame.durations.clear();}
+      else Frame.durations.push_back(d);
+    }
+  }
+  if (!Frame.durations.empty()) {
+    //a trace normally ends with the pin back at space; a last mark still open is dropped
+    if (E.back().level == 0 && Frame.durations.size() % 2 == 0) Frame.durations.pop_back();
+    if (!Frame.durations.empty()) Frames.push_back(Frame);
+  }
+  return Frames;
+}
+
+std::vector<IRanalyzeFrame> IRanalyze_frames(const IRcaptureFile &file) {
+  std::vector<IRanalyzeFrame> Frames;
+  for (size_t i = 0; i < file.size(); i++) {
+    IRcaptureFrame C = file.frame(i);
+    if (C.count < 2) continue;
+    IRanalyzeFrame Frame;
+    Frame.durations.resize(C.count);
+    Frame.durations.resize(C.durations(Frame.durations.data(), C.count));
+    if (Frame.durations.size() < 2) continue;
+    Frame.durations.erase(Frame.durations.begin()); //rawbuf[0] is the gap before the frame
+    Frame.start = 0;
+    uint64_t Length = Frame.end();
+    Frame.start = C.t > Length ? C.t - Length : 0;
+    Frames.push_back(Frame);
+  }
+  return Frames;
+}
+
+static double distance(double v, double center) {return fabs(v - center) / center;}
+
+static size_t nearest(const std::vector<IRanalyzeCluster> &c, double v) {
+  size_t Best = 0;
+  for (size_t k = 1; k < c.size(); k++)
+    if (distance(v, c[k].center) < distance(v, c[Best].center)) Best = k;
+  return Best;
+}
+
+//True if MATCH would take a duration of center b for one of center a
+static bool close(double a, double b) {
+  return b >= a * 0.75 && b <= a * 1.25;
+}
+
+/*
+ * Sorted durations form peaks. A gap wider than 20% (plus the 50us of a receiver tick) between
+ * neighbours starts a new one, and the peaks' means seed k-means, which moves members to
+ * their nearest center until nothing moves. Centers that MATCH could not tell apart are merged.
+ */
+static std::vector<IRanalyzeCluster> cluster(std::vector<uint16_t> v) {
+  std::vector<IRanalyzeCluster> C;
+  if (v.empty()) return C;
+  std::sort(v.begin(), v.end());
+  size_t First = 0;
+  for (size_t i = 1; i <= v.size(); i++)
+    if (i == v.size() || v[i] > v[i - 1] + v[i - 1] / 5 + SPLIT_SLACK) {
+      IRanalyzeCluster K = {0, (uint32_t)(i - First), v[First], v[i - 1]};
+      for (size_t j = First; j < i; j++) K.center += v[j];
+      K.center /= K.count;
+      C.push_back(K);
+      First = i;
+    }
+  for (int Round = 0; Round < KMEANS_ROUNDS; Round++) {
+    std::vector<IRanalyzeCluster> N(C.size());
+    for (size_t k = 0; k < N.size(); k++) {N[k].center = 0; N[k].count = 0; N[k].low = 0xFFFF; N[k].high = 0;}
+    for (size_t i = 0; i < v.size(); i++) {
+      IRanalyzeCluster &K = N[nearest(C, v[i])];
+      K.center += v[i]; K.count++;
+      K.low = std::min(K.low, v[i]); K.high = std::max(K.high, v[i]);
+    }
+    bool Moved = false;
+    std::vector<IRanalyzeCluster> Kept;
+    for (size_t k = 0; k < N.size(); k++) {
+      if (!N[k].count) {Moved = true; continue;}
+      N[k].center /= N[k].count;
+      Moved = Moved || N[k].count != C[k].count;
+      Kept.push_back(N[k]);
+    }
+    C = Kept;
+    if (!Moved) break;
+  }
+  for (size_t k = 0; k + 1 < C.size(); ) {
+    if (close(C[k].center, C[k + 1].center) && close(C[k + 1].center, C[k].center)) {
+      IRanalyzeCluster &A = C[k], &B = C[k + 1];
+      A.center = (A.center * A.count + B.center * B.count) / (A.count + B.count);
+      A.count += B.count; A.high = B.high;
+      C.erase(C.begin() + k + 1);
+    } else k++;
+  }
+  return C;
+}
+
+template<class T> static T mostCommon(const std::vector<T> &v) {
+  std::vector<T> S(v);
+  std::sort(S.begin(), S.end());
+  T Best = S.empty() ? T() : S[0];
+  size_t BestRun = 0;
+  for (size_t i = 0, Run = 0; i < S.size(); i++) {
+    Run = (i && S[i] == S[i - 1]) ? Run + 1 : 1;
+    if (Run > BestRun) {BestRun = Run; Best = S[i];}
+  }
+  return Best;
+}
+
+static bool samePayload(const IRpayload &a, const IRpayload &b) {
+  if (a.length != b.length) return false;
+  for (uint8_t n = 0; n < (a.length + 7) / 8; n++) if (a.byteAt(n) != b.byteAt(n)) return false;
+  return true;
+}
+
+static void shiftIn(IRpayload &p, bool bit) {
+  if (p.length < IR_PAYLOAD_BITS) p.shiftIn(bit);
+}
+
+//The bits of a bi-phase frame from durations[start] on. wide is set to 1 + the bit sent at
+//double width (RC6's trailer), or 0. False if it is not Manchester coded.
+static bool biphase(const std::vector<uint16_t> &d, size_t start, double unit, bool header,
+    IRpayload &value, uint8_t &wide) {
+  std::vector<uint8_t> Levels;  //half bits, 1 for mark
+  for (size_t i = start; i < d.size(); i++) {
+    long n = lround(d[i] / unit);
+    if (n < 1 || n > 3) return false;
+    Levels.insert(Levels.end(), n, (i % 2) ? 0 : 1);
+  }
+  //without a header the first half of the start bit is a space lost in the gap (RC5); a last
+  //half that is a space is lost in the gap after the frame
+  if (!header && !Levels.empty() && Levels[0]) Levels.insert(Levels.begin(), 0);
+  if (Levels.size() % 2) Levels.push_back(0);
+  value.clear();
+  wide = 0;
+  for (size_t i = 0; i < Levels.size(); i += 2) {
+    uint8_t A = Levels[i], B = Levels[i + 1];
+    if (A == B) { //a double width bit is four half bits: A A B B
+      if (wide || i + 3 >= Levels.size() || Levels[i + 2] != Levels[i + 3] || Levels[i + 2] == A) return false;
+      wide = value.length + 1;
+      B = Levels[i + 2];
+      i += 2;
+    }
+    shiftIn(value, header ? A && !B : !A && B);
+  }
+  return true;
+}
+
+//True if d is full with its header mark and space taken off, within 25%, as JVC repeats
+static bool withoutHeader(const std::vector<uint16_t> &d, const std::vector<uint16_t> &full) {
+  if (d.size() + 2 != full.size()) return false;
+  for (size_t j = 0; j < d.size(); j++)
+    if (std::abs((int)d[j] - (int)full[j + 2]) * 4 > full[j + 2]) return false;
+  return true;
+}
+
+IRanalyzeResult IRanalyze(const std::vector<IRanalyzeFrame> &frames) {
+  IRanalyzeResult R;
+  R.encoding = IR_ANALYZE_UNKNOWN;
+  R.frames = frames.size();
+  R.repeatFrames = R.irregular = R.presses = 0;
+  R.headMark = R.headSpace = R.markOne = R.markZero = R.spaceOne = R.spaceZero = R.unit = R.wideBit = 0;
+  R.stop = false; R.bits = 0; R.rawCount = 0; R.repeatsFull = false; R.period = 0;
+  if (frames.empty()) return R;
+
+  //full frames are at least half as long as the longest, and are not the last longest frame
+  //without its header; the rest are taken for repeat frames
+  size_t Longest = 0;
+  for (size_t i = 0; i < frames.size(); i++) Longest = std::max(Longest, frames[i].durations.size());
+  std::vector<bool> Full(frames.size());
+  std::vector<uint16_t> Marks, Spaces;
+  const std::vector<uint16_t> *Last = NULL;
+  for (size_t i = 0; i < frames.size(); i++) {
+    const std::vector<uint16_t> &d = frames[i].durations;
+    Full[i] = d.size() * 2 >= Longest && !(Last && withoutHeader(d, *Last));
+    if (d.size() == Longest) Last = &d;
+    if (!Full[i]) {R.repeatFrames++; continue;}
+    for (size_t j = 0; j < d.size(); j++) (j % 2 ? Spaces : Marks).push_back(d[j]);
+  }
+  R.marks = cluster(Marks);
+  R.spaces = cluster(Spaces);
+
+  //header: the first mark's cluster does not occur later in the frame
+  std::vector<size_t> FirstMark, DataMarks(R.marks.size()), DataSpaces(R.spaces.size());
+  for (size_t i = 0; i < frames.size(); i++)
+    if (Full[i]) FirstMark.push_back(nearest(R.marks, frames[i].durations[0]));
+  size_t Head = mostCommon(FirstMark), HeadUse = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (!Full[i]) continue;
+    const std::vector<uint16_t> &d = frames[i].durations;
+    for (size_t j = 2; j < d.size(); j += 2) HeadUse += nearest(R.marks, d[j]) == Head;
+  }
+  bool Header = HeadUse * 20 < Marks.size(); //allow for a few damaged frames
+  size_t Start = Header ? 2 : 0;
+  std::vector<size_t> HeadSpace;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (!Full[i]) continue;
+    const std::vector<uint16_t> &d = frames[i].durations;
+    if (Header && d.size() > 1) HeadSpace.push_back(nearest(R.spaces, d[1]));
+    for (size_t j = Start; j < d.size(); j++)
+      (j % 2 ? DataSpaces[nearest(R.spaces, d[j])] : DataMarks[nearest(R.marks, d[j])])++;
+  }
+  if (Header) {
+    R.headMark = lround(R.marks[Head].center);
+    if (!HeadSpace.empty()) R.headSpace = lround(R.spaces[mostCommon(HeadSpace)].center);
+  }
+
+  //the clusters the data uses, less stray ones of under 2% that damaged frames make
+  std::vector<size_t> M, S;
+  size_t MarkTotal = 0, SpaceTotal = 0;
+  for (size_t k = 0; k < DataMarks.size(); k++) MarkTotal += DataMarks[k];
+  for (size_t k = 0; k < DataSpaces.size(); k++) SpaceTotal += DataSpaces[k];
+  for (size_t k = 0; k < DataMarks.size(); k++) if (DataMarks[k] * 50 > MarkTotal) M.push_back(k);
+  for (size_t k = 0; k < DataSpaces.size(); k++) if (DataSpaces[k] * 50 > SpaceTotal) S.push_back(k);
+
+  if (M.size() == 1 && S.size() == 2) {
+    R.encoding = IR_ANALYZE_PULSE_DISTANCE;
+    R.markOne = R.markZero = lround(R.marks[M[0]].center);
+    R.spaceZero = lround(R.spaces[S[0]].center);
+    R.spaceOne = lround(R.spaces[S[1]].center);
+    R.stop = true;
+  } else if (M.size() == 2 && S.size() == 1) {
+    R.encoding = IR_ANALYZE_PULSE_WIDTH;
+    R.markZero = lround(R.marks[M[0]].center);
+    R.markOne = lround(R.marks[M[1]].center);
+    R.spaceOne = R.spaceZero = lround(R.spaces[S[0]].center);
+  } else if (!M.empty() && !S.empty()) {
+    //bi-phase: marks and spaces both come in one and two units, and three at most twice a frame (next to a double width bit)
+    double Unit = std::min(R.marks[M[0]].center, R.spaces[S[0]].center), UnitSum = 0;
+    unsigned UnitCount = 0, Single[2] = {0, 0}, Double[2] = {0, 0};
+    bool Biphase = true;
+    for (size_t k = 0; k < M.size() + S.size(); k++) {
+      int Space = k >= M.size();
+      const IRanalyzeCluster &C = Space ? R.spaces[S[k - M.size()]] : R.marks[M[k]];
+      if (close(Unit, C.center)) {UnitSum += C.center * C.count; UnitCount += C.count; Single[Space]++;}
+      else if (close(2 * Unit, C.center)) Double[Space]++;
+      else if (!close(3 * Unit, C.center) || C.count > 2 * (R.frames - R.repeatFrames)) Biphase = false;
+    }
+    if (Biphase && Single[0] && Single[1] && Double[0] && Double[1]) {
+      R.encoding = IR_ANALYZE_BIPHASE;
+      R.unit = lround(UnitSum / UnitCount);
+    }
+  }
+
+  //the bits of each full frame
+  std::vector<IRpayload> Values(frames.size());
+  std::vector<bool> Regular(frames.size());
+  std::vector<uint16_t> Lengths, Counts;
+  std::vector<uint8_t> Wide(frames.size());
+  for (size_t i = 0; i < frames.size() && R.encoding != IR_ANALYZE_UNKNOWN; i++) {
+    if (!Full[i]) continue;
+    const std::vector<uint16_t> &d = frames[i].durations;
+    bool Ok = d.size() > Start;
+    if (R.encoding == IR_ANALYZE_BIPHASE) Ok = Ok && biphase(d, Start, R.unit, Header, Values[i], Wide[i]);
+    else {
+      bool Distance = R.encoding == IR_ANALYZE_PULSE_DISTANCE;
+      //pulse distance: a bit per space, and the last mark is a stop; pulse width: a bit per mark
+      for (size_t j = Start + (Distance ? 1 : 0); Ok && j < d.size(); j += 2) {
+        if (Distance && !close(R.markZero, d[j - 1])) Ok = false;
+        else if (!Distance && j + 1 < d.size() && !close(R.spaceOne, d[j + 1])) Ok = false;
+        else if (close(Distance ? R.spaceOne : R.markOne, d[j])) shiftIn(Values[i], 1);
+        else if (close(Distance ? R.spaceZero : R.markZero, d[j])) shiftIn(Values[i], 0);
+        else Ok = false;
+      }
+      Ok = Ok && (!Distance || close(R.markZero, d.back()));
+    }
+    Regular[i] = Ok;
+    if (Ok) {Lengths.push_back(Values[i].length); Counts.push_back(d.size());}
+    else R.irregular++;
+  }
+  if (!Lengths.empty()) {
+    R.bits = mostCommon(Lengths);
+    std::vector<uint8_t> Wides;
+    uint16_t Count = 0;
+    bool OneCount = true;
+    for (size_t i = 0; i < frames.size(); i++) {
+      if (!Regular[i]) continue;
+      if (Values[i].length != R.bits) {Regular[i] = false; R.irregular++; continue;}
+      if (Count && frames[i].durations.size() != Count) OneCount = false;
+      Count = frames[i].durations.size();
+      if (R.encoding == IR_ANALYZE_BIPHASE) Wides.push_back(Wide[i]);
+    }
+    if (OneCount) R.rawCount = Count + 1; //rawbuf[0] is the gap
+    if (!Wides.empty()) R.wideBit = mostCommon(Wides);
+  }
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (!Regular[i]) continue;
+    size_t k = 0;
+    while (k < R.codes.size() && !samePayload(R.codes[k].value, Values[i])) k++;
+    if (k == R.codes.size()) {IRanalyzeCode C; C.value = Values[i]; C.count = 0; R.codes.push_back(C);}
+    R.codes[k].count++;
+  }
+  std::stable_sort(R.codes.begin(), R.codes.end(),
+    [](const IRanalyzeCode &a, const IRanalyzeCode &b) {return a.count > b.count;});
+
+  //presses, the period within a press, and the shape of the repeat frame
+  std::vector<uint32_t> Periods;
+  std::vector<size_t> RepeatLengths;
+  unsigned FullInPress = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    bool NewPress = !i || frames[i].start - frames[i - 1].end() > IR_ANALYZE_PRESS_GAP;
+    if (NewPress) {R.presses++; FullInPress = 0;}
+    else Periods.push_back(frames[i].start - frames[i - 1].start);
+    if (Full[i] && ++FullInPress > 1) R.repeatsFull = true;
+    if (!Full[i]) RepeatLengths.push_back(frames[i].durations.size());
+  }
+  if (!Periods.empty()) {
+    std::sort(Periods.begin(), Periods.end());
+    R.period = Periods[Periods.size() / 2];
+  }
+  if (!RepeatLengths.empty()) {
+    size_t Length = mostCommon(RepeatLengths), Count = 0;
+    std::vector<double> Sum(Length);
+    for (size_t i = 0; i < frames.size(); i++) {
+      if (Full[i] || frames[i].durations.size() != Length) continue;
+      for (size_t j = 0; j < Length; j++) Sum[j] += frames[i].durations[j];
+      Count++;
+    }
+    for (size_t j = 0; j < Length; j++) R.repeat.push_back(lround(Sum[j] / Count));
+  }
+  return R;
+}
+
+const char *IRanalyzeResult::encodingName(void) const {
+  switch (encoding) {
+    case IR_ANALYZE_PULSE_DISTANCE: return "pulse distance";
+    case IR_ANALYZE_PULSE_WIDTH: return "pulse width";
+    case IR_ANALYZE_BIPHASE: return "bi-phase";
+    default: return "unknown";
+  }
+}
+
+static void printPayload(FILE *f, const IRpayload &p) {
+  if (!p.length) {fprintf(f, "-"); return;}
+  int Top = (p.length + 7) / 8 - 1;
+  fprintf(f, "%0*X", ((p.length - 1) % 8 + 4) / 4, p.byteAt(Top)); //as many digits as the bits need
+  for (int n = Top - 1; n >= 0; n--) fprintf(f, "%02X", p.byteAt(n));
+}
+
+void IRanalyzeResult::print(FILE *f, bool clusters) const {
+  fprintf(f, "frames:   %u in %u presses, %u repeat frames, %u irregular\n", frames, presses, repeatFrames, irregular);
+  if (clusters) {
+    for (int Space = 0; Space < 2; Space++) {
+      const std::vector<IRanalyzeCluster> &C = Space ? spaces : marks;
+      fprintf(f, "%s", Space ? "spaces:  " : "marks:   ");
+      for (size_t k = 0; k < C.size(); k++)
+        fprintf(f, " %.0f (%u, %u-%u)", C[k].center, C[k].count, C[k].low, C[k].high);
+      fprintf(f, "\n");
+    }
+  }
+  if (encoding == IR_ANALYZE_UNKNOWN) {
+    fprintf(f, "encoding: unknown; %zu mark and %zu space timings fit none of pulse distance, pulse width"
+      " or bi-phase\n", marks.size(), spaces.size());
+    return;
+  }
+  fprintf(f, "encoding: %s, %u bits, most significant first\n", encodingName(), bits);
+  if (headMark) fprintf(f, "header:   mark %u, space %u\n", headMark, headSpace);
+  else fprintf(f, "header:   none\n");
+  if (encoding == IR_ANALYZE_PULSE_DISTANCE)
+    fprintf(f, "data:     mark %u, then space %u for 0 or %u for 1; stop mark %u\n", markZero, spaceZero, spaceOne, markOne);
+  else if (encoding == IR_ANALYZE_PULSE_WIDTH)
+    fprintf(f, "data:     mark %u for 0 or %u for 1, then space %u\n", markZero, markOne, spaceOne);
+  else {
+    fprintf(f, "data:     half bit %u; 1 is %s\n", unit, headMark ? "mark then space" : "space then mark");
+    if (wideBit) fprintf(f, "          bit %u is sent at double width\n", wideBit - 1);
+  }
+  if (!repeat.empty()) {
+    fprintf(f, "repeat:  ");
+    for (size_t i = 0; i < repeat.size(); i++) fprintf(f, " %u", repeat[i]);
+    fprintf(f, "\n");
+  } else fprintf(f, "repeat:   %s\n", repeatsFull ? "the full frame" : "none seen");
+  if (period) fprintf(f, "period:   %u us from the start of one frame to the next\n", period);
+  fprintf(f, "codes:   ");
+  for (size_t k = 0; k < codes.size() && k < 8; k++) {
+    fprintf(f, " ");
+    printPayload(f, codes[k].value);
+    fprintf(f, " x%u", codes[k].count);
+  }
+  fprintf(f, codes.size() > 8 ? " ...\n" : "\n");
+  if (encoding == IR_ANALYZE_BIPHASE) {
+    fprintf(f, "//decode with an IRdecodeRC subclass: getRClevel(&used, %u), as IRdecodeRC5::decode does\n", unit);
+    return;
+  }
+  //the stop mark of a pulse distance frame is mark one to sendGeneric; decodeGeneric wants 0 there
+  bool Distance = encoding == IR_ANALYZE_PULSE_DISTANCE;
+  fprintf(f, "decodeGeneric(%u, %u, %u, %u, %u, %u, %u);\n", rawCount, headMark, headSpace,
+    Distance ? 0 : markOne, markZero, spaceOne, Distance ? spaceZero : 0);
+  fprintf(f, "sendGeneric(data, %u, %u, %u, %u, %u, %u, %u, 38, %s, %u); //38 kHz assumed: traces have no carrier\n",
+    bits, headMark, headSpace, markOne, markZero, spaceOne, spaceZero, stop ? "true" : "false", period);
+}
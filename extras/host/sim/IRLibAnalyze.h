@@ -0,0 +1,76 @@
+/* IRLibAnalyze.h - infers the parameters of an unknown protocol from recorded frames
+ * examples/IRanalyze averages the timings of one key on the Arduino. Turning those averages
+ * into a header, an encoding and a bit count is still left to the user. IRanalyze does all of
+ * it on the host, from a trace or a capture of a few presses of a few keys:
+ *   - marks and spaces are clustered separately: histogram peaks first, then refined by
+ *     1-D k-means, and clusters closer than the MATCH tolerance are merged
+ *   - a first mark whose cluster never appears in the data is a header, and the space after it too
+ *   - one data mark and two data spaces is pulse distance (space coded, with a stop mark), two
+ *     marks and one space is pulse width (mark coded), and durations of one and two units in
+ *     both is bi-phase (Manchester)
+ *   - the bit count is the most common one over the frames, and frames much shorter than the
+ *     longest, or equal to the last longest one without its header (JVC), are repeat frames;
+ *     the repeat shape and period come from frames of one press
+ * The result prints as a descriptor with decodeGeneric and sendGeneric calls that take the
+ * protocol as it is, or with the unit of an IRdecodeRC decoder for bi-phase.
+ */
+#ifndef IRLibAnalyze_h
+#define IRLibAnalyze_h
+#include "IRLibSim.h"
+#include "IRLibCapture.h"
+#include <vector>
+
+#define IR_ANALYZE_GAP LONG_SPACE_US //us; a longer space ends a frame, as in the receivers
+#define IR_ANALYZE_PRESS_GAP 200000  //us; a longer silence between frames starts a new key press
+
+struct IRanalyzeFrame {
+  uint64_t start;                  //us
+  std::vector<uint16_t> durations; //mark, space ... mark, in us
+  uint64_t end(void) const;
+};
+
+//Splits a trace into frames at spaces longer than gap_us
+std::vector<IRanalyzeFrame> IRanalyze_frames(const IRtrace &trace, uint32_t gap_us = IR_ANALYZE_GAP);
+//The frames of a capture, without rawbuf[0]. A capture only has the time a frame was
+//received, so starts are that less the frame's length and periods are approximate.
+std::vector<IRanalyzeFrame> IRanalyze_frames(const IRcaptureFile &file);
+
+struct IRanalyzeCluster {
+  double center;                   //mean, us
+  uint32_t count;
+  uint16_t low, high;              //shortest and longest member
+};
+
+enum IRanalyzeEncoding {IR_ANALYZE_UNKNOWN, IR_ANALYZE_PULSE_DISTANCE, IR_ANALYZE_PULSE_WIDTH, IR_ANALYZE_BIPHASE};
+
+struct IRanalyzeCode {
+  IRpayload value;
+  unsigned count;                  //frames that carried it
+};
+
+struct IRanalyzeResult {
+  IRanalyzeEncoding encoding;
+  std::vector<IRanalyzeCluster> marks, spaces; //of the full frames, shortest first
+  unsigned frames;                 //frames analyzed
+  unsigned repeatFrames;           //of those, frames taken for repeat frames
+  unsigned irregular;              //full frames that do not fit the encoding or have another bit count
+  unsigned presses;
+  //Timings in us, rounded, in the order decodeGeneric and sendGeneric take them. For pulse
+  //distance markOne is given although decodeGeneric wants 0 there. 0 if there is no header.
+  unsigned int headMark, headSpace, markOne, markZero, spaceOne, spaceZero;
+  unsigned int unit;               //bi-phase: half a bit
+  uint8_t wideBit;                 //bi-phase: 1 + the bit sent at double width, as RC6's trailer bit; 0 if none
+  bool stop;                       //a stop mark follows the data
+  uint8_t bits;
+  uint16_t rawCount;               //rawlen of a full frame as the receivers report it; 0 if it varies
+  std::vector<unsigned int> repeat; //durations of the repeat frame; empty if there is none
+  bool repeatsFull;                //a press sends the full frame more than once
+  uint32_t period;                 //us from the start of one frame of a press to the next; 0 if unknown
+  std::vector<IRanalyzeCode> codes; //distinct values, most frequent first
+  const char *encodingName(void) const;
+  void print(FILE *f, bool clusters = false) const;
+};
+
+IRanalyzeResult IRanalyze(const std::vector<IRanalyzeFrame> &frames);
+
+#endif //IRLibAnalyze_h
@@ -0,0 +1,75 @@
+/* IRLibBatch.cpp - decodes a whole capture file on several threads; see IRLibBatch.h */
+#include "IRLibBatch.h"
+#include "IRLibClassify.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <string.h>
+
+/*
+ * Each worker takes the next block of frames from a shared counter until none are left, and
+ * counts into a stats structure of its own. The only shared writes are the counter and, under
+ * the mutex, the merge at the end.
+ */
+template<class D> static IRdecodeResult decodeWith(D &decoder, const uint16_t *raw, uint16_t count);
+template<> IRdecodeResult decodeWith(IRdecodeFrame &decoder, const uint16_t *raw, uint16_t count) {
+  return decoder.decodeFrame(raw, count);
+}
+template<> IRdecodeResult decodeWith(IRsymbolDecoder &decoder, const uint16_t *raw, uint16_t count) {
+  return decoder.decode(raw, count);
+}
+
+template<class D> static void worker(const IRcaptureFile &file, std::atomic<size_t> &next,
+    std::mutex &lock, IRbatchStats &total) {
+  D Decoder;
+  uint16_t Raw[RAWBUF];
+  size_t Decoded[LAST_PROTOCOL + 1] = {0};
+  std::vector<size_t> Differing;
+  size_t Frames = file.size();
+  for (size_t Start; (Start = next.fetch_add(IR_BATCH_BLOCK)) < Frames; ) {
+    size_t End = std::min(Start + IR_BATCH_BLOCK, Frames);
+    for (size_t i = Start; i < End; i++) {
+      IRcaptureFrame F = file.frame(i);
+      IRdecodeResult R = decodeWith(Decoder, Raw, F.durations(Raw, RAWBUF));
+      Decoded[R.decode_type <= LAST_PROTOCOL ? R.decode_type : UNKNOWN]++;
+      if (R.decode_type != F.protocol || (R.decode_type != UNKNOWN && (uint32_t)R.value != F.value))
+        Differing.push_back(i);
+    }
+  }
+  std::lock_guard<std::mutex> Guard(lock);
+  for (int p = 0; p <= LAST_PROTOCOL; p++) total.decoded[p] += Decoded[p];
+  total.differ += Differing.size();
+  total.differing.insert(total.differing.end(), Differing.begin(), Differing.end());
+}
+
+IRbatchStats IRbatchDecode(const IRcaptureFile &file, unsigned threads, size_t maxDiffering, bool symbols) {
+  IRbatchStats S;
+  S.frames = file.size();
+  memset(S.decoded, 0, sizeof(S.decoded));
+  S.differ = 0;
+  if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+  S.threads = threads;
+  std::atomic<size_t> Next(0);
+  std::mutex Lock;
+  auto Start = std::chrono::steady_clock::now();
+  std::vector<std::thread> Pool;
+  void (*Work)(const IRcaptureFile &, std::atomic<size_t> &, std::mutex &, IRbatchStats &) =
+    symbols ? worker<IRsymbolDecoder> : worker<IRdecodeFrame>;
+  for (unsigned t = 1; t < threads; t++)
+    Pool.push_back(std::thread(Work, std::cref(file), std::ref(Next), std::ref(Lock), std::ref(S)));
+  Work(file, Next, Lock, S);
+  for (size_t t = 0; t < Pool.size(); t++) Pool[t].join();
+  S.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+  std::sort(S.differing.begin(), S.differing.end());
+  if (S.differing.size() > maxDiffering) S.differing.resize(maxDiffering);
+  return S;
+}
+
+void IRbatchStats::print(FILE *f) const {
+  fprintf(f, "%zu frames on %u threads in %.3f s, %.0f frames/s\n", frames, threads, seconds, rate());
+  for (int p = 0; p <= LAST_PROTOCOL; p++)
+    if (decoded[p]) fprintf(f, "  %-13s %zu\n", IRsim_protocolName((IR_types_t)p), decoded[p]);
+  fprintf(f, "%zu decoded differently from the capture\n", differ);
+}
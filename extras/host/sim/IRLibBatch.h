@@ -0,0 +1,30 @@
+/* IRLibBatch.h - decodes a whole capture file (IRLibCapture.h) on several threads
+ * The frames are handed out in blocks to a pool of threads, each with its own IRdecodeFrame, or
+ * IRsymbolDecoder (IRLibClassify.h) if asked for the vectorized decoder. Either way
+ * every frame is decoded by the full IRdecode chain and compared with what the capture says it
+ * was decoded as when it was recorded, so a corpus from the field doubles as a regression
+ * check for changes to the decoders. Link against a library built without IRLIB_STATS and
+ * IRLIB_REJECTIONS; with those the decoders share global state.
+ */
+#ifndef IRLibBatch_h
+#define IRLibBatch_h
+#include "IRLibCapture.h"
+
+#define IR_BATCH_BLOCK 4096 //frames a thread takes at a time
+
+struct IRbatchStats {
+  size_t frames;
+  size_t decoded[LAST_PROTOCOL + 1]; //by the protocol found now; [UNKNOWN] for frames nothing took
+  size_t differ;                     //frames decoded differently from the capture
+  std::vector<size_t> differing;     //their indexes, in order; at most maxDiffering of them
+  unsigned threads;
+  double seconds;
+  double rate(void) const {return seconds > 0 ? frames / seconds : 0;}
+  void print(FILE *f) const;
+};
+
+//threads 0 uses one per CPU. symbols true decodes with IRsymbolDecoder instead of IRdecodeFrame.
+IRbatchStats IRbatchDecode(const IRcaptureFile &file, unsigned threads = 0, size_t maxDiffering = 100,
+  bool symbols = false);
+
+#endif //IRLibBatch_h
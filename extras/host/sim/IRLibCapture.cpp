@@ -0,0 +1,188 @@
+/* IRLibCapture.cpp - binary capture files of received frames; see IRLibCapture.h */
+#include "IRLibCapture.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char Magic[4] = {'I', 'R', 'C', 'F'};
+
+static uint64_t le(const uint8_t *p, int bytes) {
+  uint64_t v = 0;
+  for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+static void putLE(std::vector<uint8_t> &out, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++) {out.push_back(v & 0xFF); v >>= 8;}
+}
+
+uint16_t IRcaptureFrame::durations(uint16_t *out, uint16_t max) const {
+  const uint8_t *p = data, *End = data + size;
+  uint16_t n = 0;
+  while (n < count && n < max) {
+    uint32_t Ticks = 0;
+    for (int Shift = 0; ; Shift += 7) {
+      if (p == End || Shift > 28) return n;
+      Ticks |= (uint32_t)(*p & 0x7F) << Shift;
+      if (!(*p++ & 0x80)) break;
+    }
+    Ticks *= tick;
+    out[n++] = Ticks > 0xFFFF ? 0xFFFF : Ticks;
+  }
+  return n;
+}
+
+void IRcaptureFrame::load(IRdecodeBase &decoder) const {
+  uint16_t Raw[RAWBUF];
+  decoder.reset();
+  uint16_t n = durations(Raw, RAWBUF);
+  memcpy((void *)decoder.rawbuf, Raw, n * sizeof(uint16_t));
+  decoder.rawlen = n;
+}
+
+bool IRcaptureFile::open(const char *path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {perror(path); return false;}
+  struct stat St;
+  if (fstat(fd, &St) || St.st_size < IR_CAPTURE_HEADER) {
+    fprintf(stderr, "%s: not an IRLib capture\n", path);
+    ::close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, St.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {perror(path); return false;}
+  Map = (const uint8_t *)p;
+  Length = St.st_size;
+  uint16_t Version = le(Map + 4, 2), HeaderSize = le(Map + 6, 2);
+  if (memcmp(Map, Magic, 4) || HeaderSize < IR_CAPTURE_HEADER || HeaderSize > Length) {
+    fprintf(stderr, "%s: not an IRLib capture\n", path);
+    close();
+    return false;
+  }
+  if (Version != IR_CAPTURE_VERSION) {
+    fprintf(stderr, "%s: capture version %u, this reader knows %u\n", path, Version, IR_CAPTURE_VERSION);
+    close();
+    return false;
+  }
+  Count = le(Map + 8, 8);
+  uint64_t Index = le(Map + 16, 8);
+  if (Index && Index <= Length && Count <= (Length - Index) / 8) {
+    Offsets = Map + Index;
+    return true;
+  }
+  //no index (the writer did not close the file) or a damaged one: walk the frames instead
+  for (uint64_t At = HeaderSize; At + IR_CAPTURE_FRAME_HEADER <= Length && (!Count || Scanned.size() < Count); ) {
+    uint64_t Next = At + IR_CAPTURE_FRAME_HEADER + le(Map + At + 20, 4);
+    if (Next > Length) break;
+    Scanned.push_back(At);
+    At = Next;
+  }
+  fprintf(stderr, "%s: no index, found %u frames\n", path, (unsigned)Scanned.size());
+  return true;
+}
+
+void IRcaptureFile::close(void) {
+  if (Map) munmap((void *)Map, Length);
+  Map = NULL; Length = 0;
+  Offsets = NULL; Count = 0;
+  Scanned.clear();
+}
+
+IRcaptureFrame IRcaptureFile::frame(size_t i) const {
+  IRcaptureFrame F;
+  memset(&F, 0, sizeof(F));
+  uint64_t At = Offsets ? le(Offsets + 8 * i, 8) : Scanned[i];
+  if (At < IR_CAPTURE_HEADER || At > Length || Length - At < IR_CAPTURE_FRAME_HEADER) return F;
+  const uint8_t *p = Map + At;
+  uint32_t Size = le(p + 20, 4);
+  if (Length - At - IR_CAPTURE_FRAME_HEADER < Size) return F;
+  F.t = le(p, 8);
+  F.receiver = p[8];
+  F.protocol = p[9];
+  F.bits = p[10];
+  F.tick = le(p + 12, 2);
+  F.count = le(p + 14, 2);
+  F.value = le(p + 16, 4);
+  F.data = p + IR_CAPTURE_FRAME_HEADER;
+  F.size = Size;
+  return F;
+}
+
+/*
+ * The writer streams frames to the file and keeps only their offsets. close() appends the
+ * index and then goes back to fill in the frame count and index offset in the header.
+ */
+bool IRcaptureWriter::open(const char *path) {
+  close();
+  File = fopen(path, "wb");
+  if (!File) {perror(path); return false;}
+  Path = path;
+  Failed = false;
+  Offsets.clear();
+  Record.clear();
+  for (int i = 0; i < 4; i++) Record.push_back(Magic[i]);
+  putLE(Record, IR_CAPTURE_VERSION, 2);
+  putLE(Record, IR_CAPTURE_HEADER, 2);
+  putLE(Record, 0, 8); //frame count
+  putLE(Record, 0, 8); //index offset
+  putLE(Record, 0, 8);
+  Position = Record.size();
+  Failed = fwrite(Record.data(), 1, Record.size(), File) != Record.size();
+  return !Failed;
+}
+
+bool IRcaptureWriter::add(uint64_t t_us, uint8_t receiver, IR_types_t protocol, uint8_t bits,
+    uint32_t value, const uint16_t *durations, uint16_t count, uint16_t tick) {
+  if (!File) return false;
+  if (!tick) tick = 1;
+  Record.clear();
+  putLE(Record, t_us, 8);
+  Record.push_back(receiver); Record.push_back(protocol); Record.push_back(bits); Record.push_back(0);
+  putLE(Record, tick, 2);
+  putLE(Record, count, 2);
+  putLE(Record, value, 4);
+  putLE(Record, 0, 4); //data size, known below
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t Ticks = (durations[i] + tick / 2) / tick;
+    while (Ticks >= 0x80) {Record.push_back(Ticks | 0x80); Ticks >>= 7;}
+    Record.push_back(Ticks);
+  }
+  uint32_t Size = Record.size() - IR_CAPTURE_FRAME_HEADER;
+  for (int i = 0; i < 4; i++) Record[20 + i] = Size >> (8 * i);
+  if (fwrite(Record.data(), 1, Record.size(), File) != Record.size()) {Failed = true; return false;}
+  Offsets.push_back(Position);
+  Position += Record.size();
+  return true;
+}
+
+bool IRcaptureWriter::add(uint64_t t_us, uint8_t receiver, const IRdecodeBase &decoder) {
+  uint16_t Raw[RAWBUF];
+  uint16_t n = decoder.rawlen < RAWBUF ? decoder.rawlen : RAWBUF;
+  for (uint16_t i = 0; i < n; i++) Raw[i] = decoder.rawbuf[i];
+  return add(t_us, receiver, decoder.decode_type, decoder.bits, decoder.value, Raw, n);
+}
+
+bool IRcaptureWriter::add(const IRdumpRecord &record, uint8_t receiver) {
+  if (record.type != IR_DUMP_FRAME) return true;
+  return add((uint64_t)record.millis * 1000, receiver, record.protocol, record.bits, record.value,
+    record.raw.data(), record.raw.size());
+}
+
+bool IRcaptureWriter::close(void) {
+  if (!File) return false;
+  Record.clear();
+  for (size_t i = 0; i < Offsets.size(); i++) putLE(Record, Offsets[i], 8);
+  bool Ok = !Failed && fwrite(Record.data(), 1, Record.size(), File) == Record.size();
+  Record.clear();
+  putLE(Record, Offsets.size(), 8);
+  putLE(Record, Position, 8);
+  Ok = Ok && !fseek(File, 8, SEEK_SET) && fwrite(Record.data(), 1, 16, File) == 16;
+  Ok = !fclose(File) && Ok;
+  File = NULL;
+  if (!Ok) fprintf(stderr, "%s: could not write the capture\n", Path.c_str());
+  return Ok;
+}
@@ -0,0 +1,86 @@
+/* IRLibCapture.h - binary capture files of received frames for the IRLib host build
+ * A capture holds frames as a receiver returned them: rawbuf plus what the decoder made of it.
+ * Unlike an edge trace (IRLibSim.h) it is compact and is read in place. IRcaptureFile maps the
+ * file into memory and hands out frames that point into the mapping, so a corpus of millions
+ * of frames opens at once and costs no memory until it is read. IRcaptureWriter writes one
+ * from frames received in IRreplay, from an IRdump stream, or from anything else.
+ *
+ * File layout, all numbers little endian:
+ *   header   "IRCF", version 2 bytes, header size 2 bytes, frame count 8 bytes,
+ *            index offset 8 bytes, 8 bytes reserved (0)                       32 bytes
+ *   frames   time in us 8 bytes, receiver id, protocol, bits, flags (0),
+ *            tick 2 bytes, count 2 bytes, value 4 bytes, data size 4 bytes     24 bytes
+ *            then count durations in ticks of tick us each, as unsigned varints:
+ *            7 bits per byte, low bits first, top bit set on every byte but the last
+ *   index    frame count offsets of 8 bytes, from the start of the file
+ * The time is when the frame was received. Durations are rawbuf[0] to rawbuf[count-1].
+ * A file that was not closed has index offset 0; the reader then finds the frames itself.
+ */
+#ifndef IRLibCapture_h
+#define IRLibCapture_h
+#include "IRLibDumpRead.h"
+#include <string>
+
+#define IR_CAPTURE_VERSION 1
+#define IR_CAPTURE_HEADER 32
+#define IR_CAPTURE_FRAME_HEADER 24
+
+//One frame of a mapped capture. data points into the mapping and is valid while the file is open.
+struct IRcaptureFrame {
+  uint64_t t;           //us
+  uint8_t receiver;     //id given by the writer, e.g. IRsimReceiver
+  IR_types_t protocol;
+  uint8_t bits;
+  uint16_t tick;        //us per unit of the durations
+  uint16_t count;       //durations
+  uint32_t value;
+  const uint8_t *data;  //count varints
+  uint32_t size;        //bytes of data
+  //Writes up to max durations in us to out and returns how many. False data gives fewer than count.
+  uint16_t durations(uint16_t *out, uint16_t max) const;
+  //Resets the decoder and puts the frame in its rawbuf as getResults would, at most RAWBUF entries
+  void load(IRdecodeBase &decoder) const;
+};
+
+class IRcaptureFile {
+public:
+  IRcaptureFile(void): Map(NULL), Length(0), Offsets(NULL), Count(0) {}
+  ~IRcaptureFile(void) {close();}
+  bool open(const char *path);  //false with a message on stderr if it is not a capture
+  void close(void);
+  size_t size(void) const {return Offsets ? Count : Scanned.size();}
+  IRcaptureFrame frame(size_t i) const;  //i < size(); a frame that runs off the file has count 0
+private:
+  const uint8_t *Map;
+  size_t Length;
+  const uint8_t *Offsets;  //the index in the mapping, or NULL if the file has none
+  size_t Count;
+  std::vector<uint64_t> Scanned;  //offsets found by open when there is no index
+  IRcaptureFile(const IRcaptureFile &);
+  void operator=(const IRcaptureFile &);
+};
+
+class IRcaptureWriter {
+public:
+  IRcaptureWriter(void): File(NULL) {}
+  ~IRcaptureWriter(void) {close();}
+  bool open(const char *path);
+  //durations are in us; they are stored in units of tick us, rounded
+  bool add(uint64_t t_us, uint8_t receiver, IR_types_t protocol, uint8_t bits, uint32_t value,
+    const uint16_t *durations, uint16_t count, uint16_t tick = 1);
+  bool add(uint64_t t_us, uint8_t receiver, const IRdecodeBase &decoder);
+  bool add(const IRdumpRecord &record, uint8_t receiver = 0); //frame records only; others are skipped
+  bool close(void);  //writes the index; false if anything could not be written
+  uint64_t frames(void) const {return Offsets.size();}
+private:
+  FILE *File;
+  std::string Path;
+  uint64_t Position;
+  bool Failed;
+  std::vector<uint64_t> Offsets;
+  std::vector<uint8_t> Record;
+  IRcaptureWriter(const IRcaptureWriter &);
+  void operator=(const IRcaptureWriter &);
+};
+
+#endif //IRLibCapture_h
@@ -0,0 +1,302 @@
+/* IRLibClassify.cpp - vectorized timing classification; see IRLibClassify.h */
+#include "IRLibClassify.h"
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+IRclassWindow IRclass_window(unsigned int e) {
+  //the bounds MATCH compares with, as unsigned int like it does
+#ifdef IRLIB_USE_PERCENT
+  unsigned int Low = PERCENT_LOW(e), High = PERCENT_HIGH(e);
+#else
+  unsigned int Low = e - DEFAULT_ABS_TOLERANCE, High = e + DEFAULT_ABS_TOLERANCE;
+#endif
+  IRclassWindow W;
+  W.empty = Low > 0xFFFF || Low > High;
+  W.low = W.empty ? 0 : Low;
+  W.high = High > 0xFFFF ? 0xFFFF : High;
+  return W;
+}
+
+static IRclassSet classifyScalar(const uint16_t *d, uint16_t n, const IRclassWindow &w) {
+  IRclassSet s = 0;
+  for (uint16_t i = 0; i < n; i++)
+    if (d[i] >= w.low && d[i] <= w.high) s |= (IRclassSet)1 << i;
+  return s;
+}
+
+#ifdef HAVE_X86
+/*
+ * v is in [low, high] exactly when (v - low) mod 2^16 <= high - low, and for unsigned 16 bit
+ * lanes a <= b is saturating a - b == 0: three instructions for a vector of durations. Packing
+ * the 16 bit results to bytes lets movemask take one bit per entry.
+ */
+__attribute__((target("sse2")))
+static IRclassSet classifySSE2(const uint16_t *d, uint16_t n, const IRclassWindow &w) {
+  const __m128i Low = _mm_set1_epi16((short)w.low), Range = _mm_set1_epi16((short)(w.high - w.low));
+  const __m128i Zero = _mm_setzero_si128();
+  IRclassSet s = 0;
+  uint16_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(d + i));
+    __m128i In = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(v, Low), Range), Zero);
+    s |= (IRclassSet)(_mm_movemask_epi8(_mm_packs_epi16(In, Zero)) & 0xFF) << i;
+  }
+  return s | classifyScalar(d + i, n - i, w) << i;
+}
+
+//As SSE2, sixteen at a time. The pack works within each 128 bit half, so each half's byte mask is taken separately.
+__attribute__((target("avx2")))
+static IRclassSet classifyAVX2(const uint16_t *d, uint16_t n, const IRclassWindow &w) {
+  const __m256i Low = _mm256_set1_epi16((short)w.low), Range = _mm256_set1_epi16((short)(w.high - w.low));
+  const __m256i Zero = _mm256_setzero_si256();
+  IRclassSet s = 0;
+  uint16_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));
+    __m256i In = _mm256_cmpeq_epi16(_mm256_subs_epu16(_mm256_sub_epi16(v, Low), Range), Zero);
+    uint32_t m = _mm256_movemask_epi8(_mm256_packs_epi16(In, In));
+    s |= (IRclassSet)((m & 0xFF) | ((m >> 8) & 0xFF00)) << i;
+  }
+  return s | classifySSE2(d + i, n - i, w) << i;
+}
+#endif
+
+typedef IRclassSet (*Classifier)(const uint16_t *, uint16_t, const IRclassWindow &);
+static Classifier Impl;
+static const char *Impl_Name;
+
+bool IRclassify_force(const char *name) {
+  if (!strcmp(name, "scalar")) {Impl = classifyScalar; Impl_Name = "scalar"; return true;}
+#ifdef HAVE_X86
+  __builtin_cpu_init();
+  if (!strcmp(name, "sse2") && __builtin_cpu_supports("sse2")) {Impl = classifySSE2; Impl_Name = "sse2"; return true;}
+  if (!strcmp(name, "avx2") && __builtin_cpu_supports("avx2")) {Impl = classifyAVX2; Impl_Name = "avx2"; return true;}
+#endif
+  return false;
+}
+
+//the best one the CPU has, picked before main
+static bool Picked = IRclassify_force("avx2") || IRclassify_force("sse2") || IRclassify_force("scalar");
+
+const char *IRclassify_implementation(void) {return Impl_Name;}
+
+IRclassSet IRclassify(const uint16_t *durations, uint16_t count, const IRclassWindow &window) {
+  if (window.empty) return 0;
+  if (count > IR_CLASS_ENTRIES) count = IR_CLASS_ENTRIES;
+  return Impl(durations, count, window);
+}
+
+//n entries first, first+2, first+4 ...
+static IRclassSet every(uint16_t first, uint16_t n) {
+  if (!n) return 0;
+  IRclassSet Alternate = ~(IRclassSet)0 / 3; //...0101
+  uint16_t End = first + 2 * n - 1;          //one past the last entry
+  IRclassSet Upto = End >= IR_CLASS_ENTRIES ? ~(IRclassSet)0 : (((IRclassSet)1 << End) - 1);
+  return (Alternate << (first & 1)) & Upto & ~(((IRclassSet)1 << first) - 1);
+}
+
+//bits 0, 2, 4 ... of x packed into the low half
+static uint64_t evenBits(uint64_t x) {
+  x &= 0x5555555555555555ULL;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x >> 4) & 0x00FF00FF00FF00FFULL;
+  x = (x | x >> 8) & 0x0000FFFF0000FFFFULL;
+  return (x | x >> 16) & 0x00000000FFFFFFFFULL;
+}
+
+static uint64_t reverse(uint64_t x) {
+  x = __builtin_bswap64(x);
+  x = (x >> 4 & 0x0F0F0F0F0F0F0F0FULL) | (x & 0x0F0F0F0F0F0F0F0FULL) << 4;
+  x = (x >> 2 & 0x3333333333333333ULL) | (x & 0x3333333333333333ULL) << 2;
+  return (x >> 1 & 0x5555555555555555ULL) | (x & 0x5555555555555555ULL) << 1;
+}
+
+//The bits of s at entries first, first+2 ... as a number of n bits, the first one most
+//significant: what n calls of IRpayload::shiftIn would build.
+static uint64_t bitsAt(IRclassSet s, uint16_t first, uint8_t n) {
+  if (!n) return 0;
+  s >>= first;
+  uint64_t Even = evenBits((uint64_t)s) | evenBits((uint64_t)(s >> 64)) << 32;
+  return reverse(Even) >> (64 - n);
+}
+
+/*
+ * The symbol decoder. Each method below is the library decoder of the same protocol in
+ * IRLib.cpp, with MATCH(rawbuf[i],t) replaced by entry i being in the window of timing t.
+ * Data bits are checked all at once: every data mark must be in one set and every data space
+ * in the union of two. They have to be kept in step with IRLib.cpp; tests/classify.cpp
+ * compares the two on received, jittered, damaged and random frames.
+ */
+IRsymbolDecoder::IRsymbolDecoder(void) {
+  (void)Picked;
+  const unsigned int Expected[TIMINGS] = {
+    563*16, 563*8, 563, 563*3, 2250,
+    600*4, 600, 600*2,
+    889, 889*2, 889*3, 444, 444*2, 444*3, 2666,
+    833*4, 833, 833*3,
+    525*16, 525*8, 525, 525*3,
+    3456, 1728, 432, 1296,
+    560*16, 560*8, 560, 560*3};
+  for (int t = 0; t < TIMINGS; t++) {
+    Windows[t] = IRclass_window(Expected[t]);
+    Low[t] = Windows[t].low;
+    Range[t] = Windows[t].high - Windows[t].low;
+  }
+}
+
+const IRclassSet &IRsymbolDecoder::set(Timing t) {
+  static const IRclassSet Nothing = 0;
+  if (t == NONE) return Nothing;
+  if (!(Have & (1UL << t))) {
+    Sets[t] = IRclassify(Raw, Rawlen, Windows[t]);
+    Have |= 1UL << t;
+  }
+  return Sets[t];
+}
+
+//IRdecodeBase::decodeGeneric; NONE is a timing of 0 there
+bool IRsymbolDecoder::generic(uint16_t rawCount, Timing headMark, Timing headSpace, Timing markOne,
+    Timing markZero, Timing spaceOne, Timing spaceZero) {
+  Payload.clear();
+  if (rawCount && Rawlen != rawCount) return false;
+  if (headMark != NONE && !is(1, headMark)) return false;
+  if (headSpace != NONE && !is(2, headSpace)) return false;
+  uint16_t n;
+  uint64_t Data;
+  if (markOne != NONE) { //spaces at 2, 4 ... and the mark after each gives the bit
+    n = Rawlen > 2 ? (Rawlen - 1) / 2 : 0;
+    IRclassSet Spaces = every(2, n), Marks = Spaces << 1;
+    if ((set(spaceOne) & Spaces) != Spaces) return false;
+    if (((set(markOne) | set(markZero)) & Marks) != Marks) return false;
+    Data = bitsAt(set(markOne), 3, n);
+  } else {               //marks at 3, 5 ... and the space after each gives the bit; the last mark is a stop bit
+    n = Rawlen > 3 ? (Rawlen - 3) / 2 : 0;
+    IRclassSet Marks = every(3, n), Spaces = Marks << 1;
+    if ((set(markZero) & Marks) != Marks) return false;
+    if (((set(spaceOne) | set(spaceZero)) & Spaces) != Spaces) return false;
+    Data = bitsAt(set(spaceOne), 4, n);
+  }
+  Bits = n;
+  Payload.set(Data, n);
+  Value = (uint32_t)Payload.low;
+  return true;
+}
+
+bool IRsymbolDecoder::nec(void) {
+  if (Rawlen == 4 && is(2, NEC_REPEAT) && is(3, NEC_BIT)) {Bits = 0; Value = REPEAT; return true;}
+  return generic(68, NEC_HEAD, NEC_HEAD_SPACE, NONE, NEC_BIT, NEC_ONE, NEC_BIT);
+}
+
+bool IRsymbolDecoder::sony(void) {
+  if (Rawlen != 2*8+2 && Rawlen != 2*12+2 && Rawlen != 2*15+2 && Rawlen != 2*20+2) return false;
+  return generic(0, SONY_HEAD, SONY_BIT, SONY_ONE, SONY_BIT, SONY_BIT, NONE);
+}
+
+//IRdecodeRC::getRClevel with ignoreHeader false; t1, t1+1 and t1+2 are the timings t1, 2*t1 and 3*t1
+IRdecodeRC::RCLevel IRsymbolDecoder::level(Timing t1) {
+  if (Offset >= Rawlen) return IRdecodeRC::SPACE;
+  IRdecodeRC::RCLevel Val = (Offset % 2) ? IRdecodeRC::MARK : IRdecodeRC::SPACE;
+  uint8_t Avail;
+  if (is(Offset, t1)) Avail = 1;
+  else if (is(Offset, (Timing)(t1 + 1))) Avail = 2;
+  else if (is(Offset, (Timing)(t1 + 2))) Avail = 3;
+  else return IRdecodeRC::ERROR;
+  Used++;
+  if (Used >= Avail) {Used = 0; Offset++;}
+  return Val;
+}
+
+bool IRsymbolDecoder::rc5(void) {
+  if (Rawlen < 11 + 2) return false;
+  long Data = 0;
+  Offset = 1; Used = 0;
+  if (level(RC5_T1) != IRdecodeRC::MARK) return false;
+  while (Offset < Rawlen) {
+    IRdecodeRC::RCLevel A = level(RC5_T1), B = level(RC5_T1);
+    if (A == IRdecodeRC::SPACE && B == IRdecodeRC::MARK) Data = (Data << 1) | 1;
+    else if (A == IRdecodeRC::MARK && B == IRdecodeRC::SPACE) Data <<= 1;
+    else return false;
+  }
+  Bits = 13;
+  Value = Data;
+  Payload.set(Value, Bits);
+  return true;
+}
+
+bool IRsymbolDecoder::rc6(void) {
+  if (Rawlen < 1) return false;
+  if (!is(1, RC6_HEAD) || !is(2, RC5_T1)) return false; //the header space is 889, RC5's t1
+  long Data = 0;
+  uint8_t n;
+  Offset = 3; Used = 0;
+  if (level(RC6_T1) != IRdecodeRC::MARK) return false;
+  if (level(RC6_T1) != IRdecodeRC::SPACE) return false;
+  for (n = 0; Offset < Rawlen; n++) {
+    IRdecodeRC::RCLevel A = level(RC6_T1);
+    if (n == 3 && A != level(RC6_T1)) return false;
+    IRdecodeRC::RCLevel B = level(RC6_T1);
+    if (n == 3 && B != level(RC6_T1)) return false;
+    if (A == IRdecodeRC::MARK && B == IRdecodeRC::SPACE) Data = (Data << 1) | 1;
+    else if (A == IRdecodeRC::SPACE && B == IRdecodeRC::MARK) Data <<= 1;
+    else return false;
+  }
+  Bits = n;
+  Value = Data;
+  Payload.set(Value, Bits);
+  return true;
+}
+
+bool IRsymbolDecoder::jvc(void) {
+  if (generic(36, JVC_HEAD, JVC_HEAD_SPACE, NONE, JVC_BIT, JVC_ONE, JVC_BIT)) return true;
+  if (Rawlen != 34) return false;
+  if (!generic(0, JVC_BIT, NONE, NONE, JVC_BIT, JVC_ONE, JVC_BIT)) return false;
+  if (is(4, JVC_ONE)) Value |= 0x8000;
+  else if (!is(4, JVC_BIT)) return false;
+  Bits++;
+  Payload.set(Value, Bits);
+  return true;
+}
+
+//40 bits after the header: 0x4004, then the 24 that are the value
+bool IRsymbolDecoder::panasonic(void) {
+  if (Rawlen != 100) return false;
+  if (!is(1, PAN_HEAD) || !is(2, PAN_HEAD_SPACE)) return false;
+  IRclassSet Marks = every(3, 40), Spaces = Marks << 1;
+  if ((set(PAN_BIT) & Marks) != Marks) return false;
+  if (((set(PAN_ONE) | set(PAN_BIT)) & Spaces) != Spaces) return false;
+  uint64_t Data = bitsAt(set(PAN_ONE), 4, 40);
+  if ((Data >> 24) != 0x4004) return false;
+  Value = Data & 0xFFFFFF;
+  Bits = 24;
+  Payload.set(Value, Bits);
+  return true;
+}
+
+IRdecodeResult IRsymbolDecoder::decode(const uint16_t *durations, uint16_t count) {
+  IRdecodeResult R;
+  Raw = durations;
+  Rawlen = count > RAWBUF ? RAWBUF : count;
+  Have = 0;
+  Value = 0; Bits = 0;
+  IR_types_t Type = UNKNOWN;
+  if (nec()) Type = NEC;
+  else if (sony()) Type = SONY;
+  else if (rc5()) Type = RC5;
+  else if (rc6()) Type = RC6;
+  else if (generic(48, PANOLD_HEAD, PANOLD_HEAD, NONE, PANOLD_BIT, PANOLD_ONE, PANOLD_BIT)) Type = PANASONIC_OLD;
+  else if (generic(68, NEC_HEAD_SPACE, NEC_HEAD_SPACE, NONE, NEC_BIT, NEC_ONE, NEC_BIT)) Type = NECX;
+  else if (jvc()) Type = JVC;
+  else if (panasonic()) Type = PANASONIC_NEW;
+  else if (generic(68, SAM_HEAD, SAM_HEAD_SPACE, NONE, SAM_BIT, SAM_ONE, SAM_BIT)) Type = SAMSUNG32;
+  R.decode_type = Type;
+  R.value = Type == UNKNOWN ? 0 : Value;
+  R.bits = Type == UNKNOWN ? 0 : Bits;
+  if (Type == UNKNOWN || (Type == NEC && Value == REPEAT && !Bits)) R.payload.clear(); else R.payload = Payload;
+  IRsplitFields(Type, R.value, R.bits, &R.fields); //all zero for UNKNOWN
+  if (Type == JVC) R.fields.repeat = Rawlen == 34;  //as IRdecodeJVC: the frame without a header
+  return R;
+}
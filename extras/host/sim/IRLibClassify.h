@@ -0,0 +1,81 @@
+/* IRLibClassify.h - vectorized timing classification and a decoder that works from it
+ * The library's decoders compare durations with the timings they expect one MATCH at a time,
+ * one bit after the other. IRclassify compares a whole frame with one timing in a single pass,
+ * eight (SSE2) or sixteen (AVX2) durations at a time, and returns the set of entries that match
+ * as a bitset. The windows are exactly those of MATCH in IRLibMatch.h.
+ * IRsymbolDecoder runs the IRdecode chain on those bitsets. A pulse distance or pulse width
+ * protocol checks every data mark and space with two masks, and its bits are pulled out of a
+ * bitset in a few operations. Bitsets are only made for the timings a frame gets as far as
+ * (a frame that fails a header check needs none). It gives the same result as IRdecodeFrame
+ * for every frame (tests/classify.cpp checks that), assumes ignoreHeader is false and no
+ * integrity checks (IR_CHECK_), and is host only: it needs unsigned __int128.
+ * It is only faster than the library's early-exit chain on RC5 and RC6; on the pulse distance
+ * and pulse width protocols building the bitsets costs more than it saves (see decode_bench).
+ */
+#ifndef IRLibClassify_h
+#define IRLibClassify_h
+#include <IRLib.h>
+#include <IRLibMatch.h>
+
+typedef unsigned __int128 IRclassSet; //bit i for entry i of a frame
+#define IR_CLASS_ENTRIES 128
+#if RAWBUF > IR_CLASS_ENTRIES
+#error "IRclassSet has fewer bits than RAWBUF"
+#endif
+
+//The durations MATCH(v,expected) accepts: low to high, or none if empty
+struct IRclassWindow {
+  uint16_t low, high;
+  bool empty;
+};
+IRclassWindow IRclass_window(unsigned int expected);
+
+//Bit i of the result is set if durations[i] is in the window, for i < count (at most IR_CLASS_ENTRIES)
+IRclassSet IRclassify(const uint16_t *durations, uint16_t count, const IRclassWindow &window);
+//The implementation IRclassify uses: "avx2", "sse2" or "scalar"; the best the CPU has unless forced.
+const char *IRclassify_implementation(void);
+//Picks an implementation, for tests and benchmarks; false if the CPU does not have it. Not thread safe.
+bool IRclassify_force(const char *name);
+
+class IRsymbolDecoder {
+public:
+  IRsymbolDecoder(void);
+  //Same as IRdecodeFrame::decodeFrame, without copying the durations
+  IRdecodeResult decode(const uint16_t *durations, uint16_t count);
+private:
+  enum Timing {
+    NEC_HEAD, NEC_HEAD_SPACE, NEC_BIT, NEC_ONE, NEC_REPEAT,
+    SONY_HEAD, SONY_BIT, SONY_ONE,
+    RC5_T1, RC5_T2, RC5_T3, RC6_T1, RC6_T2, RC6_T3, RC6_HEAD,
+    PANOLD_HEAD, PANOLD_BIT, PANOLD_ONE,
+    JVC_HEAD, JVC_HEAD_SPACE, JVC_BIT, JVC_ONE,
+    PAN_HEAD, PAN_HEAD_SPACE, PAN_BIT, PAN_ONE,
+    SAM_HEAD, SAM_HEAD_SPACE, SAM_BIT, SAM_ONE,
+    TIMINGS, NONE = TIMINGS
+  };
+  IRclassWindow Windows[TIMINGS];
+  IRclassSet Sets[TIMINGS];
+  uint32_t Have;           //bit t set once Sets[t] is made for this frame
+  const uint16_t *Raw;
+  uint16_t Rawlen;
+  uint16_t Offset, Used;   //IRdecodeRC state
+  unsigned long Value;
+  unsigned char Bits;
+  IRpayload Payload;
+  const IRclassSet &set(Timing t);
+  uint16_t Low[TIMINGS], Range[TIMINGS]; //Windows as low and high - low; none of them is empty
+  bool is(uint16_t i, Timing t) const {   //t is not NONE
+    return i < Rawlen && (uint16_t)(Raw[i] - Low[t]) <= Range[t];
+  }
+  bool generic(uint16_t rawCount, Timing headMark, Timing headSpace, Timing markOne,
+    Timing markZero, Timing spaceOne, Timing spaceZero);
+  IRdecodeRC::RCLevel level(Timing t1);
+  bool nec(void);
+  bool sony(void);
+  bool rc5(void);
+  bool rc6(void);
+  bool jvc(void);
+  bool panasonic(void);
+};
+
+#endif //IRLibClassify_h
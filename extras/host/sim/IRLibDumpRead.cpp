@@ -0,0 +1,102 @@
+/* IRLibDumpRead.cpp - reads the binary stream written by IRdump; see IRLibDumpRead.h */
+#include "IRLibDumpRead.h"
+
+#define MAX_BODY 2048 //longer than any record IRdump can build; anything more is noise
+#define MIN_GAP_US 20000 //between frames put into a trace
+
+static uint16_t crc16(const uint8_t *data, size_t len) {
+  uint16_t Crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    Crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) Crc = (Crc & 0x8000) ? (Crc << 1) ^ 0x1021 : Crc << 1;
+  }
+  return Crc;
+}
+
+static uint32_t le(const uint8_t *p, int bytes) {
+  uint32_t v = 0;
+  for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+void IRdumpReader::feed(const uint8_t *data, size_t len) {
+  if (Pos > 4096) {Buffer.erase(Buffer.begin(), Buffer.begin() + Pos); Pos = 0;}
+  Buffer.insert(Buffer.end(), data, data + len);
+}
+
+bool IRdumpReader::parse(const uint8_t *b, uint16_t len, IRdumpRecord &r) {
+  const uint8_t *End = b + len;
+  if (len < 4) return false;
+  r.millis = le(b, 4); b += 4;
+  r.raw.clear();
+  r.protocol = UNKNOWN; r.bits = 0; r.value = 0; r.khz = 0; r.samples = 0;
+  if (r.type == IR_DUMP_FREQ) {
+    if (End - b != 3) return false;
+    r.khz = le(b, 2) / 100.0;
+    r.samples = b[2];
+    return true;
+  }
+  if (r.type != IR_DUMP_FRAME || End - b < 8) return false;
+  r.protocol = b[0]; r.bits = b[1]; r.value = le(b + 2, 4);
+  uint16_t Rawlen = le(b + 6, 2);
+  b += 8;
+  for (uint16_t i = 0; i < Rawlen; i++) {
+    uint32_t Zigzag = 0;
+    for (int Shift = 0; ; Shift += 7) {
+      if (b == End || Shift > 28) return false;
+      Zigzag |= (uint32_t)(*b & 0x7F) << Shift;
+      if (!(*b++ & 0x80)) break;
+    }
+    int32_t v = (int32_t)(Zigzag >> 1) ^ -(int32_t)(Zigzag & 1);
+    r.raw.push_back((uint16_t)(i < 3 ? v : r.raw[i-2] + v));
+  }
+  return b == End;
+}
+
+bool IRdumpReader::next(IRdumpRecord &r) {
+  while (true) {
+    while (Pos + 1 < Buffer.size() && !(Buffer[Pos] == IR_DUMP_SYNC1 && Buffer[Pos+1] == IR_DUMP_SYNC2)) Pos++;
+    if (Pos + 6 > Buffer.size()) return false;
+    const uint8_t *b = &Buffer[Pos];
+    uint16_t Len = le(b + 4, 2);
+    if (Len > MAX_BODY) {crcErrors++; Pos++; continue;}
+    if (Pos + 8 + Len > Buffer.size()) return false;
+    if (crc16(b + 2, 4 + Len) != le(b + 6 + Len, 2)) {crcErrors++; Pos++; continue;}
+    r.type = b[2]; r.seq = b[3];
+    bool Ok = parse(b + 6, Len, r);
+    Pos += 8 + Len;
+    if (!Ok) {crcErrors++; continue;}
+    if (HaveSeq) lost += (uint8_t)(r.seq - LastSeq - 1);
+    HaveSeq = true; LastSeq = r.seq;
+    return true;
+  }
+}
+
+void IRdump_toTrace(const std::vector<IRdumpRecord> &records, IRtrace &trace, int16_t markExcess) {
+  for (size_t i = 0; i < records.size(); i++) {
+    const IRdumpRecord &r = records[i];
+    if (r.type != IR_DUMP_FRAME || r.raw.size() < 2) continue;
+    std::vector<uint32_t> Pin(r.raw.size());
+    uint64_t Duration = 0;
+    for (size_t j = 1; j < r.raw.size(); j++) {
+      int32_t v = r.raw[j] + (j % 2 ? markExcess : -markExcess);
+      Pin[j] = v > 0 ? v : 1;
+      Duration += Pin[j];
+    }
+    uint64_t Earliest = trace.end() + MIN_GAP_US;
+    uint64_t t = (uint64_t)r.millis * 1000 > Earliest + Duration ? (uint64_t)r.millis * 1000 - Duration : Earliest;
+    for (size_t j = 1; j < r.raw.size(); j++) {
+      IRtraceEdge Edge = {t, (uint8_t)(j % 2 ? 0 : 1)};
+      trace.edges.push_back(Edge);
+      t += Pin[j];
+    }
+    if (r.raw.size() % 2 == 0) { //ended on a mark
+      IRtraceEdge Edge = {t, 1};
+      trace.edges.push_back(Edge);
+    }
+    if (r.protocol != UNKNOWN) {
+      IRtraceFrame Frame = {trace.end(), r.protocol, r.value, r.bits};
+      trace.frames.push_back(Frame);
+    }
+  }
+}
@@ -0,0 +1,47 @@
+/* IRLibDumpRead.h - reads the binary stream written by IRdump (IRLibDump.h) on the host
+ * Feed it bytes as they come, from a file or a serial port, and take the records out. Noise
+ * between records and records with a bad CRC are skipped; the reader finds the next sync.
+ */
+#ifndef IRLibDumpRead_h
+#define IRLibDumpRead_h
+#include <IRLibDump.h>
+#include "IRLibSim.h"
+#include <vector>
+
+struct IRdumpRecord {
+  uint8_t type;          //IR_DUMP_FRAME or IR_DUMP_FREQ
+  uint8_t seq;
+  uint32_t millis;
+  //IR_DUMP_FRAME
+  IR_types_t protocol;
+  uint8_t bits;
+  uint32_t value;
+  std::vector<uint16_t> raw; //rawbuf in us, as the decoder had it
+  //IR_DUMP_FREQ
+  double khz;
+  uint8_t samples;
+};
+
+class IRdumpReader {
+public:
+  IRdumpReader(void): crcErrors(0), lost(0), Pos(0), HaveSeq(false) {}
+  void feed(const uint8_t *data, size_t len);
+  bool next(IRdumpRecord &record);  //false when no complete record is waiting
+  unsigned crcErrors;    //records skipped because of a bad CRC or body
+  unsigned lost;         //records missing from the sequence numbers (dropped by IRdump, or corrupted)
+private:
+  std::vector<uint8_t> Buffer;
+  size_t Pos;           //first byte not looked at yet
+  bool HaveSeq;
+  uint8_t LastSeq;
+  bool parse(const uint8_t *body, uint16_t len, IRdumpRecord &r);
+};
+
+//Adds the frames of a dump to a trace. Each frame ends at its millis() time stamp, or 20ms after
+//the previous frame if that is later. Decoded frames are added as frames of the trace. The dump
+//holds rawbuf after getResults took Mark_Excess off the marks; it is put back so the trace shows
+//what the receiver pin did.
+void IRdump_toTrace(const std::vector<IRdumpRecord> &records, IRtrace &trace,
+  int16_t markExcess = MARK_EXCESS_DEFAULT);
+
+#endif //IRLibDumpRead_h
@@ -0,0 +1,222 @@
+/* IRLibSim.cpp - edge traces and the capture-replay simulator; see IRLibSim.h */
+#include "IRLibSim.h"
+#include "IRLibCapture.h"
+#include <IRLibMatch.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define NEVER UINT64_MAX
+#define REPLAY_TAIL_US 200000 //keep the clock running this long after the last edge so the last frame can end
+
+/*
+ * Recording. The carrier hook of the host HAL reports every on/off transition of the IR
+ * output. The first one after recordStart is placed gap_us after the end of the trace and
+ * everything after it keeps its distance.
+ */
+static IRtrace *Recording;
+static bool Recording_First;
+static int64_t Recording_Offset; //trace time minus virtual time
+static uint32_t Recording_Gap;
+
+static void recordEdge(uint64_t t_us, bool on) {
+  if (!Recording) return;
+  if (Recording_First) {
+    Recording_Offset = (int64_t)(Recording->end() + Recording_Gap) - (int64_t)t_us;
+    Recording_First = false;
+  }
+  IRtraceEdge Edge = {(uint64_t)(t_us + Recording_Offset), (uint8_t)(on ? 0 : 1)};
+  Recording->edges.push_back(Edge);
+}
+
+void IRtrace::recordStart(uint32_t gap_us) {
+  Recording = this; Recording_First = true; Recording_Gap = gap_us;
+  IRhost_onCarrierEdge(recordEdge);
+}
+
+void IRtrace::recordEnd(IR_types_t type, uint32_t value, uint8_t bits) {
+  IRhost_onCarrierEdge(NULL);
+  Recording = NULL;
+  if (Recording_First) return; //nothing was sent
+  IRtraceFrame Frame = {end(), type, value, bits};
+  frames.push_back(Frame);
+}
+
+void IRtrace::send(IR_types_t type, uint32_t value, unsigned int data2, uint32_t gap_us) {
+  IRsend Sender;
+  uint8_t Bits;
+  switch (type) {
+    case SONY: case RC6: Bits = data2; break;
+    case RC5:            Bits = 13; break;
+    case PANASONIC_OLD:  Bits = 22; break;
+    case JVC:            Bits = 16; break;
+    case PANASONIC_NEW:  Bits = 24; break;
+    default:             Bits = 32; break;
+  }
+  recordStart(gap_us);
+  Sender.send(type, value, data2, false);
+  recordEnd(type, value, Bits);
+}
+
+const char *IRsim_protocolName(IR_types_t type) {
+  static char Name[32];
+  const char *p = (const char *)Pnames(type);
+  char *q = Name;
+  for (; *p && q < Name + sizeof(Name) - 1; p++) if (*p != ' ') *q++ = *p;
+  *q = 0;
+  return Name;
+}
+
+IR_types_t IRsim_protocol(const char *name) {
+  if (isdigit((unsigned char)name[0])) {
+    int Type = atoi(name);
+    return (Type > 0 && Type <= LAST_PROTOCOL) ? (IR_types_t)Type : UNKNOWN;
+  }
+  for (int i = 1; i <= LAST_PROTOCOL; i++)
+    if (!strcasecmp(name, IRsim_protocolName((IR_types_t)i))) return (IR_types_t)i;
+  return UNKNOWN;
+}
+
+bool IRtrace::load(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {perror(path); return false;}
+  char Line[256];
+  unsigned LineNo = 0;
+  clear();
+  while (fgets(Line, sizeof(Line), f)) {
+    LineNo++;
+    char *p = Line;
+    while (isspace((unsigned char)*p)) p++;
+    if (!*p || *p == '#') continue;
+    unsigned long long T; unsigned Level; char Proto[32]; unsigned long Value; unsigned Bits;
+    if (*p == 'F') {
+      if (sscanf(p + 1, "%llu %31s %lx %u", &T, Proto, &Value, &Bits) != 4 || !IRsim_protocol(Proto)) {
+        fprintf(stderr, "%s:%u: bad frame line\n", path, LineNo); fclose(f); return false;
+      }
+      IRtraceFrame Frame = {T, IRsim_protocol(Proto), (uint32_t)Value, (uint8_t)Bits};
+      frames.push_back(Frame);
+    } else {
+      if (sscanf(p, "%llu %u", &T, &Level) != 2 || Level > 1 || (!edges.empty() && T < edges.back().t)) {
+        fprintf(stderr, "%s:%u: bad edge line\n", path, LineNo); fclose(f); return false;
+      }
+      IRtraceEdge Edge = {T, (uint8_t)Level};
+      edges.push_back(Edge);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+bool IRtrace::save(const char *path) const {
+  FILE *f = fopen(path, "w");
+  if (!f) {perror(path); return false;}
+  fprintf(f, "# IRLib edge trace: <t_us> <level 0=mark 1=space>, F <t_us> <protocol> <hex> <bits>\n");
+  size_t j = 0;
+  for (size_t i = 0; i < edges.size(); i++) {
+    fprintf(f, "%llu %u\n", (unsigned long long)edges[i].t, edges[i].level);
+    for (; j < frames.size() && frames[j].end <= edges[i].t; j++)
+      fprintf(f, "F %llu %s %lX %u\n", (unsigned long long)frames[j].end,
+        IRsim_protocolName(frames[j].type), (unsigned long)frames[j].value, frames[j].bits);
+  }
+  bool Ok = !ferror(f);
+  fclose(f);
+  return Ok;
+}
+
+void IRreplayStats::print(FILE *f) const {
+  fprintf(f, "sent %u  received %u  matched %u  lost %u  wrong %u  overflows %u  polls %u\n",
+    sent, received, matched, lost, wrong, overflows, polls);
+  if (matched)
+    fprintf(f, "latency us  min %llu  avg %.0f  max %llu\n", (unsigned long long)latencyMin,
+      latencyAvg(), (unsigned long long)latencyMax);
+}
+
+/*
+ * The replay loop. Three kinds of event happen on the virtual clock: the next edge of the
+ * trace, the next main-loop poll and, after a frame was handed over, the resume() that ends
+ * the main loop's busy time. The earliest one runs next. Moving the clock to it fires every
+ * 50us tick on the way (IRrecv), and setting the pin fires the pin change interrupt (IRrecvPCI).
+ * Each decoded frame is matched to the latest frame of the trace that has ended, has not been
+ * matched yet and carries the same code. Frames skipped over are lost; a decode that matches
+ * nothing is wrong.
+ */
+template<class R> static void replay(R &Receiver, const IRtrace &trace,
+    const IRreplayOptions &o, IRreplayStats &S) {
+  static uint16_t Buffer2[RAWBUF];
+  IRdecode Decoder;
+  if (o.doubleBuffer) Decoder.useDoubleBuffer(Buffer2);
+  Receiver.Mark_Excess = o.markExcess;
+  Receiver.ignoreSelfEcho = false; //the recorded frames are still in the echo log
+  Receiver.enableIRIn();
+  size_t NextEdge = 0, NextFrame = 0;
+  uint64_t Poll = o.pollUs, Resume = NEVER, Stop = trace.end() + REPLAY_TAIL_US;
+  while (true) {
+    uint64_t Edge = NextEdge < trace.edges.size() ? trace.edges[NextEdge].t : NEVER;
+    uint64_t Next = Edge < Poll ? Edge : Poll;
+    if (Resume < Next) Next = Resume;
+    if (Next > Stop) break;
+    IRhost_advanceTo(Next);
+    if (Next == Edge) {
+      IRhost_setPin(IR_SIM_RECV_PIN, trace.edges[NextEdge++].level);
+    } else if (Next == Resume) {
+      Receiver.resume();
+      Resume = NEVER;
+      Poll = IRhost_now() + o.pollUs;
+    } else {
+      S.polls++;
+      if (!Receiver.getResults(&Decoder)) {
+        Poll += o.pollUs;
+        continue;
+      }
+      uint64_t Now = IRhost_now();
+      S.received++;
+      if (Decoder.rawlen >= RAWBUF - 1) S.overflows++;
+      bool Ok = Decoder.decode();
+      if (o.capture) o.capture->add(Now, o.receiver, Decoder);
+      //the latest frame that has ended and has what we decoded
+      size_t i = NextFrame;
+      while (i < trace.frames.size() && trace.frames[i].end <= Now) i++;
+      if (Ok) {
+        while (i > NextFrame && (trace.frames[i-1].type != Decoder.decode_type
+            || trace.frames[i-1].value != (uint32_t)Decoder.value)) i--;
+        Ok = i-- > NextFrame;
+      }
+      if (Ok) {
+        uint64_t Latency = Now - trace.frames[i].end;
+        S.lost += i - NextFrame;
+        NextFrame = i + 1;
+        S.matched++;
+        S.latencySum += Latency;
+        if (Latency < S.latencyMin) S.latencyMin = Latency;
+        if (Latency > S.latencyMax) S.latencyMax = Latency;
+      } else {
+        S.wrong++;
+      }
+      if (o.verbose)
+        printf("%10llu %-4s %-13s %08lX %2d bits rawlen %u\n", (unsigned long long)Now, Ok ? "ok" : "bad",
+          IRsim_protocolName(Decoder.decode_type), (unsigned long)Decoder.value, Decoder.bits, Decoder.rawlen);
+      Resume = Now + o.busyUs;
+      Poll = NEVER;
+    }
+  }
+  S.lost += trace.frames.size() - NextFrame;
+}
+
+IRreplayStats IRreplay(const IRtrace &trace, const IRreplayOptions &options) {
+  IRreplayStats S;
+  memset(&S, 0, sizeof(S));
+  S.latencyMin = NEVER;
+  S.sent = trace.frames.size();
+  IRhost_reset();
+  if (options.receiver == IR_SIM_IRRECV) {
+    IRrecv Receiver(IR_SIM_RECV_PIN);
+    replay(Receiver, trace, options, S);
+    Receiver.detachInterrupt();
+  } else {
+    IRrecvPCI Receiver(0);
+    replay(Receiver, trace, options, S);
+    Receiver.detachInterrupt();
+  }
+  if (!S.matched) S.latencyMin = 0;
+  return S;
+}
@@ -0,0 +1,86 @@
+/* IRLibSim.h - edge traces and the capture-replay simulator for the IRLib host build
+ * An IRtrace is a list of time stamped edges on the receiver pin, plus optionally the frames
+ * that were sent in it (the "truth"). Traces can be recorded from the library's own senders,
+ * or loaded from a text file captured elsewhere. IRreplay plays a trace into a real receiver
+ * on the virtual clock. It drives ISR(IR_RECV_INTR_NAME) tick by tick for IRrecv and the
+ * pin change handler edge by edge for IRrecvPCI, and calls getResults on a main-loop schedule.
+ * It then reports which frames were decoded, which were lost, and how late they arrived.
+ *
+ * Text trace format, one item per line, '#' starts a comment:
+ *   <t_us> <level>                      pin goes to level (0 = mark, 1 = space) at t_us
+ *   F <t_us> <protocol> <hex> <bits>    a frame of that protocol whose last mark ended at t_us
+ * Times must not decrease. Protocol names are those of Pnames() without spaces, e.g. NECx.
+ */
+#ifndef IRLibSim_h
+#define IRLibSim_h
+#include <IRLib.h>
+#include <IRLibMatch.h>
+#include <vector>
+#include <stdio.h>
+
+#define IR_SIM_RECV_PIN 2 //pin of interrupt 0 on the virtual Uno; IRrecv and IRrecvPCI both use it
+
+struct IRtraceEdge {
+  uint64_t t;      //us
+  uint8_t level;   //0 mark, 1 space
+};
+
+struct IRtraceFrame {
+  uint64_t end;    //us; end of the last mark
+  IR_types_t type;
+  uint32_t value;
+  uint8_t bits;
+};
+
+class IRtrace {
+public:
+  std::vector<IRtraceEdge> edges;
+  std::vector<IRtraceFrame> frames;
+  void clear(void) {edges.clear(); frames.clear();}
+  uint64_t end(void) const {return edges.empty() ? 0 : edges.back().t;}
+  //Appends one frame sent by IRsend::send after gap_us of silence; see recordFrame
+  void send(IR_types_t type, uint32_t value, unsigned int data2, uint32_t gap_us);
+  //Appends a frame produced by any sender. Call recordStart, send with any IRsendBase
+  //object, then recordEnd with what the decoder should report.
+  void recordStart(uint32_t gap_us);
+  void recordEnd(IR_types_t type, uint32_t value, uint8_t bits);
+  bool load(const char *path);  //text format above; false with a message on stderr on error
+  bool save(const char *path) const;
+};
+
+//Turns "NEC", "necx", "PanasonicOld" or a protocol number into IR_types_t; UNKNOWN if not found
+IR_types_t IRsim_protocol(const char *name);
+//Pnames() with the spaces removed, as used in trace files
+const char *IRsim_protocolName(IR_types_t type);
+
+enum IRsimReceiver {IR_SIM_IRRECV, IR_SIM_IRRECVPCI};
+class IRcaptureWriter;
+
+struct IRreplayOptions {
+  IRsimReceiver receiver;
+  uint32_t pollUs;      //the main loop calls getResults this often
+  uint32_t busyUs;      //after each frame it gets, the main loop is busy this long before polling again
+  bool doubleBuffer;    //give the decoder a second buffer (useDoubleBuffer); the library default is single
+  int16_t markExcess;
+  bool verbose;         //print every decoded frame to stdout
+  IRcaptureWriter *capture; //if set, every frame getResults returns is added to it (IRLibCapture.h)
+  IRreplayOptions(void): receiver(IR_SIM_IRRECV), pollUs(1000), busyUs(0),
+    doubleBuffer(false), markExcess(MARK_EXCESS_DEFAULT), verbose(false), capture(NULL) {}
+};
+
+struct IRreplayStats {
+  unsigned sent;        //frames in the trace
+  unsigned received;    //times getResults returned true
+  unsigned matched;     //decoded as the frame that was sent
+  unsigned lost;        //sent but never decoded
+  unsigned wrong;       //decoded as something that was not sent, or not decoded at all
+  unsigned overflows;   //received frames clamped at RAWBUF-1 entries
+  unsigned polls;       //getResults calls
+  uint64_t latencyMin, latencyMax, latencySum; //us from the end of a frame to getResults returning it
+  double latencyAvg(void) const {return matched ? (double)latencySum / matched : 0;}
+  void print(FILE *f) const;
+};
+
+IRreplayStats IRreplay(const IRtrace &trace, const IRreplayOptions &options);
+
+#endif //IRLibSim_h
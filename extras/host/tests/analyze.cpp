@@ -0,0 +1,124 @@
+/* analyze.cpp - regression test for IRanalyze (sim/IRLibAnalyze.h)
+ * Records presses of known protocols and checks what the analyzer infers: encoding, header,
+ * timings, bit count, repeat frame and codes, also for JVC, whose repeat frame is the full one
+ * without its header. A protocol of made-up timings goes through a receiver into a capture,
+ * and the decodeGeneric call the analyzer gives for it must decode every frame of the capture. Returns nonzero if anything failed.
+ */
+#include "IRLibAnalyze.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include "check.h"
+
+//within 5% of what was sent
+static bool near(unsigned int got, unsigned int sent) {
+  return got * 20 >= sent * 19 && got * 20 <= sent * 21;
+}
+
+//a receiver moves durations by Mark_Excess and rounds them to its 50us ticks
+static bool within(unsigned int got, unsigned int sent) {
+  return got + 100 >= sent && got <= sent + 100;
+}
+
+static bool hasCode(const IRanalyzeResult &r, uint64_t value) {
+  for (size_t k = 0; k < r.codes.size(); k++) if (r.codes[k].value.low == value) return true;
+  return false;
+}
+
+int main(void) {
+  IRtrace Trace;
+  IRanalyzeResult R;
+  IRhost_reset();
+
+  //NEC: three presses of one frame and three repeat frames each
+  const uint32_t Keys[] = {0x61A0F00FUL, 0x20DF10EFUL, 0x20DF906FUL};
+  for (int p = 0; p < 3; p++) {
+    Trace.send(NEC, Keys[p], 0, 500000);
+    for (int i = 0; i < 3; i++) Trace.send(NEC, REPEAT, 0, 40000);
+  }
+  R = IRanalyze(IRanalyze_frames(Trace));
+  R.print(stdout);
+  expect(R.encoding == IR_ANALYZE_PULSE_DISTANCE && R.bits == 32 && R.stop && R.rawCount == 68
+    && near(R.headMark, 563*16) && near(R.headSpace, 563*8) && near(R.markZero, 563)
+    && near(R.spaceZero, 563) && near(R.spaceOne, 563*3), "NEC: pulse distance, 32 bits, header");
+  expect(R.presses == 3 && R.repeatFrames == 9 && R.repeat.size() == 3 && near(R.repeat[1], 2250)
+    && !R.repeatsFull && R.codes.size() == 3 && hasCode(R, Keys[0]) && hasCode(R, Keys[2]), "NEC: repeat frame and codes");
+
+  //Sony: each press sends the frame three times
+  Trace.clear();
+  for (int p = 0; p < 2; p++)
+    for (int i = 0; i < 3; i++) Trace.send(SONY, p ? 0xA90 : 0x290, 12, i ? 20000 : 500000);
+  R = IRanalyze(IRanalyze_frames(Trace));
+  expect(R.encoding == IR_ANALYZE_PULSE_WIDTH && R.bits == 12 && !R.stop && R.rawCount == 26
+    && near(R.headMark, 2400) && near(R.markOne, 1200) && near(R.markZero, 600) && near(R.spaceOne, 600)
+    && R.presses == 2 && R.repeatsFull && R.repeat.empty() && hasCode(R, 0xA90), "Sony: pulse width, 12 bits, full frame repeats");
+
+  //JVC: the repeat frame is the full frame without its header
+  Trace.clear();
+  for (int p = 0; p < 2; p++) { //each press is a full frame and three repeat frames
+    Trace.send(JVC, p ? 0xC0F6 : 0xC0F4, 1, 500000);
+    for (int i = 0; i < 2; i++) Trace.send(JVC, p ? 0xC0F6 : 0xC0F4, 0, 30000);
+  }
+  R = IRanalyze(IRanalyze_frames(Trace));
+  expect(R.encoding == IR_ANALYZE_PULSE_DISTANCE && R.bits == 16 && R.stop && R.rawCount == 36
+    && near(R.headMark, 525*16) && near(R.headSpace, 525*8) && R.presses == 2 && R.repeatFrames == 6
+    && R.repeat.size() == 33 && !R.repeatsFull && R.codes.size() == 2 && hasCode(R, 0xC0F6), "JVC: repeat frame without the header");
+
+  //RC5 and RC6: bi-phase, with RC6's double width trailer bit
+  Trace.clear();
+  for (int i = 0; i < 4; i++) Trace.send(RC5, 0x1234 + 0x111 * i, 13, 100000);
+  R = IRanalyze(IRanalyze_frames(Trace));
+  expect(R.encoding == IR_ANALYZE_BIPHASE && !R.headMark && near(R.unit, 889) && R.bits == 14
+    && !R.wideBit && !R.irregular && hasCode(R, 0x3234), "RC5: bi-phase, start bit and 13 bits");
+  Trace.clear();
+  for (int i = 0; i < 4; i++) Trace.send(RC6, 0xF0F0 + i, 20, 100000);
+  R = IRanalyze(IRanalyze_frames(Trace));
+  expect(R.encoding == IR_ANALYZE_BIPHASE && near(R.headMark, 2666) && near(R.unit, 444) && R.bits == 21
+    && R.wideBit == 5 && !R.irregular, "RC6: bi-phase, header, trailer bit at double width");
+
+  //a protocol of made-up timings, received by IRrecv and read back from a capture
+  char Path[] = "/tmp/irlib-analyze-XXXXXX";
+  int fd = mkstemp(Path);
+  if (fd >= 0) close(fd);
+  Trace.clear();
+  IRsendBase Sender;
+  uint32_t Sent[8];
+  for (int i = 0; i < 8; i++) {
+    Sent[i] = (0x5A3C00 + i * 0x1111) & 0xFFFFFF;
+    Trace.recordStart(300000);
+    Sender.sendGeneric(Sent[i], 24, 3000, 1500, 400, 400, 1000, 400, 38, true);
+    Trace.recordEnd(UNKNOWN, Sent[i], 24);
+  }
+  IRcaptureWriter Writer;
+  IRreplayOptions Options;
+  Options.capture = &Writer;
+  Writer.open(Path);
+  IRreplay(Trace, Options);
+  Writer.close();
+  IRcaptureFile File;
+  bool Ok = File.open(Path) && File.size() == 8;
+  R = IRanalyze(IRanalyze_frames(File));
+  R.print(stdout, true);
+  expect(Ok && R.encoding == IR_ANALYZE_PULSE_DISTANCE && R.bits == 24 && R.presses == 8
+    && within(R.headMark, 3000) && within(R.headSpace, 1500) && within(R.markZero, 400) && within(R.spaceOne, 1000)
+    && within(R.spaceZero, 400) && R.codes.size() == 8, "made-up protocol from a capture");
+  IRdecode Decoder;
+  for (size_t i = 0; Ok && i < File.size(); i++) {
+    File.frame(i).load(Decoder);
+    Ok = Decoder.decodeGeneric(R.rawCount, R.headMark, R.headSpace, 0, R.markZero, R.spaceOne, R.spaceZero)
+      && Decoder.bits == 24 && Decoder.value == Sent[i];
+  }
+  expect(Ok, "its decodeGeneric call decodes every frame");
+  File.close();
+  unlink(Path);
+
+  //noise is not taken for a protocol
+  std::vector<IRanalyzeFrame> Noise(4);
+  for (size_t i = 0; i < Noise.size(); i++) {
+    Noise[i].start = i * 1000000;
+    for (int j = 0; j < 41; j++) Noise[i].durations.push_back(300 + (j * 7919 + i * 104729) % 3000);
+  }
+  R = IRanalyze(Noise);
+  expect(R.encoding == IR_ANALYZE_UNKNOWN, "noise has no encoding");
+
+  return checkDone();
+}
@@ -0,0 +1,80 @@
+/* batch.cpp - regression test for IRdecodeFrame and the threaded batch decoder (sim/IRLibBatch.h)
+ * Checks that IRdecodeFrame decodes like IRdecode without touching the receiver's buffers, and
+ * that a capture decoded on one thread and on several, with the symbol decoder or the library's,
+ * gives the same counts, and finds the one frame whose recorded value was changed. Returns nonzero if anything failed.
+ */
+#include "IRLibBatch.h"
+#include <IRLibRData.h>
+#include <unistd.h>
+#include "check.h"
+
+#define COPIES 2000
+
+int main(void) {
+  char Path[] = "/tmp/irlib-batch-XXXXXX";
+  int fd = mkstemp(Path);
+  if (fd >= 0) close(fd);
+
+  //frames as the receiver gives them, from a replay
+  IRtrace Trace;
+  IRhost_reset();
+  for (int i = 0; i < 3; i++) {
+    Trace.send(NEC, 0x61A0F00FUL + i, 0, 12000);
+    Trace.send(SONY, 0x74BCAUL, 20, 12000);
+    Trace.send(RC5, 0x1161UL + i, 13, 12000);
+    Trace.send(NECX, 0xE0E040BFUL, 0, 12000);
+  }
+  IRcaptureWriter Writer;
+  IRreplayOptions Options;
+  Options.capture = &Writer;
+  Writer.open(Path);
+  IRreplay(Trace, Options);
+  Writer.close();
+
+  //1: IRdecodeFrame against IRdecode, with the receiver double buffered
+  static uint16_t Buffer2[RAWBUF];
+  IRdecode Receiving;
+  Receiving.useDoubleBuffer(Buffer2);
+  IRcaptureFile File;
+  bool Ok = File.open(Path) && File.size() == 12;
+  IRdecodeFrame Frame;
+  uint16_t Raw[RAWBUF];
+  for (size_t i = 0; Ok && i < File.size(); i++) {
+    IRcaptureFrame F = File.frame(i);
+    IRdecodeResult R = Frame.decodeFrame(Raw, F.durations(Raw, RAWBUF));
+    F.load(Receiving);
+    Ok = Receiving.decode() && R.decode_type == Receiving.decode_type && R.value == Receiving.value
+      && R.bits == Receiving.bits && R.decode_type == F.protocol;
+  }
+  expect(Ok && irparams.rawbuf2 == Buffer2 && Frame.rawbuf != irparams.rawbuf1, "IRdecodeFrame decodes like IRdecode");
+  Raw[1] = 3000;
+  IRdecodeResult R = Frame.decodeFrame(Raw, 10);
+  expect(R.decode_type == UNKNOWN && !R.value && !R.bits, "nothing decoded");
+
+  //2: many copies, one of them recorded with a different value
+  std::vector<IRcaptureFrame> Frames;
+  for (size_t i = 0; i < File.size(); i++) Frames.push_back(File.frame(i));
+  std::vector<std::vector<uint16_t> > Durations(Frames.size(), std::vector<uint16_t>(RAWBUF));
+  for (size_t i = 0; i < Frames.size(); i++) Durations[i].resize(Frames[i].durations(Durations[i].data(), RAWBUF));
+  Writer.open(Path);
+  const size_t Changed = 5 * 12 + 4;
+  for (size_t n = 0; n < COPIES * Frames.size(); n++) {
+    const IRcaptureFrame &F = Frames[n % Frames.size()];
+    Writer.add(n * 100000ULL, 0, F.protocol, F.bits, n == Changed ? F.value ^ 1 : F.value,
+      Durations[n % Frames.size()].data(), Durations[n % Frames.size()].size());
+  }
+  Writer.close();
+  File.open(Path);
+  IRbatchStats One = IRbatchDecode(File, 1), Four = IRbatchDecode(File, 4, 100, true);
+  One.print(stdout);
+  Four.print(stdout);
+  expect(One.frames == 12 * COPIES && One.decoded[NEC] == 3 * COPIES && One.decoded[SONY] == 3 * COPIES
+    && One.decoded[RC5] == 3 * COPIES && One.decoded[NECX] == 3 * COPIES, "counts on one thread");
+  expect(!memcmp(One.decoded, Four.decoded, sizeof(One.decoded)) && Four.threads == 4, "same counts on four threads with symbols");
+  expect(One.differ == 1 && Four.differ == 1 && Four.differing.size() == 1 && Four.differing[0] == Changed,
+    "changed frame found");
+  File.close();
+
+  unlink(Path);
+  return checkDone();
+}
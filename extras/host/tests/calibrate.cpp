@@ -0,0 +1,83 @@
+/* calibrate.cpp - regression test for IRrecvBase::calibrate
+ * Plays NEC and Sony frames into both receivers through a virtual IR receiver that stretches
+ * every mark and shortens every space, with some jitter on top. A receiver that calibrates
+ * must find the skew and decode more frames than one left at MARK_EXCESS_DEFAULT. Also checks
+ * the bounds, a Mark_Excess set by hand, and protocols that have no timings to compare with.
+ * Returns nonzero if anything failed.
+ */
+#include "IRLibSim.h"
+#include <stdlib.h>
+#include "check.h"
+
+#define SKEW 120   //us; the virtual receiver's marks are this much too long
+#define JITTER 80  //us; plus or minus, on every edge
+
+static uint32_t Seed = 1234;
+static int jitter(void) {Seed = Seed * 1664525 + 1013904223; return (int)((Seed >> 8) % (2*JITTER + 1)) - JITTER;}
+
+//Plays a frame with marks skew us too long, and returns whether it was received and decoded
+template<class R> static bool play(R &receiver, IRdecode &decoder, const std::vector<uint16_t> &d, int skew, bool calibrate) {
+  IRhost_advance(50000);
+  for (size_t i = 1; i < d.size(); i++) { //d[0] is the gap before the frame
+    IRhost_setPin(IR_SIM_RECV_PIN, i % 2 ? LOW : HIGH);
+    IRhost_advance(d[i] + (i % 2 ? skew : -skew) + jitter());
+  }
+  IRhost_setPin(IR_SIM_RECV_PIN, HIGH);
+  IRhost_advance(50000);
+  bool Ok = receiver.getResults(&decoder) && decoder.decode();
+  if (Ok && calibrate) receiver.calibrate(&decoder);
+  receiver.resume();
+  return Ok;
+}
+
+template<class R> static void run(const char *name, R &receiver) {
+  char What[96];
+  IRdecode Decoder;
+  std::vector<uint16_t> Frames[2] = {frame(NEC, 0x61A0F00FUL, 0), frame(SONY, 0x74BCAUL, 20)};
+  receiver.enableIRIn();
+  receiver.ignoreSelfEcho = false;
+
+  int Fixed = 0, Calibrated = 0;
+  for (int i = 0; i < 40; i++) Fixed += play(receiver, Decoder, Frames[i % 2], SKEW, false);
+  for (int i = 0; i < 40; i++) Calibrated += play(receiver, Decoder, Frames[i % 2], SKEW, true);
+  int Excess = receiver.Mark_Excess;
+  int After = 0;
+  for (int i = 0; i < 40; i++) After += play(receiver, Decoder, Frames[i % 2], SKEW, true);
+  printf("     %s: %d/40 decoded at Mark_Excess %d, %d/40 while calibrating, %d/40 after; Mark_Excess now %d\n",
+    name, Fixed, MARK_EXCESS_DEFAULT, Calibrated, After, receiver.Mark_Excess);
+  snprintf(What, sizeof(What), "%s finds a skew of %dus", name, SKEW);
+  expect(abs(Excess - SKEW) <= 15 && abs(receiver.Mark_Excess - SKEW) <= 15, What);
+  snprintf(What, sizeof(What), "%s decodes more once calibrated", name);
+  expect(After == 40 && After > Fixed, What);
+
+  receiver.Mark_Excess = 140;  //set by hand, then frames that call for more than the bound
+  for (int i = 0; i < 40; i++) play(receiver, Decoder, Frames[i % 2], 190, true);
+  snprintf(What, sizeof(What), "%s stays within MARK_EXCESS_MAX", name);
+  expect(receiver.Mark_Excess == MARK_EXCESS_MAX, What);
+
+  receiver.Mark_Excess = -20;
+  for (int i = 0; i < 40; i++) play(receiver, Decoder, Frames[i % 2], -60, true);
+  snprintf(What, sizeof(What), "%s follows a negative skew", name);
+  expect(abs(receiver.Mark_Excess + 60) <= 15, What);
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Tick(IR_SIM_RECV_PIN);
+  run("IRrecv", Tick);
+  Tick.detachInterrupt();
+
+  IRhost_reset();
+  IRrecvPCI Edge(0);
+  run("IRrecvPCI", Edge);
+
+  IRdecode Decoder;
+  Decoder.decode_type = HASH_CODE;
+  Decoder.rawlen = 3;
+  Decoder.rawbuf[1] = 600; Decoder.rawbuf[2] = 600;
+  Edge.Mark_Excess = 50;
+  expect(!Edge.calibrate(&Decoder) && Edge.Mark_Excess == 50, "hash codes leave Mark_Excess alone");
+  Edge.detachInterrupt();
+
+  return checkDone();
+}
@@ -0,0 +1,105 @@
+/* capture.cpp - regression test for binary capture files (sim/IRLibCapture.h)
+ * Captures the frames of a replay, maps the file back and checks that every frame decodes as
+ * it did when captured. Also checks durations stored in 50us ticks, a file whose index was
+ * never written, files that are not captures, and a corpus of a few hundred thousand frames.
+ * Returns nonzero if anything failed.
+ */
+#include "IRLibCapture.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "check.h"
+
+static std::string tempPath(void) {
+  char Path[] = "/tmp/irlib-capture-XXXXXX";
+  int fd = mkstemp(Path);
+  if (fd >= 0) close(fd);
+  return Path;
+}
+
+static void patch(const std::string &path, long at, const void *data, size_t len) {
+  FILE *f = fopen(path.c_str(), "r+b");
+  fseek(f, at, SEEK_SET);
+  fwrite(data, 1, len, f);
+  fclose(f);
+}
+
+int main(void) {
+  std::string Path = tempPath();
+  IRtrace Trace;
+  IRhost_reset();
+  for (int i = 0; i < 5; i++) {
+    Trace.send(NEC, 0x61A0F00FUL + i, 0, 12000);
+    Trace.send(RC6, 0x1F0C5UL + i, 20, 12000);
+    Trace.send(SONY, 0x74BCAUL, 20, 12000);
+  }
+
+  //1: every frame of a replay, captured and decoded again
+  IRcaptureWriter Writer;
+  IRreplayOptions Options;
+  Options.receiver = IR_SIM_IRRECVPCI;
+  Options.capture = &Writer;
+  bool Opened = Writer.open(Path.c_str());
+  IRreplayStats S = IRreplay(Trace, Options);
+  expect(Opened && Writer.close() && Writer.frames() == S.received && S.matched == 15, "replay captured");
+  IRcaptureFile File;
+  IRdecode Decoder;
+  bool Ok = File.open(Path.c_str()) && File.size() == 15;
+  for (size_t i = 0; Ok && i < File.size(); i++) {
+    IRcaptureFrame F = File.frame(i);
+    F.load(Decoder);
+    Ok = F.receiver == IR_SIM_IRRECVPCI && F.tick == 1 && Decoder.rawlen == F.count
+      && Decoder.decode() && Decoder.decode_type == F.protocol && Decoder.value == F.value
+      && Decoder.bits == F.bits && Decoder.value == Trace.frames[i].value
+      && (i == 0 || F.t > File.frame(i - 1).t);
+  }
+  expect(Ok, "frames decode as captured");
+
+  //2: ticks of 50us
+  uint16_t Raw[] = {20000, 9000, 4475, 560, 1690, 560}, Back[8];
+  Writer.open(Path.c_str());
+  Writer.add(1234567890123ULL, 3, NEC, 32, 0xDEADBEEF, Raw, 6, USEC_PER_TICK);
+  Writer.close();
+  File.open(Path.c_str());
+  IRcaptureFrame F = File.frame(0);
+  uint16_t n = F.durations(Back, 8);
+  expect(File.size() == 1 && F.t == 1234567890123ULL && F.receiver == 3 && F.value == 0xDEADBEEF
+    && F.tick == USEC_PER_TICK && n == 6 && Back[0] == 20000 && Back[2] == 4500 && Back[4] == 1700
+    && F.size == 6 + 2, "durations in ticks");
+  n = F.durations(Back, 3);
+  expect(n == 3 && Back[2] == 4500, "durations stop at max");
+
+  //3: a writer that never got to close leaves no frame count and no index
+  Writer.open(Path.c_str());
+  for (int i = 0; i < 4; i++) Writer.add(i, 0, NEC, 32, i, Raw, 6);
+  Writer.close();
+  uint8_t Zero[16] = {0};
+  patch(Path, 8, Zero, 16);
+  struct stat St;
+  stat(Path.c_str(), &St);
+  Ok = !truncate(Path.c_str(), St.st_size - 4 * 8 - 5); //no index, and the last frame cut short
+  expect(Ok && File.open(Path.c_str()) && File.size() == 3 && File.frame(2).value == 2, "no index: frames found");
+  patch(Path, 0, "IRCX", 4);
+  expect(!File.open(Path.c_str()), "not a capture");
+  uint8_t Version[2] = {9, 0};
+  patch(Path, 0, "IRCF", 4);
+  patch(Path, 4, Version, 2);
+  expect(!File.open(Path.c_str()), "unknown version");
+
+  //4: a large corpus; opening it reads nothing but the header
+  const unsigned Large = 300000;
+  Writer.open(Path.c_str());
+  for (unsigned i = 0; i < Large; i++) {
+    Raw[3] = 500 + i % 100;
+    Writer.add(i * 100ULL, 0, NEC, 32, i, Raw, 6);
+  }
+  Ok = Writer.close() && File.open(Path.c_str()) && File.size() == Large;
+  F = File.frame(Large - 1);
+  Ok = Ok && F.value == Large - 1 && F.durations(Back, 8) == 6 && Back[3] == 500 + (Large - 1) % 100;
+  expect(Ok, "large corpus");
+  File.close();
+
+  unlink(Path.c_str());
+  return checkDone();
+}
@@ -0,0 +1,130 @@
+/* carrier.cpp - regression test for carrier-aware decoding
+ * A demodulating receiver on pin 2 gets every protocol looped back while a simulated TSMP58000
+ * on pin 3 (interrupt 1) sees its carrier. IRfrequency::pair must measure the carrier IRsend
+ * used, and IRdecode::decode must then decode the frame with fewer attempts than without it.
+ * A frame with a carrier no protocol of its timing uses must still decode, after the protocols
+ * of that carrier, and so must one measured a little off its nominal carrier. A frame the
+ * TSMP58000 missed must get no carrier and decode as before. Links irlib_stats for the
+ * attempt counts. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <stdio.h>
+#include "check.h"
+
+#define RECV_PIN 2
+#define FREQ_INTR 1 //pin 3 on the virtual Uno
+
+struct Case {
+  IR_types_t type;
+  unsigned long value;
+  unsigned int data2;
+  IR_types_t expect;    //Samsung32 decodes as NEC, see roundtrip.cpp; both are sent at 38kHz
+};
+
+static const Case Cases[] = {
+  {NEC,           0x61A0F00FUL, 0,  NEC},
+  {SONY,          0x74BCAUL,    20, SONY},
+  {RC5,           0x1ABCUL,     0,  RC5},
+  {RC6,           0x1F0C5UL,    20, RC6},
+  {PANASONIC_OLD, 0x37AC81UL,   0,  PANASONIC_OLD},
+  {JVC,           0xC0F8UL,     1,  JVC},
+  {NECX,          0xE0E040BFUL, 0,  NECX},
+  {SAMSUNG32,     0xE0E09966UL, 0,  NEC},
+};
+#define CASE_COUNT (sizeof(Cases)/sizeof(Cases[0]))
+
+//What the TSMP58000 passes on: one falling edge per carrier cycle
+static void carrierBurst(double khz, unsigned cycles) {
+  uint64_t Start = IRhost_now();
+  for (unsigned i = 1; i <= cycles; i++) {
+    IRhost_advanceTo(Start + (uint64_t)(i * 1000 / khz));
+    IRhost_setPin(3, LOW);
+    IRhost_setPin(3, HIGH);
+  }
+}
+
+static unsigned attempts(void) {
+  irstats_t Copy;
+  IRstats_snapshot(&Copy);
+  unsigned Sum = 0;
+  for (int i = 0; i <= LAST_PROTOCOL; i++) Sum += Copy.decodeAttempts[i];
+  IRstats_clear();
+  return Sum;
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Receiver(RECV_PIN);
+  IRfrequency Freq(FREQ_INTR);
+  IRsend Sender;
+  IRdecode Decoder;
+  Receiver.enableIRIn();
+  Receiver.ignoreSelfEcho = false;
+  IRhost_loopback(RECV_PIN);
+  Freq.enableFreqDetect();
+
+  unsigned Paired = 0, Tables = 0, With = 0, Without = 0;
+  for (unsigned i = 0; i < CASE_COUNT; i++) {
+    const Case &c = Cases[i];
+    IRhost_advance(50000);
+    Sender.send(c.type, c.value, c.data2, false);
+    unsigned Sent = IRhost_carrierKHz();
+    carrierBurst(Sent, 300);
+    IRhost_advance(20000);
+    if (IRcarrier(c.type) == Sent) Tables++;
+    bool Got = Receiver.getResults(&Decoder) && Freq.pair(&Decoder);
+    IRstats_clear();
+    bool Ok = Got && Decoder.carrier == Sent && Decoder.decode() && Decoder.decode_type == c.expect
+      && Decoder.value == c.value;
+    With += attempts();
+    unsigned Measured = Decoder.carrier;
+    Decoder.carrier = 0;
+    Decoder.decode();
+    Without += attempts();
+    printf("     %-13s sent at %ukHz, measured %.2fkHz (%u), decoded %s\n", (const char *)Pnames(c.type),
+      Sent, Freq.results, Measured, Ok ? (const char *)Pnames(Decoder.decode_type) : "wrong");
+    if (Ok) Paired++;
+    Receiver.resume();
+  }
+  expect(Tables == CASE_COUNT, "IRcarrier agrees with IRsend");
+  expect(Paired == CASE_COUNT, "every frame paired with its carrier and decoded");
+  printf("     decode attempts: %u with the carrier, %u without\n", With, Without);
+  expect(With < Without, "the carrier saves decode attempts");
+
+  //An NEC frame that came with a 57kHz carrier: Panasonic Old is tried first, then the rest
+  IRhost_advance(50000);
+  Sender.send(NEC, 0x61A0F00FUL, 0, false);
+  carrierBurst(57, 300);
+  IRhost_advance(20000);
+  bool Got = Receiver.getResults(&Decoder) && Freq.pair(&Decoder) && Decoder.carrier == 57;
+  IRstats_clear();
+  expect(Got && Decoder.decode() && Decoder.decode_type == NEC && attempts() == 2,
+    "NEC timings at 57kHz decode after the 57kHz protocols");
+  Receiver.resume();
+
+  //An NEC remote a little fast: 39.6kHz rounds to 40, which is Sony's
+  IRhost_advance(50000);
+  Sender.send(NEC, 0x61A0F00FUL, 0, false);
+  carrierBurst(39.6, 300);
+  IRhost_advance(20000);
+  expect(Receiver.getResults(&Decoder) && Freq.pair(&Decoder) && Decoder.carrier == 40 && Decoder.decode()
+    && Decoder.decode_type == NEC && Decoder.value == 0x61A0F00FUL, "NEC measured at 39.6kHz decodes");
+  Receiver.resume();
+
+  //The TSMP58000 did not see this one; the burst of the last frame must not be used again
+  IRhost_advance(50000);
+  Sender.send(SONY, 0x74BCAUL, 20, false);
+  IRhost_advance(20000);
+  expect(Receiver.getResults(&Decoder) && !Freq.pair(&Decoder) && !Decoder.carrier && Decoder.decode()
+    && Decoder.decode_type == SONY, "no carrier measured; every protocol is tried");
+  Receiver.resume();
+
+  {
+    unsigned char Khz;
+    Sender.send(PANASONIC_NEW, 0x12345678UL, 0x1234, false);
+    Khz = IRhost_carrierKHz();
+    expect(IRcarrier(PANASONIC_NEW) == Khz && IRcarrier(HASH_CODE) == 0 && IRcarrier(UNKNOWN) == 0,
+      "Panasonic, hash codes and unknown");
+  }
+  return checkDone();
+}
@@ -0,0 +1,54 @@
+/* check.h - what the host tests share
+ * expect() prints PASS or FAIL and what was checked, and counts the failures. checkDone()
+ * prints the count and returns the exit code of main(): nonzero if anything failed.
+ * Tests that include IRLibSim.h before this file also get frame(), durations(), load() and
+ * decode(), which make a sender's frame and put it in a decoder as getResults would.
+ */
+#ifndef check_h
+#define check_h
+#include <stdio.h>
+
+static int Failures;
+
+static inline void expect(bool ok, const char *what) {
+  if (!ok) Failures++;
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+}
+
+static inline int checkDone(void) {
+  printf("%d failures\n", Failures);
+  return Failures ? 1 : 0;
+}
+
+#ifdef IRLibSim_h
+//The first frame of a trace, rawbuf[0] first: 10000us of gap, then up to the first space over 20ms
+static inline std::vector<uint16_t> durations(const IRtrace &trace) {
+  std::vector<uint16_t> D(1, 10000);
+  for (size_t i = 0; i + 1 < trace.edges.size(); i++) {
+    uint64_t Length = trace.edges[i + 1].t - trace.edges[i].t;
+    if (Length > 20000) break;
+    D.push_back(Length);
+  }
+  return D;
+}
+
+//The sender's timings of a frame. Recording it moves the virtual clock, so do it up front.
+static inline std::vector<uint16_t> frame(IR_types_t type, uint32_t value, unsigned int data2) {
+  IRtrace Trace;
+  Trace.send(type, value, data2, 10000);
+  return durations(Trace);
+}
+
+static inline void load(IRdecode &d, const std::vector<uint16_t> &durations) {
+  d.reset();
+  d.rawlen = durations.size();
+  for (size_t i = 0; i < durations.size(); i++) d.rawbuf[i] = durations[i];
+}
+
+static inline bool decode(IRdecode &d, const std::vector<uint16_t> &durations) {
+  load(d, durations);
+  return d.decode();
+}
+#endif //IRLibSim_h
+
+#endif //check_h
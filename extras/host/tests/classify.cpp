@@ -0,0 +1,151 @@
+/* classify.cpp - regression test for IRclassify and IRsymbolDecoder (sim/IRLibClassify.h)
+ * Checks that every implementation of IRclassify accepts exactly what MATCH accepts, and that
+ * IRsymbolDecoder gives the same result as IRdecodeFrame, fields included, on received,
+ * jittered, damaged and random frames. Returns nonzero if anything failed.
+ */
+#include "IRLibClassify.h"
+#include "IRLibCapture.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include "check.h"
+
+static uint32_t Seed = 4711;
+static uint32_t random32(void) {Seed = Seed * 1664525 + 1013904223; return Seed >> 8;}
+
+typedef std::vector<uint16_t> Frame;
+
+//Frames of every protocol as IRrecv and IRrecvPCI return them
+static std::vector<Frame> received(void) {
+  char Path[] = "/tmp/irlib-classify-XXXXXX";
+  int fd = mkstemp(Path);
+  if (fd >= 0) close(fd);
+  IRtrace Trace;
+  IRhost_reset();
+  for (int i = 0; i < 4; i++) {
+    Trace.send(NEC, random32(), 0, 12000);
+    Trace.send(SONY, random32() & 0xFFFFF, 20, 12000);
+    Trace.send(SONY, random32() & 0xFFF, 12, 12000);
+    Trace.send(RC5, random32() & 0x1FFF, 13, 12000);
+    Trace.send(RC6, random32() & 0xFFFFF, 20, 12000);
+    Trace.send(PANASONIC_OLD, random32() & 0x3FFFFF, 0, 12000);
+    Trace.send(JVC, random32() & 0xFFFF, 1, 12000);
+    Trace.send(NECX, random32(), 0, 12000);
+    Trace.send(PANASONIC_NEW, random32() & 0xFFFFFF, 0, 12000);
+    Trace.send(SAMSUNG32, random32(), 0, 12000);
+  }
+  IRcaptureWriter Writer;
+  IRreplayOptions Options;
+  Options.capture = &Writer;
+  Writer.open(Path);
+  IRreplay(Trace, Options);
+  Options.receiver = IR_SIM_IRRECVPCI;
+  IRreplay(Trace, Options);
+  Writer.close();
+  IRcaptureFile File;
+  std::vector<Frame> Frames;
+  File.open(Path);
+  for (size_t i = 0; i < File.size(); i++) {
+    Frame D(RAWBUF);
+    D.resize(File.frame(i).durations(D.data(), RAWBUF));
+    Frames.push_back(D);
+  }
+  unlink(Path);
+  return Frames;
+}
+
+static bool same(const IRdecodeResult &a, const IRdecodeResult &b) {
+  return a.decode_type == b.decode_type && a.value == b.value && a.bits == b.bits
+    && a.payload.low == b.payload.low && a.payload.length == b.payload.length
+    && a.fields.address == b.fields.address && a.fields.subAddress == b.fields.subAddress
+    && a.fields.command == b.fields.command && a.fields.extended == b.fields.extended
+    && a.fields.toggle == b.fields.toggle && a.fields.repeat == b.fields.repeat;
+}
+
+int main(void) {
+  const char *Names[] = {"scalar", "sse2", "avx2"};
+  const char *Best = IRclassify_implementation();
+  printf("     best implementation: %s\n", Best);
+
+  //1: the windows are those of MATCH, for every duration
+  IRsymbolDecoder Symbols;
+  unsigned Timings[] = {563*16, 563*8, 563, 563*3, 2250, 600*4, 600, 600*2, 889, 889*2, 889*3, 444, 444*2,
+    444*3, 2666, 833*4, 833, 833*3, 525*16, 525*8, 525, 525*3, 3456, 1728, 432, 1296, 560*16, 560*8, 560, 560*3};
+  const unsigned Count = sizeof(Timings)/sizeof(Timings[0]);
+  static uint16_t All[65536 + IR_CLASS_ENTRIES];
+  for (unsigned v = 0; v < 65536 + IR_CLASS_ENTRIES; v++) All[v] = v;
+  bool Ok = true;
+  for (unsigned t = 0; t < Count; t++) {
+    IRclassWindow W = IRclass_window(Timings[t]);
+    for (unsigned v = 0; Ok && v < 65536; v++)
+      Ok = (!W.empty && v >= W.low && v <= W.high) == MATCH((uint16_t)v, Timings[t]);
+  }
+  expect(Ok, "windows equal MATCH");
+  for (int n = 0; n < 3; n++) {
+    char What[64];
+    if (!IRclassify_force(Names[n])) {printf("SKIP %s: not on this CPU\n", Names[n]); continue;}
+    Ok = true;
+    for (unsigned t = 0; t < Count; t++) {
+      IRclassWindow W = IRclass_window(Timings[t]);
+      //the whole range in runs of IR_CLASS_ENTRIES
+      for (unsigned v = 0; Ok && v < 65536; v += IR_CLASS_ENTRIES) {
+        IRclassSet S = IRclassify(All + v, IR_CLASS_ENTRIES, W);
+        for (unsigned i = 0; Ok && i < IR_CLASS_ENTRIES; i++)
+          Ok = !!(S >> i & 1) == MATCH((uint16_t)(v + i), Timings[t]);
+      }
+      //odd lengths and offsets, so the vector loops and their tails are both used
+      for (unsigned k = 0; Ok && k <= 40; k++) {
+        unsigned From = Timings[t] * 3 / 4 - 20 + k;
+        IRclassSet S = IRclassify(All + From, k, W);
+        for (unsigned i = 0; Ok && i < IR_CLASS_ENTRIES; i++)
+          Ok = !!(S >> i & 1) == (i < k && MATCH((uint16_t)(From + i), Timings[t]));
+      }
+    }
+    snprintf(What, sizeof(What), "%s classifies as MATCH", Names[n]);
+    expect(Ok, What);
+  }
+
+  //2: the symbol decoder against the library
+  std::vector<Frame> Frames = received(), Cases;
+  for (size_t i = 0; i < Frames.size(); i++) {
+    Cases.push_back(Frames[i]);
+    for (int j = 0; j < 8; j++) { //jitter by up to +-10%, then +-30%, over the tolerance sometimes
+      Frame D = Frames[i];
+      int Most = j < 4 ? 10 : 30;
+      for (size_t k = 1; k < D.size(); k++) D[k] += ((int)(random32() % (2*Most + 1)) - Most) * D[k] / 100;
+      Cases.push_back(D);
+    }
+    for (int j = 0; j < 4; j++) { //one entry damaged
+      Frame D = Frames[i];
+      D[1 + random32() % (D.size() - 1)] = random32() % 4000;
+      Cases.push_back(D);
+    }
+    Frame T = Frames[i];
+    T.resize(random32() % T.size());
+    Cases.push_back(T);
+  }
+  for (int i = 0; i < 2000; i++) { //random frames, of the lengths the decoders look for now and then
+    Frame D(i % 3 ? 1 + random32() % (RAWBUF - 1) : (i % 2 ? 68 : 34));
+    for (size_t k = 0; k < D.size(); k++) D[k] = random32() % 3000;
+    Cases.push_back(D);
+  }
+  IRdecodeFrame Library;
+  for (int n = 0; n < 3; n++) {
+    char What[96];
+    if (!IRclassify_force(Names[n])) continue;
+    size_t Same = 0, Decoded = 0, Shown = 0;
+    for (size_t i = 0; i < Cases.size(); i++) {
+      IRdecodeResult A = Library.decodeFrame(Cases[i].data(), Cases[i].size());
+      IRdecodeResult B = Symbols.decode(Cases[i].data(), Cases[i].size());
+      Same += same(A, B);
+      Decoded += A.decode_type != UNKNOWN;
+      if (!same(A, B) && Shown++ < 5)
+        printf("     case %zu: library %d %lX/%d, symbols %d %lX/%d\n", i, A.decode_type, A.value, A.bits,
+          B.decode_type, B.value, B.bits);
+    }
+    snprintf(What, sizeof(What), "%s symbol decoder equals library on %zu frames (%zu decoded)", Names[n], Cases.size(), Decoded);
+    expect(Same == Cases.size() && Decoded > Frames.size(), What);
+  }
+  IRclassify_force(Best);
+
+  return checkDone();
+}
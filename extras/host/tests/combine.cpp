@@ -0,0 +1,136 @@
+/* combine.cpp - regression test for IRcombiner
+ * Sends groups of three copies of NEC, Sony, RC5 and JVC frames, as remotes repeat them,
+ * with one mark or space of each copy stretched or cut at a different place, beyond MATCH. Decoding every
+ * copy alone loses most of them; the combiner must decode the third copy of every group from
+ * the vote. Also checks the confidence it reports, that groups do not mix, and that a damaged
+ * frame of another key sent right after is not voted into the first one, and that a combiner
+ * of fewer than IR_COMBINE_MIN frames only decodes. Returns nonzero if anything failed.
+ */
+#include "IRLibSim.h"
+#include <IRLibCombine.h>
+#include <vector>
+#include "check.h"
+
+static uint32_t Seed = 7;
+static unsigned rnd(unsigned n) {Seed = Seed * 1664525 + 1013904223; return (Seed >> 8) % n;}
+
+//A frame in the decoder with entry bad (if not 0) cut or stretched beyond any MATCH
+static void load(IRdecode &d, const std::vector<uint16_t> &durations, uint16_t bad) {
+  load(d, durations);
+  if (bad) d.rawbuf[bad] = rnd(2) ? d.rawbuf[bad] * 6 : d.rawbuf[bad] / 5;
+}
+
+struct Case {
+  IR_types_t type;
+  uint32_t value;
+  unsigned int data2;
+  unsigned period;      //ms between copies
+};
+
+static const Case Cases[] = {
+  {NEC,  0x61A0F00FUL, 0,  108},
+  {SONY, 0x74BCAUL,    20, 45},
+  {RC5,  0x1ABCUL,     0,  114},
+  {JVC,  0xC0F8UL,     0,  60},
+};
+
+int main(void) {
+  IRhost_reset();
+  uint16_t Buffer[3 * RAWBUF];
+  IRcombiner Combiner(Buffer, 3);
+  IRdecode Alone, Decoder;
+  for (unsigned c = 0; c < sizeof(Cases) / sizeof(Cases[0]); c++) {
+    const Case &k = Cases[c];
+    std::vector<uint16_t> Clean = frame(k.type, k.value, k.data2);
+    uint16_t Length = Clean.size();
+    unsigned Copies = 0, AloneOk = 0, Third = 0, Needed = 0, Voted = 0, Groups = 50;
+    for (unsigned g = 0; g < Groups; g++) {
+      uint16_t Bad[3];   //three different entries, one per copy
+      do {
+        for (int i = 0; i < 3; i++) Bad[i] = 1 + rnd(Length - 1);
+      } while (Bad[0] == Bad[1] || Bad[1] == Bad[2] || Bad[0] == Bad[2]);
+      for (int i = 0; i < 3; i++) {
+        IRhost_advance(k.period * 1000);
+        uint32_t Saved = Seed;
+        load(Alone, Clean, Bad[i]);
+        bool Fine = Alone.decode() && Alone.value == k.value; //e.g. a stop mark nobody checks
+        if (Fine) AloneOk++;
+        if (i == 2 && !Fine) Needed++;
+        Seed = Saved;
+        load(Decoder, Clean, Bad[i]);
+        bool Ok = Combiner.decode(&Decoder) && Decoder.decode_type == k.type && Decoder.value == k.value;
+        Copies++;
+        if (i == 2 && Ok) Third++;
+        if (i == 2 && !Fine && Combiner.voted && Combiner.weakest == 66) Voted++;
+      }
+      IRhost_advance(1000000); //the next press
+    }
+    printf("     %-5s %u copies: %u decode alone; with the combiner the third decodes in %u of %u groups\n",
+      (const char *)Pnames(k.type), Copies, AloneOk, Third, Groups);
+    expect(Third == Groups && Voted == Needed, (const char *)Pnames(k.type));
+  }
+
+  //Copies that are too far apart, or of another length, are not voted on
+  std::vector<uint16_t> Nec = frame(NEC, 0x61A0F00FUL, 0), Sony = frame(SONY, 0x74BCAUL, 20);
+  Combiner.clear();
+  for (int i = 0; i < 3; i++) {
+    IRhost_advance(400000);
+    load(Decoder, Nec, 5);
+    Combiner.decode(&Decoder);
+  }
+  expect(Combiner.group == 1 && !Combiner.voted, "a long pause starts a new group");
+  IRhost_advance(100000);
+  load(Decoder, Nec, 0);
+  Combiner.decode(&Decoder);
+  IRhost_advance(100000);
+  load(Decoder, Sony, 3);
+  expect(!Combiner.decode(&Decoder) && Combiner.group == 1, "another length starts a new group");
+
+  //Key B right after key A: a damaged B must not be voted into A
+  std::vector<uint16_t> Other = frame(NEC, 0x61A0E01FUL, 0); //another command
+  for (int Clean = 0; Clean < 2; Clean++) {
+    Combiner.clear();
+    for (int i = 0; i < 2; i++) {
+      IRhost_advance(108000);
+      load(Decoder, Nec, Clean ? 0 : 7 + 2 * i);
+      Combiner.decode(&Decoder);
+    }
+    IRhost_advance(108000);
+    load(Decoder, Other, 41);
+    bool Taken = Combiner.decode(&Decoder) && Decoder.value == 0x61A0F00FUL;
+    expect(!Taken && !Combiner.voted, Clean ? "a damaged next key after clean copies"
+      : "a damaged next key after damaged copies");
+  }
+  Combiner.clear();
+  IRhost_advance(108000);
+  load(Decoder, Nec, 0);
+  Combiner.decode(&Decoder);
+  IRhost_advance(108000);
+  load(Decoder, Other, 0);
+  expect(Combiner.decode(&Decoder) && Combiner.group == 1, "another code starts a new group");
+
+  //Confidence: entry 5 is damaged in one of three
+  Combiner.clear();
+  for (int i = 0; i < 3; i++) {
+    IRhost_advance(108000);
+    load(Decoder, Nec, i == 1 ? 5 : 0);
+    Combiner.decode(&Decoder);
+  }
+  expect(Combiner.confidence(5) == 66 && Combiner.confidence(6) == 100 && !Combiner.confidence(RAWBUF),
+    "confidence");
+
+  //Too few frames to vote: the combiner keeps none and only decodes
+  for (uint8_t f = 0; f < IR_COMBINE_MIN; f++) {
+    IRcombiner Small(Buffer, f);
+    bool Plain = true;
+    for (int i = 0; i < 3; i++) {
+      IRhost_advance(108000);
+      load(Decoder, Nec, i == 2 ? 5 : 0);
+      Plain &= Small.decode(&Decoder) == (i < 2) && Small.group == 0 && !Small.voted;
+    }
+    char What[48];
+    snprintf(What, sizeof(What), "%u frames: decodes without a vote", f);
+    expect(Plain, What);
+  }
+  return checkDone();
+}
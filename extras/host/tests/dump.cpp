@@ -0,0 +1,144 @@
+/* dump.cpp - regression test for IRdump (IRLibDump.h) and its host reader (sim/IRLibDumpRead.h)
+ * Dumps frames received through IRrecv and reads the bytes back. Checks that every field and
+ * every rawbuf entry survives, that poll never writes more than the port has room for, that a
+ * full buffer drops records instead of waiting and the reader counts them as lost, and that a
+ * corrupted record is skipped without losing the ones after it, and that a port which is not a
+ * HardwareSerial, as Serial is on 32u4 and SAMD boards, works too. Returns nonzero if anything failed.
+ */
+#include "IRLibDumpRead.h"
+#include <string.h>
+#include "check.h"
+
+#define RECV_PIN 2
+
+static bool receive(IRrecv &r, IRdecode &d, IR_types_t type, unsigned long value, unsigned int data2) {
+  IRsend Sender;
+  IRhost_advance(50000);
+  Sender.send(type, value, data2, false);
+  IRhost_advance(50000);
+  bool Got = r.getResults(&d) && d.decode();
+  r.resume();
+  return Got;
+}
+
+static void flush(IRdump &dump) {
+  while (dump.busy()) dump.poll();
+}
+
+//Everything written to Serial since the last call, as bytes
+static std::vector<uint8_t> output(void) {
+  const uint8_t *p = (const uint8_t *)IRhost_serialOutput();
+  std::vector<uint8_t> Bytes(p, p + IRhost_serialSize());
+  IRhost_serialClear();
+  return Bytes;
+}
+
+static std::vector<IRdumpRecord> readAll(IRdumpReader &reader, const std::vector<uint8_t> &bytes) {
+  std::vector<IRdumpRecord> Records;
+  IRdumpRecord r;
+  reader.feed(bytes.data(), bytes.size());
+  while (reader.next(r)) Records.push_back(r);
+  return Records;
+}
+
+//A Print that is not a HardwareSerial, like the USB Serial_ of 32u4 and SAMD cores
+class USBPort: public Print {
+public:
+  std::vector<uint8_t> bytes;
+  int availableForWrite(void) {return 16;}
+  size_t write(uint8_t c) {bytes.push_back(c); return 1;}
+};
+
+static bool same(const IRdumpRecord &r, const IRdecode &d) {
+  if (r.type != IR_DUMP_FRAME || r.protocol != d.decode_type || r.value != d.value
+    || r.bits != d.bits || r.raw.size() != d.rawlen) return false;
+  for (size_t i = 0; i < r.raw.size(); i++)
+    if (r.raw[i] != d.rawbuf[i]) return false;
+  return true;
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Receiver(RECV_PIN);
+  Receiver.enableIRIn();
+  Receiver.ignoreSelfEcho = false;
+  IRhost_loopback(RECV_PIN);
+  IRdecode Decoder;
+  IRdump Dump;
+
+  //1: one frame, written at most 8 bytes per poll
+  IRhost_serialTxRoom(8);
+  bool Got = receive(Receiver, Decoder, NEC, 0x61A0F00FUL, 0);
+  bool Added = Got && Dump.add(Decoder);
+  size_t First = IRhost_serialSize();
+  unsigned Polls = 0;
+  while (Dump.busy()) {Dump.poll(); Polls++;}
+  std::vector<uint8_t> Bytes = output();
+  expect(Added && First == 8 && Polls == (Bytes.size() - 1) / 8, "poll writes no more than the room");
+  IRdumpReader Reader;
+  std::vector<IRdumpRecord> Records = readAll(Reader, Bytes);
+  expect(Records.size() == 1 && same(Records[0], Decoder) && !Reader.crcErrors && !Reader.lost,
+    "NEC frame read back");
+  printf("     NEC: %u rawbuf entries in %u bytes\n", Decoder.rawlen, (unsigned)Bytes.size());
+
+  Got = receive(Receiver, Decoder, RC6, 0x1F0C5UL, 20);
+  Dump.add(Decoder);
+  flush(Dump);
+  Records = readAll(Reader, output());
+  expect(Got && Records.size() == 1 && same(Records[0], Decoder) && Records[0].seq == 1, "RC6 frame read back");
+
+  //2: nothing written while the port is full, so the buffer fills and records are dropped
+  IRhost_serialTxRoom(0);
+  uint16_t Dropped = Dump.dropped;
+  unsigned Kept = 0;
+  for (int i = 0; i < 5; i++) Kept += Dump.add(Decoder);
+  expect(Kept > 0 && Kept < 5 && (unsigned)(Dump.dropped - Dropped) == 5 - Kept && IRhost_serialSize() == 0,
+    "full buffer drops records");
+  IRhost_serialTxRoom(63);
+  flush(Dump);
+  Got = receive(Receiver, Decoder, SONY, 0x74BCAUL, 20);
+  Dump.add(Decoder);
+  flush(Dump);
+  Records = readAll(Reader, output());
+  expect(Got && Records.size() == Kept + 1 && same(Records.back(), Decoder) && Reader.lost == 5 - Kept,
+    "dropped records counted as lost");
+
+  //3: a damaged record is skipped and the next one still found
+  unsigned Lost = Reader.lost;
+  Dump.add(Decoder);
+  Dump.add(Decoder);
+  flush(Dump);
+  Bytes = output();
+  Bytes[10] ^= 0x40;
+  Records = readAll(Reader, Bytes);
+  expect(Records.size() == 1 && same(Records[0], Decoder) && Reader.crcErrors == 1 && Reader.lost == Lost + 1,
+    "bad CRC skipped");
+
+  //4: a dump turned into a trace replays to the same frames
+  std::vector<IRdumpRecord> Session;
+  IR_types_t Types[] = {NEC, SONY, RC5};
+  unsigned long Values[] = {0x61A0F00FUL, 0x74BCAUL, 0x1161UL};
+  unsigned int Bits[] = {0, 20, 13};
+  for (int i = 0; i < 3; i++) {
+    Got = receive(Receiver, Decoder, Types[i], Values[i], Bits[i]);
+    Dump.add(Decoder);
+    flush(Dump);
+  }
+  Session = readAll(Reader, output());
+  Receiver.detachInterrupt();
+  IRtrace Trace;
+  IRdump_toTrace(Session, Trace);
+  IRreplayStats S = IRreplay(Trace, IRreplayOptions());
+  expect(Session.size() == 3 && S.sent == 3 && S.matched == 3, "dump replays as a trace");
+
+  //5: any Print will do
+  USBPort Port;
+  IRdump USBDump(Port);
+  USBDump.add(Decoder);
+  flush(USBDump);
+  IRdumpReader USBReader;
+  Records = readAll(USBReader, Port.bytes);
+  expect(Records.size() == 1 && same(Records[0], Decoder) && IRhost_serialSize() == 0, "dump to another Print");
+
+  return checkDone();
+}
@@ -0,0 +1,92 @@
+/* frequency.cpp - regression test for the streaming IRfrequency estimator
+ * Feeds carrier bursts of known frequency and duty cycle into interrupt 1 (pin 3) the way a
+ * TSMP58000 passes them on, with glitches and long runs, and checks the frequency, duty cycle,
+ * burst count and histogram IRfrequency reports. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+
+#define FREQ_INTR 1 //pin 3 on the virtual Uno
+
+//cycles of a carrier of khz, low for duty percent of each one, with a glitch every glitchEvery cycles
+static void burst(double khz, unsigned duty, unsigned cycles, unsigned glitchEvery = 0) {
+  uint64_t Start = IRhost_now();
+  double Period = 1000.0 / khz;
+  for (unsigned i = 0; i < cycles; i++) {
+    uint64_t Fall = Start + (uint64_t)(i * Period + 0.5);
+    IRhost_advanceTo(Fall);
+    IRhost_setPin(3, LOW);
+    IRhost_advanceTo(Fall + (uint64_t)(Period * duty / 100 + 0.5));
+    IRhost_setPin(3, HIGH);
+    if (glitchEvery && i % glitchEvery == glitchEvery - 1) {
+      IRhost_advance(3);
+      IRhost_setPin(3, LOW);
+      IRhost_setPin(3, HIGH);
+    }
+  }
+  IRhost_advanceTo(Start + (uint64_t)(cycles * Period + 0.5));
+}
+
+int main(void) {
+  IRhost_reset();
+  IRfrequency Freq(FREQ_INTR);
+  printf("     IRfrequency takes %u bytes\n", (unsigned)sizeof(IRfrequency));
+  expect(sizeof(IRfrequency) < 256, "no time stamp buffer (it took 1KB here)");
+
+  //Results are there as soon as a few cycles are
+  Freq.enableFreqDetect(true);
+  burst(38, 33, 40);
+  Freq.computeFreq();
+  printf("     after 40 cycles: %.2fkHz from %u, duty %u%%, %u bursts\n", Freq.results, Freq.samples,
+    Freq.duty, Freq.bursts);
+  expect(Freq.results > 37.8 && Freq.results < 38.2 && Freq.samples == 39 && !Freq.haveData(),
+    "frequency from the first burst");
+  expect(Freq.duty >= 31 && Freq.duty <= 35 && Freq.bursts == 1, "duty cycle and bursts");
+
+  //Five more bursts with gaps; the gaps are not cycles
+  for (int i = 0; i < 5; i++) {
+    IRhost_advance(600);
+    burst(38, 33, 100);
+  }
+  Freq.computeFreq();
+  printf("     after 6 bursts: %.2fkHz from %u, duty %u%%, %u bursts\n", Freq.results, Freq.samples,
+    Freq.duty, Freq.bursts);
+  expect(Freq.results > 37.8 && Freq.results < 38.2 && Freq.samples == 39 + 5*99 && Freq.bursts == 6
+    && Freq.haveData(), "gaps between bursts are skipped and counted");
+
+  //Without duty cycle measurement, glitches are skipped
+  Freq.enableFreqDetect();
+  burst(57, 30, 300, 7);
+  Freq.computeFreq();
+  printf("     57kHz with glitches: %.2fkHz from %u, duty %u%%\n", Freq.results, Freq.samples, Freq.duty);
+  expect(Freq.results > 56.5 && Freq.results < 57.5 && Freq.samples == 299 && !Freq.duty, "glitches");
+
+  //Long runs halve the totals instead of overflowing, and keep the average
+  Freq.clear();
+  IRhost_advance(1000);
+  burst(36, 50, 70000);
+  Freq.computeFreq();
+  printf("     70000 cycles at 36kHz: %.2fkHz from %u\n", Freq.results, Freq.samples);
+  expect(Freq.results > 35.9 && Freq.results < 36.1 && Freq.samples < 65535 && Freq.samples > 30000,
+    "long runs");
+
+  //The histogram in dumpResults(true): 36kHz is 27.8us, so cycles of 27 and 28us
+  Freq.clear();
+  IRhost_advance(1000);
+  burst(36, 50, 500);
+  IRhost_serialClear();
+  Freq.dumpResults(true);
+  const char *Out = IRhost_serialOutput();
+  printf("%s", Out);
+  expect(strstr(Out, "27us:") && strstr(Out, "28us:") && !strstr(Out, "26us:") && !strstr(Out, "29us:"),
+    "histogram");
+
+  //clear() from pair(): the next frame starts from nothing
+  IRdecode Decoder;
+  Freq.pair(&Decoder);
+  Freq.computeFreq();
+  expect(Decoder.carrier == 36 && !Freq.samples && !Freq.bursts, "pair starts over");
+  return checkDone();
+}
@@ -0,0 +1,68 @@
+/* integrity.cpp - regression test for the integrity checks of IRdecodeBase::checks
+ * Decodes valid NEC, NECx, Samsung32, Panasonic_Old and Panasonic frames with every check on,
+ * then the same frames with one data bit flipped. A flipped bit must pass unnoticed without
+ * the checks and be rejected and counted with them. Returns nonzero if anything failed.
+ */
+#include "IRLibSim.h"
+#include <vector>
+#include "check.h"
+
+//Swaps the space of data bit bit (0 is the first sent) between its one and zero lengths
+static std::vector<uint16_t> flip(std::vector<uint16_t> d, unsigned bit) {
+  uint16_t &Space = d[4 + 2 * bit];
+  uint16_t Mark = d[3 + 2 * bit];
+  Space = Space > Mark * 2 ? Mark : Mark * 3;
+  return d;
+}
+
+struct Case {
+  IR_types_t type;
+  uint32_t value;
+  unsigned bit;         //a data bit to flip
+  IR_types_t unchecked; //what the flipped frame decodes as without checks
+};
+
+static const Case Cases[] = {
+  {NEC,           0x20DF10EFUL, 20, NEC},           //command 0x10, then 0xEF
+  {NEC,           0x20DF10EFUL, 3,  NEC},           //in the address; then it is taken for Samsung32
+  {NECX,          0xE0E040BFUL, 30, NECX},
+  {SAMSUNG32,     0xE0E09966UL, 17, NEC},           //Samsung32 decodes as NEC when unchecked
+  {PANASONIC_OLD, 0xD5E54UL,    5,  PANASONIC_OLD}, //0x1AB, then its complement 0x654
+  {PANASONIC_NEW, 0x100BCDUL,   44, PANASONIC_NEW}, //in the checksum: value does not change
+};
+
+int main(void) {
+  IRhost_reset();
+  IRdecode Plain, Checked;
+  Checked.checks = IR_CHECK_ALL;
+  for (unsigned c = 0; c < sizeof(Cases) / sizeof(Cases[0]); c++) {
+    const Case &k = Cases[c];
+    std::vector<uint16_t> Good = frame(k.type, k.value, 0), Bad = flip(Good, k.bit);
+    bool Valid = decode(Checked, Good) && Checked.decode_type == k.type && Checked.value == k.value;
+    bool Unnoticed = decode(Plain, Bad) && Plain.decode_type == k.unchecked;
+    unsigned Before = Checked.checkFailures;
+    bool Caught = !(decode(Checked, Bad) && Checked.decode_type == k.type) && Checked.checkFailures > Before;
+    printf("     %-13s %08lX bit %2u: unchecked %s %08lX, checked %s\n", (const char *)Pnames(k.type),
+      (unsigned long)k.value, k.bit, (const char *)Pnames(Plain.decode_type), Plain.value,
+      Checked.decode_type == UNKNOWN ? "rejected" : (const char *)Pnames(Checked.decode_type));
+    expect(Valid && Unnoticed && Caught, (const char *)Pnames(k.type));
+  }
+
+  //A bad NEC command fails the NEC check and then the Samsung32 one
+  IRdecode Fresh;
+  Fresh.checks = IR_CHECK_ALL;
+  expect(!decode(Fresh, flip(frame(NEC, 0x20DF10EFUL, 0), 20)) && Fresh.checkFailures == 2, "checkFailures");
+
+  //Samsung32 is no longer taken for NEC when the NEC address is checked
+  decode(Checked, frame(SAMSUNG32, 0xE0E09966UL, 0));
+  expect(Checked.decode_type == SAMSUNG32, "the address check tells Samsung32 from NEC");
+
+  //An extended NEC address passes the command check alone; with the address check too it is Samsung32's
+  IRdecode Command;
+  Command.checks = IR_CHECK_NEC_COMMAND;
+  std::vector<uint16_t> Extended = frame(NEC, 0x61A0F00FUL, 0);
+  expect(decode(Command, Extended) && Command.decode_type == NEC && Command.value == 0x61A0F00FUL
+    && decode(Checked, Extended) && Checked.decode_type == SAMSUNG32, "extended NEC addresses");
+  expect(decode(Checked, frame(NEC, REPEAT, 0)) && Checked.value == REPEAT, "NEC repeat frames have nothing to check");
+  return checkDone();
+}
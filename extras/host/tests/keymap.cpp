@@ -0,0 +1,85 @@
+/* keymap.cpp - regression test for IRkeymap
+ * Looks up the keys of a small table written as a sketch would, with an RC5 mask that ignores
+ * the toggle bit, and checks that IRkeymap_valid turns down tables out of order. Then builds
+ * a table of 500 random codes and compares every lookup with a linear search.
+ * Returns nonzero if anything failed.
+ */
+#include "IRLibKeymap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "check.h"
+
+enum {KEY_NONE, KEY_POWER, KEY_LEFT, KEY_RIGHT, KEY_PLAY, KEY_STOP, KEY_UP};
+
+#define RC5_NO_TOGGLE 0xFFFFF7FFUL //all but bit 11
+constexpr IRkeymapEntry Keys[] PROGMEM = {
+  IRkeymapKey(NEC,  0x20DF10EFUL, KEY_POWER),
+  IRkeymapKey(NEC,  0x20DFE01FUL, KEY_LEFT),
+  IRkeymapKey(SONY, 0x46BCAUL,    KEY_LEFT),
+  IRkeymapKey(SONY, 0x86BCAUL,    KEY_RIGHT),
+  IRkeymapKey(RC5,  0x1035UL,     KEY_PLAY, RC5_NO_TOGGLE),
+  IRkeymapKey(RC5,  0x1036UL,     KEY_STOP, RC5_NO_TOGGLE),
+  IRkeymapKey(JVC,  0xC1D0UL,     KEY_UP),
+};
+static_assert(IRkeymap_valid(Keys, IR_KEYMAP_SIZE(Keys)), "Keys is out of order");
+
+constexpr IRkeymapEntry Unsorted[] = {
+  IRkeymapKey(NEC, 0x20DFE01FUL, KEY_LEFT), IRkeymapKey(NEC, 0x20DF10EFUL, KEY_POWER)};
+static_assert(!IRkeymap_valid(Unsorted, IR_KEYMAP_SIZE(Unsorted)), "values out of order");
+constexpr IRkeymapEntry Twice[] = {
+  IRkeymapKey(NEC, 0x20DF10EFUL, KEY_POWER), IRkeymapKey(NEC, 0x20DF10EFUL, KEY_LEFT)};
+static_assert(!IRkeymap_valid(Twice, IR_KEYMAP_SIZE(Twice)), "a code twice");
+constexpr IRkeymapEntry Masks[] = {
+  IRkeymapKey(RC5, 0x1035UL, KEY_PLAY, RC5_NO_TOGGLE), IRkeymapKey(RC5, 0x1036UL, KEY_STOP)};
+static_assert(!IRkeymap_valid(Masks, IR_KEYMAP_SIZE(Masks)), "two masks for RC5");
+constexpr IRkeymapEntry Toggle[] = {IRkeymapKey(RC5, 0x1835UL, KEY_PLAY, RC5_NO_TOGGLE)};
+static_assert(!IRkeymap_valid(Toggle, IR_KEYMAP_SIZE(Toggle)), "a bit the mask leaves out");
+
+int main(void) {
+  IRkeymap Map(Keys, IR_KEYMAP_SIZE(Keys));
+  expect(Map.lookup(NEC, 0x20DF10EFUL) == KEY_POWER && Map.lookup(NEC, 0x20DFE01FUL) == KEY_LEFT
+    && Map.lookup(SONY, 0x86BCAUL) == KEY_RIGHT && Map.lookup(JVC, 0xC1D0UL) == KEY_UP, "every key is found");
+  expect(Map.lookup(RC5, 0x1035UL) == KEY_PLAY && Map.lookup(RC5, 0x1835UL) == KEY_PLAY
+    && Map.lookup(RC5, 0x1836UL) == KEY_STOP, "the RC5 mask ignores the toggle bit");
+  expect(Map.lookup(SONY, 0x20DF10EFUL) == IR_KEYMAP_NONE && Map.lookup(NEC, 0x86BCAUL) == IR_KEYMAP_NONE
+    && Map.lookup(NEC, REPEAT) == IR_KEYMAP_NONE && Map.lookup(RC6, 0x1035UL) == IR_KEYMAP_NONE
+    && Map.lookup(HASH_CODE, 0) == IR_KEYMAP_NONE && Map.lookup(UNKNOWN, 0) == IR_KEYMAP_NONE,
+    "codes of other protocols or not in the table");
+  IRdecode Decoder;
+  Decoder.decode_type = SONY; Decoder.value = 0x46BCAUL;
+  bool Found = Map.lookup(&Decoder) == KEY_LEFT;
+  Decoder.decode_type = UNKNOWN;
+  expect(Found && Map.lookup(&Decoder) == IR_KEYMAP_NONE, "lookup of a decoder");
+  IRkeymap Empty(Keys, 0);
+  expect(Empty.lookup(NEC, 0x20DF10EFUL) == IR_KEYMAP_NONE, "an empty table");
+
+  //500 random codes over every protocol; RC6 ignores its low nibble
+  srand(5);
+  std::vector<IRkeymapEntry> Big;
+  for (uint16_t k = 1; Big.size() < 500; k++) {
+    IR_types_t Type = 1 + rand() % (LAST_PROTOCOL - 1);
+    unsigned long Mask = Type == RC6 ? ~0xFUL & 0xFFFFFFFFUL : IR_KEYMAP_ALL;
+    unsigned long Value = ((unsigned long)rand() << 16 ^ rand()) & 0xFFFFFFFFUL & Mask;
+    if (Type == SONY) Value &= 0xFFF; //dense, so that neighbours are tried
+    bool Used = false;
+    for (size_t i = 0; i < Big.size(); i++) Used |= Big[i].protocol == Type && Big[i].value == Value;
+    if (!Used) Big.push_back(IRkeymapKey(Type, Value, k, Mask));
+  }
+  std::sort(Big.begin(), Big.end(), IRkeymap_before);
+  expect(IRkeymap_valid(Big.data(), Big.size()), "the sorted table is valid");
+  IRkeymap BigMap(Big.data(), Big.size());
+  int Wrong = 0;
+  for (int t = 0; t < 20000; t++) {
+    const IRkeymapEntry &E = Big[rand() % Big.size()];
+    unsigned long Value = t & 1 ? E.value | (~E.mask & rand() & 0xFFFFFFFFUL) : E.value + rand() % 3 - 1;
+    uint16_t Linear = IR_KEYMAP_NONE;
+    for (size_t i = 0; i < Big.size(); i++)
+      if (Big[i].protocol == E.protocol && Big[i].value == (Value & Big[i].mask)) Linear = Big[i].key;
+    if (BigMap.lookup(E.protocol, Value) != Linear) Wrong++;
+  }
+  printf("     %d of 20000 lookups differ from a linear search\n", Wrong);
+  expect(Wrong == 0, "500 keys");
+  return checkDone();
+}
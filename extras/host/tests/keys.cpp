@@ -0,0 +1,147 @@
+/* keys.cpp - regression test for IRkeys
+ * Plays presses, holds and taps of NEC, Sony, RC5 and JVC keys into a receiver at the rate
+ * each remote repeats, polling it every ms as a sketch would, feeds every decoded frame to IRkeys and checks the
+ * press, hold and release events it reports. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <IRLibKeys.h>
+#include "IRLibSim.h"
+#include <stdio.h>
+#include <string>
+#include "check.h"
+
+#define RECV_PIN 2
+
+static IRrecv Receiver(RECV_PIN);
+static IRdecode Decoder;
+static IRkeys Keys;
+static std::string Log;   //events as text, e.g. "P:NEC:61A0F00F H1 R1"
+static IRkeyEvent Last;   //the last event
+
+static void poll(void) {
+  if (Receiver.getResults(&Decoder)) {
+    Decoder.decode();
+    Keys.add(&Decoder);
+    Receiver.resume();
+  }
+  IRkeyEvent Event;
+  while (Keys.getEvent(&Event)) {
+    char Text[40];
+    if (Event.action == IR_KEY_PRESS)
+      snprintf(Text, sizeof(Text), " P:%s:%lX", (const char *)Pnames(Event.protocol), Event.value);
+    else
+      snprintf(Text, sizeof(Text), " %c%u", Event.action == IR_KEY_HOLD ? 'H' : 'R', Event.repeats);
+    Log += Text;
+    Last = Event;
+  }
+}
+
+//Appends count frames every period ms from start_ms to a remote's trace; after the first,
+//repeat instead of value if given. Returns the time the next frame would start.
+static uint64_t frames(IRtrace &remote, uint64_t start_ms, IR_types_t type, unsigned long value,
+    unsigned int data2, unsigned count, unsigned period, unsigned long repeat = 0, unsigned int repeat2 = 0) {
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t Gap = (start_ms + i * period) * 1000 - remote.end();
+    if (i && repeat) remote.send(type, repeat, repeat2, Gap);
+    else remote.send(type, value, data2, Gap);
+  }
+  return start_ms + count * period;
+}
+
+//Plays the trace into the receiver pin while the sketch polls every ms, then 300ms more
+static void play(const IRtrace &remote) {
+  uint64_t Start = IRhost_now();
+  for (size_t i = 0; i < remote.edges.size(); i++) {
+    uint64_t T = Start + remote.edges[i].t;
+    while (IRhost_now() + 1000 < T) {
+      IRhost_advance(1000);
+      poll();
+    }
+    IRhost_advanceTo(T);
+    IRhost_setPin(RECV_PIN, remote.edges[i].level);
+  }
+  for (int i = 0; i < 300; i++) {
+    IRhost_advance(1000);
+    poll();
+  }
+}
+
+static void check(const char *what, const char *expected) {
+  Log.erase(0, Log.find_first_not_of(' '));
+  bool Ok = Log == expected;
+  if (!Ok) printf("     got      %s\n     expected %s\n", Log.c_str(), expected);
+  expect(Ok, what);
+  Log.clear();
+}
+
+int main(void) {
+  IRhost_reset();
+  Receiver.enableIRIn();
+  IRtrace Remote;
+
+  //NEC: a frame, then REPEAT every 108ms while held
+  frames(Remote, 100, NEC, 0x61A0F00FUL, 0, 6, 108, REPEAT);
+  play(Remote);
+  check("NEC hold", "P:NEC:61A0F00F H1 H2 H3 H4 H5 R5");
+  //frames are received when they end, and a REPEAT frame is shorter than a full one
+  printf("     release after %lums, %ums between frames\n", Last.duration, Last.period);
+  expect(Last.duration >= 470 && Last.duration <= 550 && Last.period >= 94 && Last.period <= 110,
+    "duration and rate of the hold");
+
+  //Two taps of the same key are two presses; a REPEAT with nothing held is nothing
+  Remote.clear();
+  frames(Remote, 100, NEC, 0x61A0F00FUL, 0, 1, 108);
+  frames(Remote, 450, NEC, 0x61A0F00FUL, 0, 1, 108);
+  frames(Remote, 900, NEC, REPEAT, 0, 1, 108);
+  play(Remote);
+  check("NEC taps and a stray REPEAT", "P:NEC:61A0F00F R0 P:NEC:61A0F00F R0");
+
+  //Sony sends three frames per press; those are not holds
+  Remote.clear();
+  frames(Remote, 100, SONY, 0x74BCAUL, 20, 3, 45);
+  play(Remote);
+  check("Sony tap", "P:Sony:74BCA R0");
+  Remote.clear();
+  frames(Remote, 100, SONY, 0x74BCAUL, 20, 8, 45);
+  play(Remote);
+  check("Sony hold", "P:Sony:74BCA H1 H2 H3 H4 H5 R5");
+
+  //RC5: the same code with the toggle bit flipped is a new press, and the bit is not reported
+  Remote.clear();
+  uint64_t T = frames(Remote, 100, RC5, 0x1ABCUL, 0, 3, 114);
+  frames(Remote, T, RC5, 0x12BCUL, 0, 2, 114);
+  play(Remote);
+  check("RC5 toggle", "P:RC5:12BC H1 H2 R2 P:RC5:12BC H1 R1");
+
+  //JVC repeats without a header; IRsendJVC sends the first repeat right after the full frame,
+  //and that one belongs to the press
+  Remote.clear();
+  frames(Remote, 100, JVC, 0xC0F8UL, 1, 1, 100);
+  play(Remote);
+  check("JVC tap", "P:JVC:C0F8 R0");
+  Remote.clear();
+  frames(Remote, 100, JVC, 0xC0F8UL, 1, 4, 100, 0xC0F8UL, 0);
+  play(Remote);
+  check("JVC hold", "P:JVC:C0F8 H1 H2 H3 R3");
+
+  //Another key while one is held releases it first
+  Remote.clear();
+  T = frames(Remote, 100, NEC, 0x61A0F00FUL, 0, 3, 108, REPEAT);
+  frames(Remote, T, NEC, 0x61A0708FUL, 0, 2, 108, REPEAT);
+  play(Remote);
+  check("another key", "P:NEC:61A0F00F H1 H2 R2 P:NEC:61A0708F H1 R1");
+  //Events that are not taken in time are counted
+  Keys.clear();
+  for (int i = 0; i < 3; i++) {
+    Decoder.decode_type = NEC; Decoder.value = 0x100 + i; Decoder.bits = 32;
+    Keys.add(&Decoder);
+  }
+  IRkeyEvent Event;
+  int Taken = 0;
+  while (Keys.getEvent(&Event)) Taken++;
+  expect(Taken == IR_KEY_QUEUE && Keys.dropped == 1, "full queue");
+  expect(IRkey_toggle(RC6, 20) == 0x10000UL && IRkey_toggle(RC5, 13) == 0x800 && !IRkey_toggle(NEC, 32),
+    "toggle bits");
+
+  return checkDone();
+}
@@ -0,0 +1,132 @@
+/* multi.cpp - regression test for IRsendMulti
+ * Records an NEC and a Sony frame into pulse programs and plays them at the same time on two
+ * gate pins. A timer tick every microsecond watches the gates: each must switch at the edges
+ * of its own program, the carrier must stay on the whole time, and the send must take as long
+ * as the longer program. The same program on several pins must switch them together. Carriers
+ * too far apart, a program cut short by its buffer, and no emitters or too many, must be
+ * refused before anything is touched.
+ * Returns nonzero if anything failed.
+ */
+#include "IRLib.h"
+#include <vector>
+#include "check.h"
+
+#define GATE_A 4
+#define GATE_B 5
+#define GATE_C 6
+
+struct Edge {
+  uint64_t t;
+  uint8_t gates; //bits of port 0
+};
+static std::vector<Edge> Edges;
+static bool CarrierOff; //the carrier was off at some tick while a gate was HIGH
+
+static void watch(void) {
+  uint8_t Gates = IRhost_ports[0];
+  if (Edges.empty() || Edges.back().gates != Gates) Edges.push_back(Edge{IRhost_now(), Gates});
+  if (Gates && !IRhost_carrierIsOn()) CarrierOff = true;
+}
+
+static void record(IRpulseProgram &program, IR_types_t type, unsigned long value, unsigned int data2) {
+  IRsend Sender;
+  program.clear();
+  Sender.record(&program);
+  Sender.send(type, value, data2, false);
+  Sender.record(NULL);
+}
+
+//The times, from the first edge, at which pin goes HIGH or LOW
+static std::vector<uint64_t> switches(uint8_t pin) {
+  std::vector<uint64_t> T;
+  uint8_t Mask = digitalPinToBitMask(pin), Last = 0;
+  for (size_t i = 0; i < Edges.size(); i++) {
+    if ((Edges[i].gates & Mask) == Last) continue;
+    Last = Edges[i].gates & Mask;
+    T.push_back(Edges[i].t - Edges[0].t);
+  }
+  return T;
+}
+
+//True if the switches of a gate are the entries of its program, within a microsecond
+static bool follows(const std::vector<uint64_t> &t, const IRpulseProgram &p) {
+  if (t.size() != p.length) return false; //the last space ends with the send, not an edge
+  uint64_t At = 0;
+  for (uint16_t i = 0; i < p.length; i++) {
+    int64_t Off = (int64_t)t[i] - (int64_t)At;
+    if (Off < -1 || Off > 1) return false;
+    At += p.durations[i];
+  }
+  return true;
+}
+
+static unsigned long total(const IRpulseProgram &p) {
+  unsigned long Sum = 0;
+  for (uint16_t i = 0; i < p.length; i++) Sum += p.durations[i];
+  return Sum;
+}
+
+int main(void) {
+  IRhost_reset();
+  uint16_t BufferA[2 * RAWBUF], BufferB[2 * RAWBUF];
+  IRpulseProgram NecProgram(BufferA, 2 * RAWBUF), SonyProgram(BufferB, 2 * RAWBUF);
+  record(NecProgram, NEC, 0x61A0F00FUL, 0);
+  record(SonyProgram, SONY, 0x74BCAUL, 20);
+  expect(NecProgram.khz == 38 && SonyProgram.khz == 40 && !NecProgram.overflow && !SonyProgram.overflow,
+    "NEC and Sony recorded");
+
+  //1: two programs that overlap
+  IRsendMulti Multi;
+  const IRpulseProgram *Programs[] = {&NecProgram, &SonyProgram};
+  const uint8_t Pins[] = {GATE_A, GATE_B, GATE_C};
+  IRhost_configTicks(1);
+  IRhost_enableTicks(watch);
+  uint64_t Start = IRhost_now();
+  bool Sent = Multi.send(Programs, Pins, 2);
+  uint64_t Took = IRhost_now() - Start;
+  IRhost_enableTicks(NULL);
+  std::vector<uint64_t> A = switches(GATE_A), B = switches(GATE_B);
+  unsigned long Longer = max(total(NecProgram), total(SonyProgram));
+  printf("     NEC %lu us, Sony %lu us, both in %lu us\n", total(NecProgram), total(SonyProgram), (unsigned long)Took);
+  expect(Sent && IRhost_carrierKHz() == 38, "sent at the carrier of programs[0]");
+  expect(follows(A, NecProgram), "gate A switches at the edges of NEC");
+  expect(follows(B, SonyProgram), "gate B switches at the edges of Sony");
+  expect(!CarrierOff && !IRhost_carrierIsOn() && IRhost_ports[0] == 0, "carrier on while a gate is, all off after");
+  expect(Took >= Longer && Took < Longer + 10, "takes as long as the longer program");
+
+  //2: one program on three pins
+  Edges.clear();
+  IRhost_enableTicks(watch);
+  Sent = Multi.send(&SonyProgram, Pins, 3);
+  IRhost_enableTicks(NULL);
+  bool Together = true;
+  uint8_t All = digitalPinToBitMask(GATE_A) | digitalPinToBitMask(GATE_B) | digitalPinToBitMask(GATE_C);
+  for (size_t i = 0; i < Edges.size(); i++) Together &= Edges[i].gates == 0 || Edges[i].gates == All;
+  expect(Sent && Together && follows(switches(GATE_C), SonyProgram), "the same program on three pins");
+
+  //3: refused
+  uint16_t BufferC[2 * RAWBUF];
+  IRpulseProgram Rc5Program(BufferC, 2 * RAWBUF);
+  record(Rc5Program, RC5, 0x1161UL, 0);
+  const IRpulseProgram *Apart[] = {&Rc5Program, &SonyProgram};
+  Edges.clear();
+  IRhost_enableTicks(watch);
+  uint64_t Before = IRhost_now();
+  bool Refused = !Multi.send(Apart, Pins, 2);
+  IRhost_enableTicks(NULL);
+  expect(Refused && Edges.size() <= 1 && IRhost_now() - Before < 10 && !IRhost_carrierIsOn(),
+    "36 and 40 kHz refused, nothing sent");
+  const IRpulseProgram *Near[] = {&Rc5Program, &NecProgram};
+  expect(Multi.send(Near, Pins, 2), "36 and 38 kHz accepted");
+  uint8_t Many[IR_MULTI_MAX_EMITTERS + 1] = {0};
+  expect(!Multi.send(&NecProgram, Pins, 0) && !Multi.send(&NecProgram, Many, IR_MULTI_MAX_EMITTERS + 1),
+    "no emitters or too many refused");
+  uint16_t Short[8];
+  IRpulseProgram Cut(Short, 8);
+  record(Cut, NEC, 0x61A0F00FUL, 0);
+  const IRpulseProgram *WithCut[] = {&NecProgram, &Cut};
+  Before = IRhost_now();
+  expect(Cut.overflow && !Multi.send(WithCut, Pins, 2) && !Multi.send(&Cut, Pins, 1) && IRhost_now() - Before < 10,
+    "a program that overflowed refused");
+  return checkDone();
+}
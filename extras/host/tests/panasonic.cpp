@@ -0,0 +1,38 @@
+/* panasonic.cpp - regression test for the wire format of IRsendPanasonic and IRdecodePanasonic
+ * Reads the bits of sent Panasonic frames back from their spaces. The first 16 must be the
+ * identifier 0x2002 least significant bit first, which is 0x4004 in the order sent, then the 24
+ * bits of the value most significant first, then their XOR. The decoder must return exactly
+ * those 24 bits, with nothing of the identifier above them, and pass IR_CHECK_PANASONIC. Bits of
+ * the value above the 24 are not sent and must not change the XOR.
+ * Returns nonzero if anything failed.
+ */
+#include "IRLibSim.h"
+#include <vector>
+#include "check.h"
+
+static const unsigned long Values[] = {0x000000UL, 0x80013DUL, 0xFFFFFFUL, 0x123456UL, 0x0A0B0CUL, 0x100BCBDUL};
+
+int main(void) {
+  IRhost_reset();
+  IRdecode Decoder;
+  Decoder.checks = IR_CHECK_PANASONIC;
+  for (unsigned v = 0; v < sizeof(Values) / sizeof(Values[0]); v++) {
+    unsigned long Value = Values[v] & 0xFFFFFFUL;
+    std::vector<uint16_t> D = frame(PANASONIC_NEW, Values[v], 0);
+    //gap, header mark and space, 48 bits of mark and space, stop mark
+    uint64_t Wire = 0;
+    bool Shape = D.size() == 100 && D[1] == 3456 && D[2] == 1728;
+    for (unsigned i = 0; Shape && i < 48; i++) {
+      Shape = D[3 + 2 * i] == 432 && (D[4 + 2 * i] == 432 || D[4 + 2 * i] == 1296);
+      Wire = Wire << 1 | (D[4 + 2 * i] == 1296);
+    }
+    unsigned long Xor = (Value ^ (Value >> 8) ^ (Value >> 16)) & 0xFF;
+    char What[64];
+    snprintf(What, sizeof(What), "%06lX: identifier, value and XOR on the wire", Values[v]);
+    expect(Shape && (Wire >> 32) == 0x4004 && ((Wire >> 8) & 0xFFFFFF) == Value && (Wire & 0xFF) == Xor, What);
+    snprintf(What, sizeof(What), "%06lX: decoded to the same 24 bits", Values[v]);
+    expect(decode(Decoder, D) && Decoder.decode_type == PANASONIC_NEW && Decoder.value == Value
+      && Decoder.bits == 24, What);
+  }
+  return checkDone();
+}
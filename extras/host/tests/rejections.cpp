@@ -0,0 +1,77 @@
+/* rejections.cpp - regression test for IRLIB_REJECTIONS (built against irlib_rejections)
+ * Damages frames recorded from the senders in known places and checks that the decoders file
+ * the rejection under the right protocol, reason, offset and values, and that the ring and
+ * the histogram keep count. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <IRLibMatch.h>
+#include <stdio.h>
+#include "check.h"
+
+#define RECV_PIN 2
+
+static const irreject_t &newest(void) {
+  return irrejections.log[(irrejections.total - 1) & (IR_REJECT_LOG - 1)];
+}
+
+//Receives one frame through IRrecv into d
+static bool receive(IRrecv &r, IRdecode &d, IR_types_t type, unsigned long value, unsigned int data2) {
+  IRsend Sender;
+  IRhost_advance(50000);
+  Sender.send(type, value, data2, false);
+  IRhost_advance(50000);
+  bool Got = r.getResults(&d);
+  r.resume();
+  return Got;
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Receiver(RECV_PIN);
+  Receiver.enableIRIn();
+  Receiver.ignoreSelfEcho = false;
+  IRhost_loopback(RECV_PIN);
+  IRdecode Decoder;
+  IRrejections_clear();
+
+  bool Got = receive(Receiver, Decoder, NEC, 0x61A0F00FUL, 0);
+  Decoder.rawbuf[1] = 3000;              //header mark should be 9008
+  expect(Got && !Decoder.IRdecodeNEC::decode() && newest().protocol == NEC
+    && newest().reason == IRLIB_REJECT_HEADER_MARK && newest().offset == 1
+    && newest().measured == 3000 && newest().expected == 563*16, "NEC header mark");
+
+  Decoder.rawbuf[1] = 563*16;
+  Decoder.rawbuf[4] = 1100;              //neither a 0 nor a 1 space
+  expect(!Decoder.IRdecodeNEC::decode() && newest().reason == IRLIB_REJECT_DATA_SPACE
+    && newest().offset == 4 && newest().measured == 1100, "NEC data space");
+
+  Decoder.rawlen = 30;
+  expect(!Decoder.IRdecodeSony::decode() && newest().protocol == SONY
+    && newest().reason == IRLIB_REJECT_RAW_COUNT && newest().measured == 30, "Sony raw count");
+
+  //the whole chain on a frame nobody knows: one entry per decoder, JVC gives two
+  uint16_t Before = irrejections.total;
+  expect(!Decoder.decode() && irrejections.total - Before == 10, "chain on garbage");
+  expect(irrejections.histogram[NEC][IRLIB_REJECT_HEADER_MARK] == 1
+    && irrejections.histogram[NEC][IRLIB_REJECT_DATA_SPACE] == 1
+    && irrejections.histogram[NEC][IRLIB_REJECT_RAW_COUNT] == 1
+    && irrejections.histogram[SONY][IRLIB_REJECT_RAW_COUNT] == 2
+    && irrejections.histogram[JVC][IRLIB_REJECT_RAW_COUNT] == 2, "histogram");
+
+  Got = receive(Receiver, Decoder, NEC, 0x61A0F00FUL, 0);
+  uint16_t Total = irrejections.total;
+  expect(Got && Decoder.decode() && Decoder.decode_type == NEC && irrejections.total == Total,
+    "a good frame records nothing");
+
+  IRrejections_clear();
+  expect(irrejections.total == 0 && irrejections.histogram[SONY][IRLIB_REJECT_RAW_COUNT] == 0, "clear");
+
+  IRhost_serialClear();
+  Decoder.rawlen = 30;
+  Decoder.decode();
+  IRrejections_dump();
+  printf("%s", IRhost_serialOutput());
+  Receiver.detachInterrupt();
+
+  return checkDone();
+}
@@ -0,0 +1,117 @@
+/* roundtrip.cpp - regression test for the IRLib host build
+ * Sends one code of every protocol that IRsend::send supports and checks that IRdecode gets
+ * the same protocol, value and bit count back. The carrier is looped back to the receiver pin
+ * so the frame goes through the real receiver state machines: first the 50us tick ISR of
+ * IRrecv, then the pin change handler of IRrecvPCI. Prints one line per protocol and receiver.
+ * Then, with ignoreSelfEcho left on, every frame sent must be dropped as our own, while the
+ * same frame from another remote must still come through. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <stdio.h>
+#include "check.h"
+
+#define RECV_PIN 2  //IRrecvPCI(0) uses the same pin on the virtual Uno
+
+struct Case {
+  IR_types_t type;      //protocol sent
+  unsigned long value;
+  unsigned int data2;   //bits for Sony and RC6, First for JVC
+  IR_types_t expect;    //protocol the decoder reports
+  unsigned char bits;   //bit count the decoder reports
+};
+
+static const Case Cases[] = {
+  {NEC,           0x61A0F00FUL, 0,  NEC,           32},
+  {SONY,          0x74BCAUL,    20, SONY,          20},
+  {SONY,          0x0A90UL,     12, SONY,          12},
+  {RC5,           0x1ABCUL,     0,  RC5,           13},
+  {RC6,           0x1F0C5UL,    20, RC6,           20},
+  {PANASONIC_OLD, 0x37AC81UL,   0,  PANASONIC_OLD, 22},
+  {JVC,           0xC0F8UL,     1,  JVC,           16},
+  {NECX,          0xE0E040BFUL, 0,  NECX,          32},
+  //Samsung32 has the same timing as NEC within the matching tolerance and NEC is tried first
+  {SAMSUNG32,     0xE0E09966UL, 0,  NEC,           32},
+  //PANASONIC_NEW is left out: its 100 entry frame does not fit the 99 the receivers keep of RAWBUF
+};
+#define CASE_COUNT (sizeof(Cases)/sizeof(Cases[0]))
+
+static void check(const char *receiver, const Case &c, bool got, IRdecode &d) {
+  bool Ok = got && d.decode() && d.decode_type == c.expect
+    && d.value == c.value && d.bits == c.bits;
+  if (!Ok) Failures++;
+  printf("%s %-8s %-13s sent %08lX got %-13s %08lX %2d bits\n", Ok ? "PASS" : "FAIL", receiver,
+    (const char *)Pnames(c.type), c.value, got ? (const char *)Pnames(d.decode_type) : "nothing",
+    got ? (unsigned long)d.value : 0UL, got ? d.bits : 0);
+}
+
+template<class R> static void run(const char *name, R &receiver) {
+  IRsend Sender;
+  IRdecode Decoder;
+  receiver.enableIRIn();
+  receiver.ignoreSelfEcho = false; //we want to hear ourselves
+  IRhost_loopback(RECV_PIN);
+  for (unsigned i = 0; i < CASE_COUNT; i++) {
+    IRhost_advance(50000);
+    Sender.send(Cases[i].type, Cases[i].value, Cases[i].data2, false);
+    IRhost_advance(50000);
+    check(name, Cases[i], receiver.getResults(&Decoder), Decoder);
+    receiver.resume();
+  }
+}
+
+//Plays a program on the receiver pin the way another remote would, without the echo log
+static void play(const IRpulseProgram &p) {
+  IRhost_loopback(255);
+  for (uint16_t i = 0; i < p.length; i++) {
+    IRhost_setPin(RECV_PIN, i & 1);
+    IRhost_advance(p.durations[i]);
+  }
+  IRhost_setPin(RECV_PIN, HIGH);
+  IRhost_loopback(RECV_PIN);
+}
+
+template<class R> static void echo(const char *name, R &receiver) {
+  IRsend Sender;
+  IRdecode Decoder;
+  receiver.ignoreSelfEcho = true;
+  uint16_t Dropped = receiver.selfEchoCount;
+  unsigned Heard = 0;
+  for (unsigned i = 0; i < CASE_COUNT; i++) {
+    IRhost_advance(50000);
+    Sender.send(Cases[i].type, Cases[i].value, Cases[i].data2, false);
+    IRhost_advance(50000);
+    Heard += receiver.getResults(&Decoder);
+    receiver.resume();
+  }
+  char What[64];
+  snprintf(What, sizeof(What), "%s drops all %u frames we sent", name, (unsigned)CASE_COUNT);
+  expect(!Heard && receiver.selfEchoCount - Dropped == CASE_COUNT, What);
+
+  uint16_t Buffer[2 * RAWBUF];
+  IRpulseProgram Program(Buffer, 2 * RAWBUF);
+  Sender.record(&Program);
+  Sender.send(RC5, 0x1ABCUL, 0, false);
+  Sender.record(NULL);
+  IRhost_advance(50000);
+  play(Program);
+  IRhost_advance(50000);
+  snprintf(What, sizeof(What), "%s hears another remote", name);
+  expect(receiver.getResults(&Decoder) && Decoder.decode() && Decoder.value == 0x1ABCUL, What);
+  receiver.resume();
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Tick(RECV_PIN);
+  run("IRrecv", Tick);
+  echo("IRrecv", Tick);
+  Tick.detachInterrupt();
+
+  IRhost_reset();
+  IRrecvPCI Edge(0);
+  run("IRrecvPCI", Edge);
+  echo("IRrecvPCI", Edge);
+  Edge.detachInterrupt();
+
+  return checkDone();
+}
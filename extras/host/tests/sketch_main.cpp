@@ -0,0 +1,21 @@
+/* sketch_main.cpp - runs an Arduino example sketch on the IRLib host build
+ * Calls setup() once and loop() SKETCH_LOOPS times with Serial echoed to stdout. The sketch
+ * itself is compiled through a generated wrapper that includes Arduino.h first, the way the
+ * Arduino IDE does.
+ */
+#include <Arduino.h>
+
+#ifndef SKETCH_LOOPS
+#define SKETCH_LOOPS 0
+#endif
+
+void setup(void);
+void loop(void);
+
+int main(void) {
+  IRhost_reset();
+  IRhost_serialEcho(true);
+  setup();
+  for (long i = 0; i < SKETCH_LOOPS; i++) loop();
+  return 0;
+}
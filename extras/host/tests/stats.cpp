@@ -0,0 +1,84 @@
+/* stats.cpp - regression test for the IRLIB_STATS counters (built against irlib_stats)
+ * Drives both receivers through the cases each counter is there for: a frame that is
+ * collected and decoded, a frame that arrives while a single-buffered receiver is paused,
+ * an over-long burst, a glitch shorter than MINIMUM_TIME_GAP_PERMITTED, and (IRrecvPCI) an
+ * end of frame that only the user's poll finds. Returns nonzero if anything failed.
+ */
+#include <IRLib.h>
+#include <IRLibMatch.h>
+#include <stdio.h>
+#include "check.h"
+
+#define RECV_PIN 2
+
+static irstats_t S;
+
+static void pulses(int marks, unsigned long mark, unsigned long space) {
+  for (int i = 0; i < marks; i++) {
+    IRhost_setPin(RECV_PIN, LOW);  IRhost_advance(mark);
+    IRhost_setPin(RECV_PIN, HIGH); IRhost_advance(space);
+  }
+}
+
+template<class R> static void run(const char *name, R &receiver) {
+  IRsend Sender;
+  IRdecode Decoder;
+  char What[80];
+  receiver.enableIRIn();
+  receiver.ignoreSelfEcho = false;
+  IRhost_loopback(RECV_PIN);
+
+  IRstats_clear();
+  IRhost_advance(50000);
+  Sender.send(NEC, 0x61A0F00FUL, 0, false);
+  IRhost_advance(50000);
+  bool Got = receiver.getResults(&Decoder) && Decoder.decode() && Decoder.decode_type == NEC;
+  receiver.resume();
+  IRstats_snapshot(&S);
+  snprintf(What, sizeof(What), "%s one frame: completed, decoded as NEC", name);
+  expect(Got && S.framesCompleted == 1 && S.decodeAttempts[NEC] == 1 && S.decodeSuccesses[NEC] == 1
+    && S.decodeAttempts[SONY] == 0 && S.endByISR + S.endByPoll == 1 && !S.overflows, What);
+
+  IRstats_clear();
+  Sender.send(SONY, 0x74BCAUL, 20, false);
+  Sender.send(NEC, 0x61A0F00FUL, 0, false);    //before anybody collects the Sony frame
+  IRhost_advance(50000);
+  Got = receiver.getResults(&Decoder) && Decoder.decode() && Decoder.decode_type == SONY;
+  receiver.resume();
+  IRstats_snapshot(&S);
+  snprintf(What, sizeof(What), "%s frame dropped while paused", name);
+  expect(Got && S.framesCompleted == 1 && S.framesDropped == 1 && S.decodeAttempts[NEC] == 1
+    && S.decodeSuccesses[SONY] == 1, What);
+
+  IRhost_loopback(255);
+  IRstats_clear();
+  IRhost_advance(50000);
+  pulses(70, 400, 400);                         //140 entries do not fit in RAWBUF
+  pulses(3, 600, 600);
+  IRhost_setPin(RECV_PIN, LOW); IRhost_advance(50);  //too short to be a mark
+  IRhost_setPin(RECV_PIN, HIGH); IRhost_advance(50000);
+  Got = receiver.getResults(&Decoder) && Decoder.rawlen == RAWBUF - 1;
+  receiver.resume();
+  IRstats_snapshot(&S);
+  snprintf(What, sizeof(What), "%s overflow and a glitch", name);
+  expect(Got && S.overflows > 0 && S.edgesRejected > 0 && S.framesCompleted == 1, What);
+  printf("     %s: overflows %u, edges rejected %u, end by ISR %u, by poll %u, max ISR cycles %u\n", name,
+    S.overflows, S.edgesRejected, S.endByISR, S.endByPoll, S.maxISRCycles);
+}
+
+int main(void) {
+  IRhost_reset();
+  IRrecv Tick(RECV_PIN);
+  run("IRrecv", Tick);
+  expect(S.endByISR == 1 && S.endByPoll == 0, "IRrecv ends every frame in the ISR");
+  Tick.detachInterrupt();
+
+  IRhost_reset();
+  IRrecvPCI Edge(0);
+  run("IRrecvPCI", Edge);
+  //no edge after the burst, so only the poll could see that it ended
+  expect(S.endByISR == 0 && S.endByPoll == 1, "IRrecvPCI end found by the poll");
+  Edge.detachInterrupt();
+
+  return checkDone();
+}
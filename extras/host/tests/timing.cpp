@@ -0,0 +1,80 @@
+/* timing.cpp - regression test for IRtimingStats
+ * Decodes NEC and Sony frames whose durations were moved by known amounts and checks the
+ * streaming mean, variance, range and worst deviation against the same numbers computed
+ * directly from all the samples. Returns nonzero if anything failed.
+ */
+#include "IRLibSim.h"
+#include <math.h>
+#include <algorithm>
+#include "check.h"
+
+static uint32_t Seed = 99;
+static int noise(int most) {Seed = Seed * 1664525 + 1013904223; return (int)((Seed >> 8) % (2*most + 1)) - most;}
+
+//Puts one frame of the sender's timings, each moved by noise, in the decoder
+static void load(IRdecode &d, IR_types_t type, uint32_t value, unsigned int data2, int most) {
+  std::vector<uint16_t> D = frame(type, value, data2);
+  for (size_t i = 1; i < D.size(); i++) D[i] += noise(most);
+  load(d, D);
+}
+
+int main(void) {
+  IRhost_reset();
+  IRdecode Decoder;
+  IRtimingStats Stats;
+  std::vector<double> Ones;   //the 1689us spaces of NEC, as the reference
+  unsigned Worst = 0;
+  bool Added = true;
+  for (int i = 0; i < 50; i++) {
+    load(Decoder, NEC, 0x61A0F00FUL ^ (i * 0x01010101UL), 0, 100);
+    Added = Added && Decoder.decode() && Stats.add(&Decoder);
+    for (uint16_t k = 1; k < Decoder.rawlen; k++) {
+      unsigned Nominal = k == 1 ? 563*16 : k == 2 ? 563*8 : (k % 2 || Decoder.rawbuf[k] < 1126) ? 563 : 563*3;
+      unsigned Off = abs((int)Decoder.rawbuf[k] - (int)Nominal);
+      if (Off > Worst) Worst = Off;
+      if (Nominal == 563*3) Ones.push_back(Decoder.rawbuf[k]);
+    }
+  }
+  double Mean = 0, Var = 0;
+  for (size_t i = 0; i < Ones.size(); i++) Mean += Ones[i];
+  Mean /= Ones.size();
+  for (size_t i = 0; i < Ones.size(); i++) Var += (Ones[i] - Mean) * (Ones[i] - Mean);
+  Var /= Ones.size() - 1;
+  const IRtimingClass &One = Stats.spaces[3]; //563*3 in the NEC row
+  printf("     NEC one spaces: n=%u mean %.2f (direct %.2f) variance %.1f (direct %.1f) range %u-%u\n",
+    One.count, One.mean, Mean, One.variance(), Var, One.low, One.high);
+  expect(Added && Stats.protocol == NEC && Stats.frames[NEC] == 50, "50 NEC frames added; classes follow NEC");
+  expect(One.nominal == 563*3 && One.count == Ones.size() && fabs(One.mean - Mean) < 0.01
+    && fabs(One.variance() - Var) / Var < 1e-4 && fabs(One.bias() - (Mean - 563*3)) < 0.01, "Welford mean and variance");
+  expect(One.low == *std::min_element(Ones.begin(), Ones.end()) && One.high == *std::max_element(Ones.begin(), Ones.end()),
+    "range");
+  expect(Stats.worst[NEC] == Worst && Stats.worstPercent[NEC] == Worst * 100 / 563, "worst deviation");
+  expect(Stats.marks[0].count == 50 && Stats.spaces[0].count == 0 && Stats.marks[3].count == 0, "header mark class");
+
+  //another protocol counts in the summary, not in the classes; the sender may be a us off nominal
+  load(Decoder, SONY, 0x74BCAUL, 20, 40);
+  expect(Decoder.decode() && Stats.add(&Decoder) && Stats.frames[SONY] == 1 && Stats.worst[SONY] <= 45
+    && Stats.marks[0].count == 50, "Sony frame in the summary only");
+
+  //a steady receiver shows little jitter, a noisy one more
+  IRtimingStats Quiet(NEC), Noisy(NEC);
+  for (int i = 0; i < 30; i++) {
+    load(Decoder, NEC, 0x61A0F00FUL, 0, 10);
+    Decoder.decode(); Quiet.add(&Decoder);
+    load(Decoder, NEC, 0x61A0F00FUL, 0, 120);
+    Decoder.decode(); Noisy.add(&Decoder);
+  }
+  printf("     jitter of NEC bit marks: quiet %.1f us, noisy %.1f us\n", Quiet.marks[4].jitter(), Noisy.marks[4].jitter());
+  expect(Quiet.marks[4].jitter() < 8 && Noisy.marks[4].jitter() > 50 && Noisy.worstPercent[NEC] > Quiet.worstPercent[NEC],
+    "jitter tells a noisy link from a quiet one");
+
+  Stats.clear();
+  expect(Stats.protocol == NEC && !Stats.frames[NEC] && !Stats.spaces[3].count && !Stats.worst[NEC], "clear");
+  Decoder.decode_type = HASH_CODE;
+  expect(!Stats.add(&Decoder) && !Stats.frames[HASH_CODE], "hash codes have no nominal timings");
+
+  IRhost_serialClear();
+  Noisy.dump();
+  printf("%s", IRhost_serialOutput());
+  return checkDone();
+}
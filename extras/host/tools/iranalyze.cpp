@@ -0,0 +1,62 @@
+/* iranalyze - works out the protocol of an unknown remote from recorded frames
+ *
+ *   iranalyze [-g gap_us] [-c] <trace or capture> ...
+ *       Reads edge traces (sim/IRLibSim.h) or binary captures (sim/IRLibCapture.h) of a few
+ *       presses of a few keys, and prints the header, encoding, bit count, repeat frame and
+ *       period it infers, the codes it saw, and the decodeGeneric and sendGeneric calls for the
+ *       protocol (sim/IRLibAnalyze.h). -g is the space that ends a frame in a trace (default
+ *       LONG_SPACE_US), -c also prints the mark and space clusters. Exits with 1 if the
+ *       encoding could not be worked out.
+ */
+#include "IRLibAnalyze.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int usage(void) {
+  fprintf(stderr, "usage: iranalyze [-g gap_us] [-c] <trace or capture> ...\n");
+  return 2;
+}
+
+static bool isCapture(const char *path) {
+  char Magic[4] = {0};
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  bool Capture = fread(Magic, 1, 4, f) == 4 && !memcmp(Magic, "IRCF", 4);
+  fclose(f);
+  return Capture;
+}
+
+int main(int argc, char **argv) {
+  uint32_t Gap = IR_ANALYZE_GAP;
+  bool Clusters = false;
+  std::vector<const char *> Paths;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-g") && i + 1 < argc) Gap = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-c")) Clusters = true;
+    else if (argv[i][0] == '-') return usage();
+    else Paths.push_back(argv[i]);
+  }
+  if (Paths.empty()) return usage();
+  std::vector<IRanalyzeFrame> Frames;
+  for (size_t p = 0; p < Paths.size(); p++) {
+    std::vector<IRanalyzeFrame> More;
+    if (isCapture(Paths[p])) {
+      IRcaptureFile File;
+      if (!File.open(Paths[p])) return 1;
+      More = IRanalyze_frames(File);
+    } else {
+      IRtrace Trace;
+      if (!Trace.load(Paths[p])) return 1;
+      More = IRanalyze_frames(Trace, Gap);
+    }
+    //each file starts a new press
+    uint64_t Offset = Frames.empty() ? 0 : Frames.back().end() + IR_ANALYZE_PRESS_GAP + 1;
+    for (size_t i = 0; i < More.size(); i++) {
+      More[i].start += Offset;
+      Frames.push_back(More[i]);
+    }
+  }
+  IRanalyzeResult R = IRanalyze(Frames);
+  R.print(stdout, Clusters);
+  return R.encoding == IR_ANALYZE_UNKNOWN ? 1 : 0;
+}
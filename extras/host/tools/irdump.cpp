@@ -0,0 +1,87 @@
+/* irdump - turns the binary stream of IRdump (IRLibDump.h) into text, CSV or a replay trace
+ *
+ *   irdump [-c] [-t trace] [-m mark_excess] [-b capture] [file]
+ *       Reads the stream captured from the Arduino's serial port from file, or from stdin.
+ *       Prints every record as text, or as CSV with -c. -t also writes the frames as an edge
+ *       trace for irreplay, with mark_excess (default MARK_EXCESS_DEFAULT) put back on the
+ *       marks. -b writes the frames to a binary capture (sim/IRLibCapture.h). A summary of
+ *       records, CRC errors and lost records goes to stderr.
+ *
+ * Capture with e.g. "stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > session.bin".
+ */
+#include "IRLibCapture.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int usage(void) {
+  fprintf(stderr, "usage: irdump [-c] [-t trace] [-m mark_excess] [-b capture] [file]\n");
+  return 2;
+}
+
+static void printText(const IRdumpRecord &r) {
+  if (r.type == IR_DUMP_FREQ) {
+    printf("#%u %lums frequency %.2f kHz from %u samples\n", r.seq, (unsigned long)r.millis, r.khz, r.samples);
+    return;
+  }
+  printf("#%u %lums %s %08lX %u bits, %u entries\n", r.seq, (unsigned long)r.millis,
+    IRsim_protocolName(r.protocol), (unsigned long)r.value, r.bits, (unsigned)r.raw.size());
+  //marks positive, spaces negative, the way most raw code tools write them
+  printf(" ");
+  for (size_t i = 0; i < r.raw.size(); i++) printf(" %s%u", i % 2 ? "" : "-", r.raw[i]);
+  printf("\n");
+}
+
+static void printCSV(const IRdumpRecord &r) {
+  printf("%u,%lu,%s,", r.seq, (unsigned long)r.millis, r.type == IR_DUMP_FREQ ? "freq" : "frame");
+  if (r.type == IR_DUMP_FREQ) {
+    printf(",,,%.2f,%u,\n", r.khz, r.samples);
+    return;
+  }
+  printf("%s,%08lX,%u,,,", IRsim_protocolName(r.protocol), (unsigned long)r.value, r.bits);
+  for (size_t i = 0; i < r.raw.size(); i++) printf("%s%u", i ? " " : "", r.raw[i]);
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  bool CSV = false;
+  const char *TracePath = NULL, *CapturePath = NULL, *Path = NULL;
+  int MarkExcess = MARK_EXCESS_DEFAULT;
+  IRcaptureWriter Capture;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-c")) CSV = true;
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) TracePath = argv[++i];
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc) MarkExcess = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc) CapturePath = argv[++i];
+    else if (argv[i][0] == '-' || Path) return usage();
+    else Path = argv[i];
+  }
+  FILE *f = Path ? fopen(Path, "rb") : stdin;
+  if (!f) {perror(Path); return 1;}
+  if (CapturePath && !Capture.open(CapturePath)) return 1;
+
+  IRdumpReader Reader;
+  IRdumpRecord Record;
+  std::vector<IRdumpRecord> Frames;
+  uint8_t Chunk[4096];
+  size_t n;
+  unsigned Records = 0;
+  if (CSV) printf("seq,millis,type,protocol,value,bits,khz,samples,raw\n");
+  while ((n = fread(Chunk, 1, sizeof(Chunk), f)) > 0) {
+    Reader.feed(Chunk, n);
+    while (Reader.next(Record)) {
+      Records++;
+      if (CSV) printCSV(Record); else printText(Record);
+      if (TracePath && Record.type == IR_DUMP_FRAME) Frames.push_back(Record);
+      if (CapturePath) Capture.add(Record);
+    }
+  }
+  if (f != stdin) fclose(f);
+  fprintf(stderr, "%u records, %u CRC errors, %u lost\n", Records, Reader.crcErrors, Reader.lost);
+  if (CapturePath && !Capture.close()) return 1;
+  if (TracePath) {
+    IRtrace Trace;
+    IRdump_toTrace(Frames, Trace, MarkExcess);
+    if (!Trace.save(TracePath)) return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+/* irreplay - record and replay IR edge traces on the IRLib host build
+ *
+ *   irreplay record <trace> [-g gap_us] [-n times] <protocol>:<hex>[:<data2>] ...
+ *       Sends each code with IRsend::send (data2 is the bit count for Sony and RC6, First for
+ *       JVC) and writes the edges and frames to <trace>. -g is the silence before every frame
+ *       (default 50000), -n sends the whole list that many times.
+ *   irreplay run <trace> [-r irrecv|pci] [-p poll_us] [-b busy_us] [-m mark_excess] [-d] [-v] [-o capture]
+ *       Replays <trace> into IRrecv (default) or IRrecvPCI. The main loop polls getResults every
+ *       poll_us (default 1000), and after each frame it is busy for busy_us before resume().
+ *       -d gives the decoder a second buffer. -v prints every frame. Prints loss and latency.
+ *       -o writes every frame getResults returned to a binary capture (sim/IRLibCapture.h).
+ *
+ * See sim/IRLibSim.h for the trace format.
+ */
+#include "IRLibSim.h"
+#include "IRLibCapture.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static int usage(void) {
+  fprintf(stderr, "usage: irreplay record <trace> [-g gap_us] [-n times] <protocol>:<hex>[:<data2>] ...\n"
+                  "       irreplay run <trace> [-r irrecv|pci] [-p poll_us] [-b busy_us] [-m mark_excess] [-d] [-v] [-o capture]\n");
+  return 2;
+}
+
+static int record(int argc, char **argv) {
+  IRtrace Trace;
+  uint32_t Gap = 50000;
+  long Times = 1;
+  std::vector<const char *> Codes;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-g") && i + 1 < argc) Gap = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) Times = strtol(argv[++i], NULL, 0);
+    else Codes.push_back(argv[i]);
+  }
+  if (Codes.empty()) return usage();
+  IRhost_reset();
+  for (long n = 0; n < Times; n++) {
+    for (size_t i = 0; i < Codes.size(); i++) {
+      std::string Code(Codes[i]);
+      size_t Colon = Code.find(':');
+      if (Colon == std::string::npos) return usage();
+      IR_types_t Type = IRsim_protocol(Code.substr(0, Colon).c_str());
+      if (Type == UNKNOWN || Type == HASH_CODE) {
+        fprintf(stderr, "irreplay: unknown protocol in %s\n", Codes[i]);
+        return 2;
+      }
+      char *End;
+      unsigned long Value = strtoul(Code.c_str() + Colon + 1, &End, 16);
+      unsigned long Data2 = (*End == ':') ? strtoul(End + 1, NULL, 0) : 0;
+      Trace.send(Type, Value, Data2, Gap);
+    }
+  }
+  return Trace.save(argv[0]) ? 0 : 1;
+}
+
+static int run(int argc, char **argv) {
+  IRtrace Trace;
+  IRreplayOptions Options;
+  IRcaptureWriter Capture;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+      i++;
+      if (!strcmp(argv[i], "irrecv")) Options.receiver = IR_SIM_IRRECV;
+      else if (!strcmp(argv[i], "pci")) Options.receiver = IR_SIM_IRRECVPCI;
+      else return usage();
+    }
+    else if (!strcmp(argv[i], "-p") && i + 1 < argc) Options.pollUs = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-b") && i + 1 < argc) Options.busyUs = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc) Options.markExcess = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-d")) Options.doubleBuffer = true;
+    else if (!strcmp(argv[i], "-v")) Options.verbose = true;
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+      if (!Capture.open(argv[++i])) return 1;
+      Options.capture = &Capture;
+    }
+    else return usage();
+  }
+  if (!Options.pollUs) Options.pollUs = 1;
+  if (!Trace.load(argv[0])) return 1;
+  IRreplay(Trace, Options).print(stdout);
+  if (Options.capture && !Capture.close()) return 1;
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) return usage();
+  if (!strcmp(argv[1], "record")) return record(argc - 2, argv + 2);
+  if (!strcmp(argv[1], "run")) return run(argc - 2, argv + 2);
+  return usage();
+}